@@ -1,6 +1,13 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 #include "baza.h"
 #include "phone_forward.h"
+#include "phone_forward_snapshot.h"
 
 
 #define SIZE    20
@@ -43,12 +50,15 @@ PfList * createMainBaseElement(char *name, bool *memoryProblems) {
     struct PhoneForward *newPf = phfwdNew();
 
     // wystąpiły problemy z alokacją pamięci.
-    if (newPf == NULL || new == NULL) {
+    if (newPf == NULL || new == NULL || (name != NULL && !phfwdEnableResultCache(newPf, BASE_RESULT_CACHE))) {
+        phfwdDelete(newPf);
+        free(new);
         (*memoryProblems) = true;
         return NULL;
     }
 
     new->pf = newPf;
+    new->frozen = NULL;
     new->baseName = name;
     new->next = NULL;
 
@@ -68,6 +78,9 @@ void deleteSingleBase(PfList *temp) {
         phfwdDelete(temp->pf);
     temp->pf = NULL;
 
+    phfwdFrozenDelete(temp->frozen);
+    temp->frozen = NULL;
+
     free(temp);
 }
 
@@ -82,3 +95,186 @@ void deleteWholeBase(PfList *base) {
         }
     }
 }
+
+
+bool thawBase(PfList *temp, bool *memoryProblems) {
+    if (temp->pf != NULL)
+        return true;
+
+    temp->pf = phfwdThaw(temp->frozen);
+
+    // wystąpiły problemy z alokacją pamięci.
+    if (temp->pf == NULL || !phfwdEnableResultCache(temp->pf, BASE_RESULT_CACHE)) {
+        phfwdDelete(temp->pf);
+        temp->pf = NULL;
+        (*memoryProblems) = true;
+        return false;
+    }
+
+    phfwdFrozenDelete(temp->frozen);
+    temp->frozen = NULL;
+
+    return true;
+}
+
+
+/** @brief Zapisuje pojedynczą bazę przekierowań.
+ * @param[in] temp - wskaźnik na bazę;
+ * @param[in] file - plik otwarty do zapisu binarnego.
+ * @return Wartość @p true, jeśli zapis się udał.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool saveSingleBase(PfList *temp, FILE *file) {
+    BaseEntryHeader entry;
+
+    entry.nameLength = (uint32_t) strlen(temp->baseName);
+    entry.unused = 0;
+
+    if (fwrite(&entry, sizeof(BaseEntryHeader), 1, file) != 1
+        || fwrite(temp->baseName, 1, entry.nameLength, file) != entry.nameLength
+        || !snapshotPad(file, entry.nameLength))
+        return false;
+
+    // baza odwzorowana z pliku jest już zamrożona.
+    if (temp->pf == NULL)
+        return phfwdSnapshotWrite(temp->frozen, file);
+
+    struct PhfwdFrozen *frozen = phfwdFreeze(temp->pf);
+    bool result = phfwdSnapshotWrite(frozen, file);
+
+    phfwdFrozenDelete(frozen);
+
+    return result;
+}
+
+
+bool saveBases(PfList *base, char const *path) {
+    if (base == NULL || path == NULL)
+        return false;
+
+    BasesHeader header;
+
+    memset(&header, 0, sizeof(BasesHeader));
+    memcpy(header.magic, BASES_MAGIC, sizeof(header.magic));
+    header.version = BASES_VERSION;
+
+    // atrapa na początku nie ma nazwy i nie jest zapisywana.
+    for (PfList *temp = base->next; temp != NULL; temp = temp->next) {
+        if (temp->baseName != NULL)
+            header.baseCount++;
+    }
+
+    char *tempPath;
+    FILE *file = snapshotCreate(path, &tempPath);
+
+    if (file == NULL)
+        return false;
+
+    bool written = fwrite(&header, sizeof(BasesHeader), 1, file) == 1;
+
+    for (PfList *temp = base->next; written && temp != NULL; temp = temp->next) {
+        if (temp->baseName != NULL)
+            written = saveSingleBase(temp, file);
+    }
+
+    return snapshotCommit(file, tempPath, path, written);
+}
+
+
+/** @brief Odwzorowuje pojedynczą bazę przekierowań z pliku.
+ * @param[in] fd - deskryptor pliku;
+ * @param[in] fileSize - rozmiar pliku;
+ * @param[in] offset - adres zmiennej z położeniem zapisu bazy w pliku,
+ *            przesuwanym za odczytaną bazę;
+ * @param[in] memoryProblems - wskażnik na zmienną, przechowującą informację o tym,
+ *            czy wystąpiły problemy z alokacją pamięci.
+ * @return wskaźnik na nowo utworzony element struktury baz lub NULL,
+ *         gdy zapis jest uszkodzony lub wystąpiły problemy z alokacją pamięci.
+ */
+static PfList * openSingleBase(int fd, uint64_t fileSize, uint64_t *offset, bool *memoryProblems) {
+    BaseEntryHeader entry;
+
+    if (pread(fd, &entry, sizeof(BaseEntryHeader), (off_t) (*offset)) != (ssize_t) sizeof(BaseEntryHeader))
+        return NULL;
+
+    (*offset) += sizeof(BaseEntryHeader);
+
+    // nazwa niemieszcząca się w pliku oznacza uszkodzony zapis.
+    if ((*offset) > fileSize || entry.nameLength > fileSize - (*offset))
+        return NULL;
+
+    PfList *new = malloc(sizeof(PfList));
+    char *name = malloc(entry.nameLength + 1);
+
+    // wystąpiły problemy z alokacją pamięci.
+    if (new == NULL || name == NULL) {
+        (*memoryProblems) = true;
+        free(new);
+        free(name);
+        return NULL;
+    }
+
+    new->pf = NULL;
+    new->frozen = NULL;
+    new->baseName = name;
+    new->next = NULL;
+
+    if (pread(fd, name, entry.nameLength, (off_t) (*offset)) != (ssize_t) entry.nameLength) {
+        deleteSingleBase(new);
+        return NULL;
+    }
+
+    name[entry.nameLength] = '\0';
+    (*offset) += (entry.nameLength + SNAPSHOT_ALIGN - 1) / SNAPSHOT_ALIGN * SNAPSHOT_ALIGN;
+
+    uint64_t size;
+    new->frozen = phfwdSnapshotMap(fd, (*offset), &size);
+
+    if (new->frozen == NULL) {
+        deleteSingleBase(new);
+        return NULL;
+    }
+
+    (*offset) += size;
+
+    return new;
+}
+
+
+PfList * openBases(char const *path, bool *memoryProblems) {
+    if (path == NULL)
+        return NULL;
+
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0)
+        return NULL;
+
+    BasesHeader header;
+    struct stat info;
+    PfList *base = NULL;
+
+    if (fstat(fd, &info) == 0 && pread(fd, &header, sizeof(BasesHeader), 0) == (ssize_t) sizeof(BasesHeader)
+        && memcmp(header.magic, BASES_MAGIC, sizeof(header.magic)) == 0 && header.version == BASES_VERSION)
+        base = createMainBaseElement(NULL, memoryProblems);
+
+    PfList *last = base;
+    uint64_t offset = sizeof(BasesHeader);
+
+    // bazy są dołączane na koniec, więc zachowują kolejność z pliku.
+    for (uint32_t i = 0; last != NULL && i < header.baseCount; i++) {
+        last->next = openSingleBase(fd, (uint64_t) info.st_size, &offset, memoryProblems);
+        last = last->next;
+    }
+
+    // odwzorowania pozostają ważne po zamknięciu pliku.
+    close(fd);
+
+    // plik jest uszkodzony lub wystąpiły problemy z alokacją pamięci.
+    if (base != NULL && last == NULL) {
+        deleteWholeBase(base);
+        return NULL;
+    }
+
+    return base;
+}
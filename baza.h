@@ -2,6 +2,14 @@
 #define _BAZA_H
 
 #include <stdbool.h>
+#include <stdint.h>
+
+/// Znacznik początku pliku z zapisem wszystkich baz przekierowań.
+#define BASES_MAGIC     "PFWDLIST"
+/// Wersja formatu pliku z zapisem baz.
+#define BASES_VERSION   1
+/// Liczba wyników zapytań zapamiętywanych przez każdą bazę.
+#define BASE_RESULT_CACHE   1024
 
 
 
@@ -27,10 +35,38 @@ typedef struct pfList PfList;
 
 struct pfList{
     struct PhoneForward *pf;
+    struct PhfwdFrozen *frozen; // baza odwzorowana z pliku, NULL gdy pf nie jest nullem.
     char *baseName;
     PfList* next;
 };
 
+/**
+ * Nagłówek pliku z zapisem baz przekierowań. Po nim leżą kolejne bazy:
+ * nagłówek bazy, jej nazwa dopełniona zerami do wielokrotności 8 bajtów
+ * i zapis jej przekierowań (zob. phone_forward_snapshot.h).
+ */
+struct basesHeader;
+
+typedef struct basesHeader BasesHeader;
+
+struct basesHeader {
+    char magic[8]; // znacznik BASES_MAGIC.
+    uint32_t version; // wersja formatu.
+    uint32_t baseCount; // liczba zapisanych baz.
+};
+
+/**
+ * Nagłówek zapisu pojedynczej bazy.
+ */
+struct baseEntryHeader;
+
+typedef struct baseEntryHeader BaseEntryHeader;
+
+struct baseEntryHeader {
+    uint32_t nameLength; // długość nazwy bazy.
+    uint32_t unused; // wyrównanie do 8 bajtów.
+};
+
 
 /** @brief Tworzy pojedynczy element struktury baz przekierowań.
  * @param[in] name - wskażnik na tablicę przechowującą nazwę bazy;
@@ -53,6 +89,41 @@ void deleteWholeBase(PfList *base);
 void deleteSingleBase(PfList *temp);
 
 
+/** @brief Zapisuje wszystkie bazy przekierowań do pliku.
+ * Zapis trafia najpierw do pliku tymczasowego, który zastępuje plik
+ * @p path dopiero po utrwaleniu na dysku.
+ * @param[in] base - wskaźnik na strukturę przechowującą bazy przekierowań;
+ * @param[in] path - ścieżka pliku.
+ * @return Wartość @p true, jeśli zapis się udał.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool saveBases(PfList *base, char const *path);
+
+
+/** @brief Otwiera bazy przekierowań zapisane funkcją saveBases.
+ * Bazy są odwzorowywane z pliku w pamięć, bez wczytywania przekierowań,
+ * i zachowują swoją kolejność.
+ * @param[in] path - ścieżka pliku;
+ * @param[in] memoryProblems - wskażnik na zmienną, przechowującą informację o tym,
+ *            czy wystąpiły problemy z alokacją pamięci.
+ * @return wskaźnik na strukturę baz przekierowań, z atrapą na początku,
+ *         lub NULL, gdy nie udało się otworzyć pliku lub jest on niezgodny.
+ */
+PfList * openBases(char const *path, bool *memoryProblems);
+
+
+/** @brief Przygotowuje bazę do modyfikacji.
+ * Baza odwzorowana z pliku jest przepisywana do modyfikowalnej struktury,
+ * a odwzorowanie usuwane.
+ * @param[in] temp - wskaźnik na bazę;
+ * @param[in] memoryProblems - wskażnik na zmienną, przechowującą informację o tym,
+ *            czy wystąpiły problemy z alokacją pamięci.
+ * @return Wartość @p true, jeśli bazę można modyfikować.
+ *         Wartość @p false w przypadku problemów z alokacją pamięci.
+ */
+bool thawBase(PfList *temp, bool *memoryProblems);
+
+
 /** @brief Tworzy nowy element struktury instruction, pojedynczy leksem.
  * @param[in] nam - wskażnik na tablicę zwierającą nazwę leksemu;
  * @param[in] counter - numer bajtu pierwszego wczytanego znaku danego leksemu;
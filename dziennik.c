@@ -0,0 +1,423 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "dziennik.h"
+#include "parser.h"
+
+
+/// Tablica reszt CRC-32 dla kolejnych bajtów.
+static uint32_t crcTable[256];
+
+/// Informacja o tym, czy tablica crcTable została już wypełniona.
+static bool crcReady = false;
+
+
+/** @brief Wypełnia tablicę reszt CRC-32, jeśli nie zrobiono tego wcześniej.
+ */
+static void initCrc(void) {
+    if (crcReady)
+        return;
+
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+
+        for (int k = 0; k < 8; k++)
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+
+        crcTable[i] = c;
+    }
+
+    crcReady = true;
+}
+
+
+/** @brief Uwzględnia kolejne dane w sumie kontrolnej CRC-32.
+ * @param[in] c - suma kontrolna poprzednich danych przed ostatnią negacją,
+ *            0xFFFFFFFF na początku;
+ * @param[in] data - wskaźnik na dane;
+ * @param[in] length - długość danych.
+ * @return Sumę kontrolną wszystkich danych przed ostatnią negacją.
+ */
+static uint32_t updateChecksum(uint32_t c, char const *data, size_t length) {
+    for (size_t i = 0; i < length; i++)
+        c = crcTable[(c ^ (uint8_t) data[i]) & 0xFF] ^ (c >> 8);
+
+    return c;
+}
+
+
+/** @brief Oblicza sumę kontrolną CRC-32.
+ * @param[in] data - wskaźnik na dane;
+ * @param[in] length - długość danych.
+ * @return Sumę kontrolną danych.
+ */
+static uint32_t checksum(char const *data, size_t length) {
+    return updateChecksum(0xFFFFFFFFu, data, length) ^ 0xFFFFFFFFu;
+}
+
+
+/** @brief Zapisuje cały bufor do pliku, ponawiając przerwane zapisy.
+ * @param[in] fd - deskryptor pliku;
+ * @param[in] data - wskaźnik na dane;
+ * @param[in] length - długość danych.
+ * @return Wartość @p true, jeśli zapisano wszystkie dane.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool writeAll(int fd, char const *data, size_t length) {
+    while (length > 0) {
+        ssize_t n = write(fd, data, length);
+
+        if (n < 0 && errno == EINTR)
+            continue;
+
+        if (n <= 0)
+            return false;
+
+        data += n;
+        length -= (size_t) n;
+    }
+
+    return true;
+}
+
+
+/** @brief Wyznacza chwilę, do której wątek utrwalający zbiera wpisy grupy.
+ * @param[out] deadline - chwila oddalona o JOURNAL_COMMIT_MS od teraz.
+ */
+static void commitDeadline(struct timespec *deadline) {
+    clock_gettime(CLOCK_REALTIME, deadline);
+    deadline->tv_nsec += JOURNAL_COMMIT_MS * 1000000L;
+
+    if (deadline->tv_nsec >= 1000000000L) {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000L;
+    }
+}
+
+
+/** @brief Funkcja wątku utrwalającego wpisy.
+ * Czeka na pierwszy wpis grupy, zbiera kolejne do JOURNAL_COMMIT_MS
+ * milisekund lub JOURNAL_BATCH bajtów, po czym zapisuje całą grupę
+ * i utrwala ją jednym wywołaniem fdatasync.
+ * @param[in] arg - wskaźnik na dziennik.
+ * @return NULL.
+ */
+static void * flushJournal(void *arg) {
+    Journal *journal = arg;
+
+    pthread_mutex_lock(&journal->lock);
+
+    while (true) {
+        journal->idle = true;
+
+        while (journal->used == 0 && !journal->stop)
+            pthread_cond_wait(&journal->wake, &journal->lock);
+
+        journal->idle = false;
+
+        if (journal->used == 0)
+            break;
+
+        struct timespec deadline;
+        commitDeadline(&deadline);
+
+        // zbieranie wpisów grupy.
+        while (journal->used < JOURNAL_BATCH && !journal->stop
+               && pthread_cond_timedwait(&journal->wake, &journal->lock, &deadline) == 0);
+
+        // zapisujemy grupę bez blokady, nowe wpisy trafiają do drugiego bufora.
+        char *group = journal->buffer;
+        size_t groupSize = journal->used;
+        size_t groupCapacity = journal->capacity;
+
+        journal->buffer = journal->spare;
+        journal->capacity = journal->spareCapacity;
+        journal->used = 0;
+
+        pthread_mutex_unlock(&journal->lock);
+
+        bool ok = writeAll(journal->fd, group, groupSize) && fdatasync(journal->fd) == 0;
+
+        pthread_mutex_lock(&journal->lock);
+
+        journal->spare = group;
+        journal->spareCapacity = groupCapacity;
+        journal->durable += groupSize;
+
+        if (!ok)
+            journal->failed = true;
+
+        pthread_cond_broadcast(&journal->synced);
+    }
+
+    pthread_mutex_unlock(&journal->lock);
+
+    return NULL;
+}
+
+
+Journal * journalOpen(char const *path) {
+    if (path == NULL)
+        return NULL;
+
+    Journal *journal = malloc(sizeof(Journal));
+
+    // problem z alokacją pamięci.
+    if (journal == NULL)
+        return NULL;
+
+    initCrc();
+    memset(journal, 0, sizeof(Journal));
+    journal->fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+
+    if (journal->fd < 0) {
+        free(journal);
+        return NULL;
+    }
+
+    pthread_mutex_init(&journal->lock, NULL);
+    pthread_cond_init(&journal->wake, NULL);
+    pthread_cond_init(&journal->synced, NULL);
+
+    if (pthread_create(&journal->flusher, NULL, flushJournal, journal) != 0) {
+        pthread_mutex_destroy(&journal->lock);
+        pthread_cond_destroy(&journal->wake);
+        pthread_cond_destroy(&journal->synced);
+        close(journal->fd);
+        free(journal);
+        return NULL;
+    }
+
+    // operacje tej sesji dotyczą baz wybranych od nowa.
+    if (!journalAppend(journal, JOURNAL_START, NULL, NULL)) {
+        journalClose(journal);
+        return NULL;
+    }
+
+    return journal;
+}
+
+
+bool journalAppend(Journal *journal, uint8_t type, char const *arg1, char const *arg2) {
+    if (journal == NULL)
+        return true;
+
+    char kind = (char) type;
+    size_t length1 = arg1 != NULL ? strlen(arg1) + 1 : 0;
+    size_t length2 = arg2 != NULL ? strlen(arg2) + 1 : 0;
+    size_t length = 1 + length1 + length2;
+    size_t size = sizeof(JournalRecord) + length;
+    JournalRecord header;
+
+    // nagłówek jest wyznaczany bez blokady, pod nią wpis jest tylko kopiowany.
+    header.length = (uint32_t) length;
+    header.checksum = updateChecksum(0xFFFFFFFFu, &kind, 1);
+    header.checksum = updateChecksum(header.checksum, arg1, length1);
+    header.checksum = updateChecksum(header.checksum, arg2, length2) ^ 0xFFFFFFFFu;
+
+    pthread_mutex_lock(&journal->lock);
+
+    // wątek utrwalający nie nadąża, czekamy na utrwalenie starszych wpisów,
+    // także tych, które właśnie zapisuje.
+    while (journal->appended > journal->durable && journal->appended - journal->durable + size > JOURNAL_MAX_PENDING
+           && !journal->failed)
+        pthread_cond_wait(&journal->synced, &journal->lock);
+
+    // wcześniejsze wpisy nie trafiły na dysk, operacji nie można wykonać.
+    if (journal->failed) {
+        pthread_mutex_unlock(&journal->lock);
+        return false;
+    }
+
+    if (journal->used + size > journal->capacity) {
+        size_t newCapacity = journal->capacity == 0 ? JOURNAL_BATCH : 2 * journal->capacity;
+
+        while (newCapacity < journal->used + size)
+            newCapacity *= 2;
+
+        char *newBuffer = realloc(journal->buffer, newCapacity);
+
+        // problem z alokacją pamięci.
+        if (newBuffer == NULL) {
+            pthread_mutex_unlock(&journal->lock);
+            return false;
+        }
+
+        journal->buffer = newBuffer;
+        journal->capacity = newCapacity;
+    }
+
+    char *record = journal->buffer + journal->used;
+
+    memcpy(record, &header, sizeof(JournalRecord));
+    record[sizeof(JournalRecord)] = kind;
+
+    if (arg1 != NULL)
+        memcpy(record + sizeof(JournalRecord) + 1, arg1, length1);
+
+    if (arg2 != NULL)
+        memcpy(record + sizeof(JournalRecord) + 1 + length1, arg2, length2);
+
+    // wątek utrwalający budzimy tylko wtedy, gdy czeka na pierwszy wpis grupy
+    // lub gdy grupa właśnie się zapełniła, a nie przy każdym wpisie.
+    if ((journal->used == 0 && journal->idle) || (journal->used < JOURNAL_BATCH && journal->used + size >= JOURNAL_BATCH))
+        pthread_cond_signal(&journal->wake);
+
+    journal->used += size;
+    journal->appended += size;
+
+    pthread_mutex_unlock(&journal->lock);
+
+    return true;
+}
+
+
+bool journalSync(Journal *journal) {
+    pthread_mutex_lock(&journal->lock);
+
+    uint64_t target = journal->appended;
+
+    pthread_cond_signal(&journal->wake);
+
+    while (journal->durable < target && !journal->failed)
+        pthread_cond_wait(&journal->synced, &journal->lock);
+
+    bool result = !journal->failed;
+
+    pthread_mutex_unlock(&journal->lock);
+
+    return result;
+}
+
+
+bool journalReset(Journal *journal) {
+    if (!journalSync(journal))
+        return false;
+
+    pthread_mutex_lock(&journal->lock);
+
+    // wszystkie wpisy są utrwalone, więc wątek utrwalający nie pisze do pliku.
+    bool result = ftruncate(journal->fd, 0) == 0 && fsync(journal->fd) == 0;
+
+    if (!result)
+        journal->failed = true;
+
+    pthread_mutex_unlock(&journal->lock);
+
+    return result && journalAppend(journal, JOURNAL_START, NULL, NULL);
+}
+
+
+bool journalClose(Journal *journal) {
+    if (journal == NULL)
+        return true;
+
+    bool result = journalSync(journal);
+
+    pthread_mutex_lock(&journal->lock);
+    journal->stop = true;
+    pthread_cond_signal(&journal->wake);
+    pthread_mutex_unlock(&journal->lock);
+
+    pthread_join(journal->flusher, NULL);
+    pthread_mutex_destroy(&journal->lock);
+    pthread_cond_destroy(&journal->wake);
+    pthread_cond_destroy(&journal->synced);
+
+    if (close(journal->fd) != 0)
+        result = false;
+
+    free(journal->buffer);
+    free(journal->spare);
+    free(journal);
+
+    return result;
+}
+
+
+/** @brief Odczytuje kolejny wpis dziennika.
+ * @param[in] file - plik dziennika;
+ * @param[in] remaining - liczba bajtów do końca pliku;
+ * @param[in,out] data - adres bufora na treść wpisu, powiększanego w razie potrzeby;
+ * @param[in,out] capacity - rozmiar bufora data;
+ * @param[out] length - długość treści wpisu;
+ * @param[in] memoryProblems - wskażnik na zmienną, przechowującą informację o tym,
+ *            czy wystąpiły problemy z alokacją pamięci.
+ * @return Wartość @p true, jeśli odczytano cały poprawny wpis.
+ *         Wartość @p false na końcu pliku lub przy niepełnym albo uszkodzonym wpisie.
+ */
+static bool readRecord(FILE *file, long remaining, char **data, size_t *capacity, size_t *length, bool *memoryProblems) {
+    JournalRecord header;
+
+    // wpis przerwany przez awarię może mieć dowolną długość.
+    if (fread(&header, sizeof(JournalRecord), 1, file) != 1 || header.length == 0
+        || header.length > (unsigned long) remaining - sizeof(JournalRecord))
+        return false;
+
+    if (header.length > (*capacity)) {
+        char *newData = realloc((*data), header.length);
+
+        // problem z alokacją pamięci.
+        if (newData == NULL) {
+            (*memoryProblems) = true;
+            return false;
+        }
+
+        (*data) = newData;
+        (*capacity) = header.length;
+    }
+
+    (*length) = header.length;
+
+    // argumenty, jeśli są, muszą być zakończone znakiem '\0'.
+    return fread((*data), 1, header.length, file) == header.length
+           && (header.length == 1 || (*data)[header.length - 1] == '\0')
+           && checksum((*data), header.length) == header.checksum;
+}
+
+
+bool journalReplay(char const *path, PfList *base, bool *memoryProblems) {
+    FILE *file = fopen(path, "rb");
+
+    // brak pliku oznacza pusty dziennik.
+    if (file == NULL)
+        return errno == ENOENT;
+
+    initCrc();
+
+    PfList *actual = NULL;
+    char *data = NULL;
+    size_t capacity = 0;
+    size_t length;
+    long valid = 0;
+    long size = fseek(file, 0, SEEK_END) == 0 ? ftell(file) : -1;
+
+    if (size < 0 || fseek(file, 0, SEEK_SET) != 0) {
+        fclose(file);
+        return false;
+    }
+
+    while (!(*memoryProblems) && size - valid >= (long) sizeof(JournalRecord)
+           && readRecord(file, size - valid, &data, &capacity, &length, memoryProblems)) {
+        char *arg1 = length > 1 ? data + 1 : NULL;
+        char *arg2 = arg1 != NULL && strlen(arg1) + 2 < length ? arg1 + strlen(arg1) + 1 : NULL;
+
+        replayOperation((uint8_t) data[0], arg1, arg2, &actual, base, memoryProblems);
+        valid = ftell(file);
+    }
+
+    free(data);
+    fclose(file);
+
+    if (*memoryProblems)
+        return false;
+
+    // obcięcie wpisu przerwanego przez awarię, by kolejne wpisy trafiły za poprawne.
+    return valid == size || truncate(path, valid) == 0;
+}
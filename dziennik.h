@@ -0,0 +1,135 @@
+/** @file
+ * Interfejs dziennika operacji na bazach przekierowań
+ *
+ * Dziennik zapisuje w postaci binarnej operacje zmieniające bazy, zanim
+ * zostaną wykonane. Po awarii bazy odtwarza się, otwierając ostatni zapis
+ * baz i powtarzając operacje z dziennika. Wpisy trafiają na dysk grupami:
+ * osobny wątek utrwala je, gdy zbierze się ich dość dużo lub minie
+ * JOURNAL_COMMIT_MS od pierwszego nieutrwalonego wpisu, więc dopisanie
+ * wpisu nie czeka na dysk.
+ */
+
+#ifndef _DZIENNIK_H
+#define _DZIENNIK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "baza.h"
+
+/// Początek sesji: kolejne operacje dotyczą baz wybranych od nowa.
+#define JOURNAL_START       1
+/// Utworzenie lub wybranie bazy (NEW nazwa).
+#define JOURNAL_NEW         2
+/// Usunięcie bazy (DEL nazwa).
+#define JOURNAL_DEL_BASE    3
+/// Dodanie przekierowania (num1 > num2).
+#define JOURNAL_ADD         4
+/// Usunięcie przekierowań (DEL num).
+#define JOURNAL_REMOVE      5
+
+/// Liczba bajtów wpisów, po której zebraniu są one utrwalane bez czekania.
+#define JOURNAL_BATCH       (1u << 16)
+/// Liczba bajtów nieutrwalonych wpisów, powyżej której dopisywanie czeka na dysk.
+#define JOURNAL_MAX_PENDING (1u << 22)
+/// Najdłuższy czas w milisekundach, przez jaki wpis czeka na utrwalenie.
+#define JOURNAL_COMMIT_MS   10
+
+/**
+ * Nagłówek wpisu dziennika. Po nim leży treść wpisu: rodzaj operacji
+ * i jej argumenty, każdy zakończony znakiem '\0'.
+ */
+struct journalRecord;
+
+typedef struct journalRecord JournalRecord;
+
+struct journalRecord {
+    uint32_t length; // długość treści wpisu.
+    uint32_t checksum; // suma kontrolna CRC-32 treści wpisu.
+};
+
+/**
+ * Dziennik otwarty do dopisywania.
+ */
+struct journal;
+
+typedef struct journal Journal;
+
+struct journal {
+    int fd; // deskryptor pliku dziennika.
+    pthread_mutex_t lock; // blokada pól poniżej.
+    pthread_cond_t wake; // budzi wątek utrwalający.
+    pthread_cond_t synced; // sygnalizuje utrwalenie kolejnej grupy wpisów.
+    char *buffer; // wpisy czekające na zapis.
+    size_t used; // liczba bajtów w buforze buffer.
+    size_t capacity; // rozmiar bufora buffer.
+    char *spare; // bufor zapisywany przez wątek utrwalający.
+    size_t spareCapacity; // rozmiar bufora spare.
+    uint64_t appended; // liczba bajtów dopisanych do dziennika.
+    uint64_t durable; // liczba bajtów utrwalonych na dysku.
+    bool failed; // czy zapis na dysk się nie udał.
+    bool idle; // czy wątek utrwalający czeka na pierwszy wpis grupy.
+    bool stop; // czy wątek utrwalający ma się zakończyć.
+    pthread_t flusher; // wątek utrwalający.
+};
+
+/** @brief Otwiera dziennik do dopisywania.
+ * Tworzy plik, jeśli nie istnieje, i dopisuje wpis początku sesji.
+ * @param[in] path - ścieżka pliku dziennika.
+ * @return Wskaźnik na dziennik lub NULL, gdy nie udało się go otworzyć.
+ */
+Journal * journalOpen(char const *path);
+
+/** @brief Dopisuje operację do dziennika.
+ * Wpis zostanie utrwalony najpóźniej po JOURNAL_COMMIT_MS milisekundach.
+ * @param[in] journal - wskaźnik na dziennik, NULL gdy dziennik jest wyłączony;
+ * @param[in] type - rodzaj operacji;
+ * @param[in] arg1 - pierwszy argument operacji lub NULL;
+ * @param[in] arg2 - drugi argument operacji lub NULL.
+ * @return Wartość @p true, jeśli wpis został dopisany.
+ *         Wartość @p false w przypadku problemów z alokacją pamięci
+ *         lub gdy nie udało się zapisać na dysk wcześniejszych wpisów;
+ *         wtedy wpis nie jest dopisywany, a operacji nie należy wykonywać.
+ */
+bool journalAppend(Journal *journal, uint8_t type, char const *arg1, char const *arg2);
+
+/** @brief Czeka na utrwalenie wszystkich dopisanych wpisów.
+ * @param[in] journal - wskaźnik na dziennik.
+ * @return Wartość @p true, jeśli wpisy zostały utrwalone.
+ *         Wartość @p false w przypadku problemów z zapisem na dysk.
+ */
+bool journalSync(Journal *journal);
+
+/** @brief Usuwa wszystkie wpisy dziennika.
+ * Wywoływana po zapisaniu baz, które zawierają już skutki tych operacji.
+ * Dopisuje wpis początku sesji.
+ * @param[in] journal - wskaźnik na dziennik.
+ * @return Wartość @p true, jeśli się udało.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool journalReset(Journal *journal);
+
+/** @brief Utrwala wpisy i zamyka dziennik.
+ * Nic nie robi, jeśli wskaźnik @p journal ma wartość NULL.
+ * @param[in] journal - wskaźnik na dziennik.
+ * @return Wartość @p true, jeśli wszystkie wpisy zostały utrwalone.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool journalClose(Journal *journal);
+
+/** @brief Powtarza operacje zapisane w dzienniku.
+ * Czyta wpisy do końca pliku lub do pierwszego niepełnego albo uszkodzonego
+ * wpisu, który mógł zostać przerwany przez awarię, i obcina plik przed nim.
+ * Brak pliku oznacza pusty dziennik.
+ * @param[in] path - ścieżka pliku dziennika;
+ * @param[in] base - wskaźnik na strukturę przechowującą bazy przekierowań;
+ * @param[in] memoryProblems - wskażnik na zmienną, przechowującą informację o tym,
+ *            czy wystąpiły problemy z alokacją pamięci.
+ * @return Wartość @p true, jeśli się udało.
+ *         Wartość @p false, jeśli nie udało się odczytać pliku
+ *         lub wystąpiły problemy z alokacją pamięci.
+ */
+bool journalReplay(char const *path, PfList *base, bool *memoryProblems);
+
+#endif /* _DZIENNIK_H */
@@ -0,0 +1,209 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "phone_forward.h"
+#include "baza.h"
+#include "dziennik.h"
+
+/// Ścieżka pliku dziennika.
+#define JOURNAL_PATH "dziennik_test.log"
+
+/** @brief Podaje rozmiar pliku dziennika.
+ * @return Rozmiar pliku w bajtach.
+ */
+static long journalSize(void) {
+    struct stat info;
+    int status = stat(JOURNAL_PATH, &info);
+
+    assert(status == 0);
+    (void) status;
+
+    return (long) info.st_size;
+}
+
+/** @brief Dopisuje wpisy do dziennika.
+ * Wpis START oznacza ponowne otwarcie dziennika.
+ * @param[in] types – typy wpisów;
+ * @param[in] args1 – pierwsze argumenty wpisów;
+ * @param[in] args2 – drugie argumenty wpisów;
+ * @param[in] count – liczba wpisów.
+ */
+static void writeJournal(uint8_t const *types, char const * const *args1, char const * const *args2, size_t count) {
+    Journal *journal = journalOpen(JOURNAL_PATH);
+    bool result;
+
+    assert(journal != NULL);
+
+    for (size_t i = 0; i < count; i++) {
+        // sesja zaczyna się od nowa przy ponownym otwarciu dziennika.
+        if (types[i] == JOURNAL_START) {
+            result = journalClose(journal);
+            assert(result);
+            journal = journalOpen(JOURNAL_PATH);
+            assert(journal != NULL);
+            continue;
+        }
+
+        result = journalAppend(journal, types[i], args1[i], args2[i]);
+        assert(result);
+    }
+
+    result = journalClose(journal);
+    assert(result);
+    (void) result;
+}
+
+/** @brief Odtwarza dziennik na pustych bazach.
+ * @return Wskaźnik na listę odtworzonych baz.
+ */
+static PfList * replay(void) {
+    bool memoryProblems = false;
+    PfList *base = createMainBaseElement(NULL, &memoryProblems);
+    bool result;
+
+    assert(base != NULL);
+    result = journalReplay(JOURNAL_PATH, base, &memoryProblems);
+    assert(result && !memoryProblems);
+    (void) result;
+
+    return base;
+}
+
+/** @brief Wyznacza przekierowanie numeru w bazie o podanej nazwie.
+ * @param[in] base – wskaźnik na listę baz;
+ * @param[in] name – nazwa bazy;
+ * @param[in] num  – wskaźnik na napis reprezentujący numer;
+ * @param[out] buf – bufor na wynik.
+ * @return Wskaźnik na bufor z wynikiem lub NULL, gdy nie ma bazy o podanej nazwie.
+ */
+static char const * forward(PfList *base, char const *name, char const *num, char *buf) {
+    for (PfList *temp = base->next; temp != NULL; temp = temp->next) {
+        if (temp->baseName != NULL && strcmp(temp->baseName, name) == 0) {
+            struct PhoneNumbers const *pnum = phfwdGet(temp->pf, num);
+
+            strcpy(buf, phnumGet(pnum, 0));
+            phnumDelete(pnum);
+
+            return buf;
+        }
+    }
+
+    return NULL;
+}
+
+/** @brief Dopisuje bajty na koniec dziennika.
+ * @param[in] data   – wskaźnik na dopisywane bajty;
+ * @param[in] length – liczba dopisywanych bajtów.
+ */
+static void appendBytes(char const *data, size_t length) {
+    FILE *file = fopen(JOURNAL_PATH, "ab");
+
+    assert(file != NULL);
+
+    size_t written = fwrite(data, 1, length, file);
+
+    assert(written == length);
+    (void) written;
+    fclose(file);
+}
+
+/** @brief Sprawdza odtwarzanie dziennika, także uszkodzonego.
+ * @return Zero.
+ */
+int main() {
+    static uint8_t const types[] = {JOURNAL_NEW, JOURNAL_ADD, JOURNAL_ADD, JOURNAL_REMOVE, JOURNAL_ADD};
+    static char const * const args1[] = {"a", "12", "5", "12", "7"};
+    static char const * const args2[] = {NULL, "34", "6", NULL, "8"};
+    char buf[64];
+    Journal *journal;
+    PfList *base;
+    long size;
+    bool result;
+
+    // Zwykłe odtworzenie.
+    unlink(JOURNAL_PATH);
+    writeJournal(types, args1, args2, 5);
+    base = replay();
+    assert(strcmp(forward(base, "a", "123", buf), "123") == 0);
+    assert(strcmp(forward(base, "a", "59", buf), "69") == 0);
+    assert(strcmp(forward(base, "a", "7", buf), "8") == 0);
+    deleteWholeBase(base);
+
+    // Niepełny wpis na końcu pliku jest pomijany i obcinany.
+    size = journalSize();
+    appendBytes("\x30\x00\x00\x00\x11\x22\x33\x44\x04" "99\0", 12);
+    base = replay();
+    assert(strcmp(forward(base, "a", "7", buf), "8") == 0);
+    assert(strcmp(forward(base, "a", "99", buf), "99") == 0);
+    assert(journalSize() == size);
+    deleteWholeBase(base);
+
+    // Obcięty plik przyjmuje kolejne wpisy za poprawnymi.
+    journal = journalOpen(JOURNAL_PATH);
+    assert(journal != NULL);
+    result = journalAppend(journal, JOURNAL_NEW, "a", NULL) && journalAppend(journal, JOURNAL_ADD, "99", "1");
+    assert(result);
+    result = journalClose(journal);
+    assert(result);
+
+    base = replay();
+    assert(strcmp(forward(base, "a", "99", buf), "1") == 0);
+    deleteWholeBase(base);
+
+    // Wpis z niezgodną sumą kontrolną kończy odtwarzanie, dalsze wpisy są tracone.
+    static uint8_t const session[] = {JOURNAL_NEW, JOURNAL_ADD};
+    static char const * const sessionArgs1[] = {"a", "7"};
+    static char const * const sessionArgs2[] = {NULL, "8"};
+
+    unlink(JOURNAL_PATH);
+    writeJournal(types, args1, args2, 3);
+    size = journalSize();
+    writeJournal(session, sessionArgs1, sessionArgs2, 2);
+
+    // pierwszy wpis za poprawnymi to START, uszkadzamy jego sumę kontrolną.
+    FILE *file = fopen(JOURNAL_PATH, "r+b");
+    JournalRecord header;
+
+    assert(file != NULL);
+    fseek(file, size, SEEK_SET);
+    result = fread(&header, sizeof(JournalRecord), 1, file) == 1;
+    assert(result);
+    header.checksum ^= 1;
+    fseek(file, size, SEEK_SET);
+    result = fwrite(&header, sizeof(JournalRecord), 1, file) == 1;
+    assert(result);
+    fclose(file);
+
+    base = replay();
+    assert(strcmp(forward(base, "a", "12", buf), "34") == 0);
+    assert(strcmp(forward(base, "a", "7", buf), "7") == 0);
+    assert(journalSize() == size);
+    deleteWholeBase(base);
+
+    // Wpis START zeruje aktualną bazę, więc przekierowanie bez NEW jest pomijane.
+    static uint8_t const restart[] = {JOURNAL_NEW, JOURNAL_ADD, JOURNAL_START, JOURNAL_ADD, JOURNAL_NEW, JOURNAL_ADD};
+    static char const * const restartArgs1[] = {"a", "1", NULL, "3", "b", "5"};
+    static char const * const restartArgs2[] = {NULL, "2", NULL, "4", NULL, "6"};
+
+    unlink(JOURNAL_PATH);
+    writeJournal(restart, restartArgs1, restartArgs2, 6);
+    base = replay();
+    assert(strcmp(forward(base, "a", "1", buf), "2") == 0);
+    assert(strcmp(forward(base, "a", "3", buf), "3") == 0);
+    assert(strcmp(forward(base, "b", "5", buf), "6") == 0);
+    deleteWholeBase(base);
+
+    // Brak pliku oznacza pusty dziennik.
+    unlink(JOURNAL_PATH);
+    base = replay();
+    assert(base->next == NULL);
+    deleteWholeBase(base);
+
+    (void) result;
+
+    return 0;
+}
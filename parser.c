@@ -4,6 +4,24 @@
 #include "baza.h"
 #include "phone_forward.h"
 
+#define BUFFER_SIZE 32
+
+
+/**
+ * Bufor na wynik operacji NUM ?, wykorzystywany przez kolejne zapytania.
+ */
+static char *getBuffer = NULL;
+
+/**
+ * Rozmiar bufora getBuffer.
+ */
+static size_t getBufferSize = 0;
+
+/**
+ * Dziennik operacji zmieniających bazy, NULL gdy operacje nie są zapisywane.
+ */
+static Journal *journal = NULL;
+
 
 
 void printSuddenError() {
@@ -40,11 +58,10 @@ static void printNonTrivialResult(size_t result) {
  * @param[in] list - wskaźnik na strukturę phoneNumbers.
  */
 static void printNumbers(struct PhoneNumbers const *list) {
-    char const *num;
-    size_t idx = 0;
+    size_t n = phnumCount(list);
 
-    while ((num = phnumGet(list, idx++)) != NULL)
-        fprintf(stdout, "%s\n", num);
+    for (size_t idx = 0; idx < n; idx++)
+        fprintf(stdout, "%s\n", phnumGet(list, idx));
 
     phnumDelete(list);
 }
@@ -148,7 +165,8 @@ static void makeReverse(char *num, PfList *actual, bool *errorAppeared, char *op
         return;
 
     if (actual != NULL) {
-        struct PhoneNumbers const *list = phfwdReverse(actual->pf, number);
+        struct PhoneNumbers const *list = actual->pf != NULL ? phfwdReverse(actual->pf, number)
+                                                             : phfwdFrozenReverse(actual->frozen, number);
 
         // nie znaleziono żadnego numeru lub błąd w alokacji pamięci (błąd wykonywania).
         if (list == NULL) {
@@ -189,7 +207,9 @@ static void makeNonTrivial(char *num, PfList *actual, bool *errorAppeared, char
         else
             len = (size_t) setLen;
 
-        result = phfwdNonTrivialCount(actual->pf, num, len);
+        if (actual->pf != NULL)
+            result = phfwdNonTrivialCount(actual->pf, num, len);
+        else result = phfwdFrozenNonTrivialCount(actual->frozen, num, len);
 
         printNonTrivialResult(result);
     }
@@ -220,9 +240,12 @@ static void addNewNumber(char *numb1, char *numb2, PfList *actual, bool *errorAp
     if (*memoryProblems)
         return;
 
-    if (actual != NULL) {
-        bool added = phfwdAdd(actual->pf, num1, num2);
-        if (!added) {
+    if (actual != NULL && thawBase(actual, memoryProblems)) {
+        // operacja trafia do dziennika, zanim zostanie wykonana.
+        if (!journalAppend(journal, JOURNAL_ADD, num1, num2)) {
+            (*memoryProblems) = true;
+        }
+        else if (!phfwdAdd(actual->pf, num1, num2)) {
             (*errorAppeared) = true;
             printMakingError(operator, charCounter);
         }
@@ -238,7 +261,44 @@ static void addNewNumber(char *numb1, char *numb2, PfList *actual, bool *errorAp
 }
 
 
+/** @brief Powiększa bufor na wynik operacji NUM ?.
+ * @param[in] size - minimalny wymagany rozmiar bufora;
+ * @param[in] memoryProblems - wskaźnik na zmienną, przechowującą informację o tym,
+ *            czy wystąpiły problemy z alokacją pamięci.
+ * @return Wartość @p true, jeśli udało się powiększyć bufor.
+ *         Wartość @p false w przypadku problemów z alokacją pamięci.
+ */
+static bool growGetBuffer(size_t size, bool *memoryProblems) {
+    size_t newSize = getBufferSize == 0 ? BUFFER_SIZE : 2 * getBufferSize;
+
+    if (newSize < size)
+        newSize = size;
+
+    char *newBuffer = realloc(getBuffer, newSize * sizeof(char));
+
+    // gdyby wystąpiły problemy z alokacją pamięci.
+    if (newBuffer == NULL) {
+        (*memoryProblems) = true;
+        return false;
+    }
+
+    getBuffer = newBuffer;
+    getBufferSize = newSize;
+
+    return true;
+}
+
+
+void cleanParserBuffers() {
+    free(getBuffer);
+    getBuffer = NULL;
+    getBufferSize = 0;
+}
+
+
 /** @brief Wypisuje przekierowanie z podanego numeru.
+ * Wynik jest zapisywany we wspólnym buforze, więc w typowym przypadku
+ * operacja nie alokuje pamięci.
  * @param[in] numb - numer, z którego wypisywane są przekierowania;
  * @param[in] actual - wskaźnik, wskazujacy na aktualną bazę przekierowań;
  * @param[in] errorAppeared  - wskaźnik na zmienną, informującą o tym, czy wystąpił
@@ -250,30 +310,35 @@ static void addNewNumber(char *numb1, char *numb2, PfList *actual, bool *errorAp
  */
 static void getNumber(char *numb, PfList *actual, bool *errorAppeared, char *operator, int charCounter,
                       bool *memoryProblems) {
-    char const *num = convertToCharConst(numb, memoryProblems);
+    // baza odwzorowana z pliku.
+    if (actual != NULL && actual->pf == NULL) {
+        struct PhoneNumbers const *list = phfwdFrozenGet(actual->frozen, numb);
 
-    // gdyby wystąpiły problemy z alokacją pamięci.
-    if (*memoryProblems)
-        return;
-
-    if (actual != NULL) {
-        struct PhoneNumbers const *number = phfwdGet(actual->pf, num);
+        if (list == NULL)
+            (*memoryProblems) = true;
+        else printNumbers(list);
+    }
+    else if (actual != NULL) {
+        size_t n = phfwdGetInto(actual->pf, numb, getBuffer, getBufferSize);
 
-        // w przypadku, gdy nie znajdziemy żadnego numeru lub wystapią błędy alokacji pamięci zwracamy bład.
-        if (number == NULL) {
-            (*errorAppeared) = true;
-            printMakingError(operator, charCounter);
+        // pusty wynik oznacza, że napis nie reprezentuje numeru.
+        if (n == 0)
             return;
+
+        // wynik nie zmieścił się w buforze, powiększamy go i wyznaczamy przekierowanie ponownie.
+        if (n >= getBufferSize) {
+            if (!growGetBuffer(n + 1, memoryProblems))
+                return;
+
+            phfwdGetInto(actual->pf, numb, getBuffer, getBufferSize);
         }
 
-        printNumbers(number);
+        fprintf(stdout, "%s\n", getBuffer);
     }
     else {
         (*errorAppeared) = true;
         printMakingError(operator, charCounter);
     }
-
-    free((void*)num);
 }
 
 
@@ -295,8 +360,11 @@ static void delNumber(char *number, bool *errorAppeared, PfList *actual, char *o
     if (*memoryProblems)
         return;
 
-    if (actual != NULL) {
-        phfwdRemove(actual->pf, num);
+    if (actual != NULL && thawBase(actual, memoryProblems)) {
+        // operacja trafia do dziennika, zanim zostanie wykonana.
+        if (journalAppend(journal, JOURNAL_REMOVE, num, NULL))
+            phfwdRemove(actual->pf, num);
+        else (*memoryProblems) = true;
     }
     // brak żądanej do unięcia bazy lub możliwe błędy alkoacji pamięci.
     else {
@@ -354,6 +422,12 @@ static PfList * findBaseToDel(char *name, PfList *base) {
  *            czy wystąpiły problemy z alokacją pamięci.
  */
 static void addNewBase(char *name, PfList **actual, PfList *base, bool *memoryProblems) {
+    // operacja trafia do dziennika, także gdy tylko wybiera istniejącą bazę.
+    if (!journalAppend(journal, JOURNAL_NEW, name, NULL)) {
+        (*memoryProblems) = true;
+        return;
+    }
+
     PfList *exsistingBase = findRightBase(name, base);
 
     // gdy podana baza już istnieje.
@@ -379,6 +453,21 @@ static void addNewBase(char *name, PfList **actual, PfList *base, bool *memoryPr
 }
 
 
+/** @brief Odłącza i usuwa bazę następującą po danej.
+ * @param[in] previous - wskaźnik na bazę poprzedzającą usuwaną;
+ * @param[in] actual - adres wskaźnika, wskazujacego na aktualną bazę przekierowań.
+ */
+static void unlinkBase(PfList *previous, PfList **actual) {
+    PfList *temp = previous->next;
+    previous->next = temp->next;
+
+    if ((*actual) == temp)
+        (*actual) = NULL;
+
+    deleteSingleBase(temp);
+}
+
+
 /** @brief Usuwa bazę o danej nazwie ze struktury baz przekierowań.
  * @param[in] name - wskaźnik na nazwę bazy do usunięcia;
  * @param[in] actual - adres wskaźnika, wskazujacego na aktualną bazę przekierowań;
@@ -387,8 +476,11 @@ static void addNewBase(char *name, PfList **actual, PfList *base, bool *memoryPr
  * @param[in] base - wskaźnik na strukturę, przechowującą bazy przekierowań;
  * @param[in] operator - wskaźnik na operator operacji (w razie wystapienia błędu);
  * @param[in] charCounter - numer pierwszego znaku danego identyfikatora;
+ * @param[in] memoryProblems - wskaźnik na zmienną, przechowującą informację o tym,
+ *            czy wystąpiły problemy z alokacją pamięci.
  */
-static void delBase(char *name, PfList **actual, bool *errorAppeared, PfList *base, char *operator, int charCounter) {
+static void delBase(char *name, PfList **actual, bool *errorAppeared, PfList *base, char *operator, int charCounter,
+                    bool *memoryProblems) {
     PfList *exsistingBase = findBaseToDel(name, base);
 
     // gdy podana baza nie istnieje.
@@ -398,14 +490,48 @@ static void delBase(char *name, PfList **actual, bool *errorAppeared, PfList *ba
         return;
     }
 
+    // operacja trafia do dziennika, zanim zostanie wykonana.
+    if (!journalAppend(journal, JOURNAL_DEL_BASE, name, NULL)) {
+        (*memoryProblems) = true;
+        return;
+    }
+
     // usuwanie wybranej bazy.
-    PfList *temp = exsistingBase->next;
-    exsistingBase->next = temp->next;
+    unlinkBase(exsistingBase, actual);
+}
 
-    if ((*actual) == temp)
+
+void setParserJournal(Journal *newJournal) {
+    journal = newJournal;
+}
+
+
+void replayOperation(uint8_t type, char *arg1, char *arg2, PfList **actual, PfList *base, bool *memoryProblems) {
+    // odtwarzane operacje są już w dzienniku.
+    Journal *saved = journal;
+    journal = NULL;
+
+    if (type == JOURNAL_START) {
         (*actual) = NULL;
+    }
+    else if (type == JOURNAL_NEW && arg1 != NULL) {
+        addNewBase(arg1, actual, base, memoryProblems);
+    }
+    else if (type == JOURNAL_DEL_BASE && arg1 != NULL) {
+        PfList *exsistingBase = findBaseToDel(arg1, base);
 
-    deleteSingleBase(temp);
+        if (exsistingBase->next != NULL)
+            unlinkBase(exsistingBase, actual);
+    }
+    // operacje na przekierowaniach, które wtedy się nie powiodły, teraz też nic nie zmienią.
+    else if ((*actual) != NULL && arg1 != NULL && thawBase((*actual), memoryProblems)) {
+        if (type == JOURNAL_ADD && arg2 != NULL)
+            phfwdAdd((*actual)->pf, arg1, arg2);
+        else if (type == JOURNAL_REMOVE)
+            phfwdRemove((*actual)->pf, arg1);
+    }
+
+    journal = saved;
 }
 
 
@@ -504,7 +630,8 @@ bool parseInstruction(Instruction *tab[], int *j, PfList **actual, PfList *base,
                 return false;
 
             if (strcmp(tab[1]->name, "identifier") == 0) {
-                delBase(tab[1]->instr, actual, errorAppeared, base, tab[0]->instr, tab[0]->charCounter);
+                delBase(tab[1]->instr, actual, errorAppeared, base, tab[0]->instr, tab[0]->charCounter,
+                        memoryProblems);
                 (*j) = 0;
                 return true;
             }
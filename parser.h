@@ -2,7 +2,9 @@
 #define _PARSER_H
 
 #include <stdbool.h>
+#include <stdint.h>
 #include "baza.h"
+#include "dziennik.h"
 
 
 
@@ -34,4 +36,30 @@ void printUnreadableError(int n);
 void printSuddenError();
 
 
+/**
+ * @brief Zwalnia bufory wykorzystywane przez kolejne operacje interpretera.
+ */
+void cleanParserBuffers();
+
+
+/** @brief Ustawia dziennik, do którego są zapisywane operacje zmieniające bazy.
+ * @param[in] journal - wskaźnik na dziennik lub NULL, gdy operacje nie są zapisywane.
+ */
+void setParserJournal(Journal *journal);
+
+
+/** @brief Wykonuje operację odczytaną z dziennika.
+ * Operacja działa tak samo jak instrukcja wejścia, ale niczego nie wypisuje
+ * i nie jest ponownie zapisywana w dzienniku.
+ * @param[in] type - rodzaj operacji;
+ * @param[in] arg1 - pierwszy argument operacji lub NULL;
+ * @param[in] arg2 - drugi argument operacji lub NULL;
+ * @param[in] actual - adres wskaźnika, wskazujacego na aktualną bazę przekierowań;
+ * @param[in] base - wskaźnik na strukturę, przechowującą bazy przekierowań;
+ * @param[in] memoryProblems - wskażnik na zmienną, przechowującą informację o tym,
+ *            czy wystąpiły problemy z alokacją pamięci.
+ */
+void replayOperation(uint8_t type, char *arg1, char *arg2, PfList **actual, PfList *base, bool *memoryProblems);
+
+
 #endif
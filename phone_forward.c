@@ -1,792 +1,5065 @@
 #include <stdio.h>
 #include <stdbool.h>
-#include <ctype.h>
 #include <string.h>
 #include <math.h>
 #include <stdint.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
 #include "phone_forward.h"
 
-#define DIGITS  12
-
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/// Najmniejsza liczba węzłów drzewa, przy której zliczanie jest dzielone między wątki.
+/// Można ją zmienić przy kompilacji, np. -DPARALLEL_MIN_NODES=1 w testach.
+#ifndef PARALLEL_MIN_NODES
+#define PARALLEL_MIN_NODES  (1u << 16)
+#endif
+/// Docelowa liczba poddrzew przypadających na jeden wątek zliczający.
+/// Można ją zmienić przy kompilacji.
+#ifndef TASKS_PER_THREAD
+#define TASKS_PER_THREAD    16
+#endif
+/// Największa liczba wątków zliczających.
+#define MAX_COUNT_THREADS   64
+
+/// Liczba wyszukiwań prowadzonych naprzemiennie przez funkcję phfwdGetBatch.
+#define BATCH_GROUP 16
+
+/// Zlecenie wczesnego pobrania pamięci do pamięci podręcznej, jeśli kompilator to umożliwia.
+#if defined(__GNUC__)
+#define PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define PREFETCH(addr) ((void) (addr))
+#endif
+
+
+
+/** @brief Sprawdza, czy na numer reprezentowany przez węzeł są jakieś przekierowania.
+ * @param[in] node - wskaźnik na węzeł.
+ * @return Wartość @p true, jeśli tablica rev węzła jest niepusta.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static inline bool hasReverse(PfNode const *node) {
+    return node->rev != NULL && (node->rev)->count > 0;
+}
 
 
-/** @brief Usuwa całą strukturę listy List.
- * @param[in] l - wskaźnikna listę do usunięcia.
+/** @brief Udostępnia element puli o danym indeksie.
+ * @param[in] pool - wskaźnik na pulę;
+ * @param[in] idx - indeks elementu, różny od NO_NODE.
+ * @return Wskaźnik na element.
  */
-static void cleanList(List *l) {
-    if (l != NULL) {
-        while (l != NULL) {
-            List *temp = l;
-            l = l->next;
+static inline void * poolGet(PfPool const *pool, uint32_t idx) {
+    return pool->slabs[idx >> SLAB_SHIFT] + (size_t) (idx & (SLAB_SIZE - 1)) * pool->elSize;
+}
 
-            if (temp->revNum != NULL)
-                free(temp->revNum);
 
-            free(temp);
-        }
-    }
+/** @brief Udostępnia element puli współbieżnemu czytelnikowi.
+ * Tablica bloków może być w tym czasie zastępowana większą, więc jest
+ * odczytywana atomowo.
+ * @param[in] pool - wskaźnik na pulę;
+ * @param[in] idx - indeks elementu, odczytany z opublikowanego pola struktury.
+ * @return Wskaźnik na element.
+ */
+static inline void * poolLoad(PfPool const *pool, uint32_t idx) {
+    char **slabs = __atomic_load_n(&pool->slabs, __ATOMIC_ACQUIRE);
+
+    return slabs[idx >> SLAB_SHIFT] + (size_t) (idx & (SLAB_SIZE - 1)) * pool->elSize;
 }
 
 
-/** @brief Usuwa pojedynczy element listy.
- * @param[in] toDel - wskaźnik na element listy do usunięcia.
+/** @brief Zwraca element do puli.
+ * Element trafia na listę zwolnionych i zostanie wykorzystany ponownie.
+ * @param[in] pool - wskaźnik na pulę;
+ * @param[in] idx - indeks zwalnianego elementu.
  */
-static void removeRevListEl(List *toDel) {
-    List *pop = toDel->prev;
-    List *nast = toDel->next;
+static void poolFree(PfPool *pool, uint32_t idx) {
+    memcpy(poolGet(pool, idx), &pool->freeList, sizeof(uint32_t));
+    pool->freeList = idx;
+}
 
-    pop->next = toDel->next;
-    if (nast != NULL)
-        nast->prev = toDel->prev;
 
-    free(toDel->revNum);
-    toDel->revNum = NULL;
+/// Liczba dotychczas przydzielonych wątkom liczników czytelników.
+static unsigned slotCounter = 0;
 
-    free(toDel);
-}
+/// Numer licznika czytelników bieżącego wątku powiększony o 1, 0 gdy go nie przydzielono.
+static _Thread_local unsigned threadSlot = 0;
 
 
-/** @brief Tworzy pojedynczy element listy.
- * Umieszcza nowo utworzony element listy rev danego numeru za atrapą.
- * @param[in] rev - wskaźnik na listę, do której dodajemy element;
- * @param[in] num - wskaźnik na numer, który dodajemy do listy.
- * @return Wskaźnik nowo utworzonego elementu listy
- *         lub NULL  wprzypadku błędu alokacji pamięci.
- */
-static List * addRevListEl(List *rev, char *num) {
-    List *new = (List*)malloc(sizeof(List));
-    List *first = rev;
+unsigned threadReaderSlot(void) {
+    if (threadSlot == 0)
+        threadSlot = __atomic_fetch_add(&slotCounter, 1, __ATOMIC_RELAXED) % READER_SLOTS + 1;
 
-    // błędy z alokacją pamięci.
-    if (new == NULL)
-        return NULL;
+    return threadSlot - 1;
+}
 
-    new->next = first->next;
-    new->prev = first;
 
-    if (first->next != NULL)
-        (first->next)->prev = new;
-    first->next = new;
+/** @brief Sumuje liczniki czytelników epok o danej parzystości.
+ * @param[in] sync - wskaźnik na strukturę synchronizacji;
+ * @param[in] parity - parzystość epok.
+ * @return Liczbę czytelników.
+ */
+static size_t countReaders(PfSync *sync, size_t parity) {
+    size_t readers = 0;
 
-    new->revNum = num;
+    for (size_t i = 0; i < READER_SLOTS; i++)
+        readers += __atomic_load_n(&sync->slots[i].readers[parity], __ATOMIC_SEQ_CST);
 
-    return new;
+    return readers;
 }
 
 
-void phfwdDelete(struct PhoneForward *pf) {
-    if (pf == NULL)
-        return;
+/** @brief Zwalnia pamięć odłączoną w epokach o danej parzystości.
+ * Elementy pul wracają na listy zwolnionych i dopiero teraz mogą zostać
+ * przydzielone ponownie.
+ * @param[in] sync - wskaźnik na strukturę synchronizacji;
+ * @param[in] parity - parzystość epok.
+ */
+static void freeLimbo(PfSync *sync, size_t parity) {
+    for (size_t i = 0; i < sync->limboCount[parity]; i++) {
+        RetiredMemory *retired = &sync->limbo[parity][i];
 
-    for (int i = 0; i < DIGITS; i++) {
-        phfwdDelete(pf->digits[i]);
+        if (retired->ptr != NULL)
+            free(retired->ptr);
+        else
+            poolFree(retired->pool, retired->idx);
     }
 
-    // usunięcie kolejnych pól struktury.
-    if (pf->number != NULL)
-        free(pf->number);
-    pf->number = NULL;
+    sync->limboCount[parity] = 0;
+}
 
-    if (pf->rev != NULL)
-        cleanList(pf->rev);
-    pf->rev = NULL;
 
-    free(pf);
+/** @brief Przechodzi do następnej epoki, jeśli czytelnicy poprzedniej już skończyli.
+ * Pamięć odłączoną w poprzedniej epoce mogli odczytywać tylko czytelnicy
+ * tej lub wcześniejszych epok, więc można ją wtedy zwolnić.
+ * Wywoływana przez modyfikującego, nie czeka na czytelników.
+ * @param[in] sync - wskaźnik na strukturę synchronizacji.
+ */
+static void tryAdvanceEpoch(PfSync *sync) {
+    size_t epoch = sync->epoch;
+    size_t previous = (epoch - 1) & 1;
+
+    // odłączenie pamięci musi być widoczne, zanim odczytamy liczniki czytelników.
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    if (countReaders(sync, previous) != 0)
+        return;
+
+    freeLimbo(sync, previous);
+    __atomic_store_n(&sync->epoch, epoch + 1, __ATOMIC_SEQ_CST);
 }
 
 
-/** @brief Tworzy pojedynczy element struktury PhoneForward.
- * Ustawia jej pola na nulle.
- * @return Wskaźnik nowo utworzonego elementu lub NULL w przypadku problemów z alokacją pamięci.
+/** @brief Czeka, aż zakończą się wszystkie rozpoczęte odczyty, i zwalnia odłączoną pamięć.
+ * Używana, gdy nie udało się zapamiętać odłączanej pamięci. Czeka tylko
+ * modyfikujący, czytelnicy nadal działają bez przeszkód.
+ * @param[in] sync - wskaźnik na strukturę synchronizacji.
  */
-static struct PhoneForward * createNewElement() {
-    struct PhoneForward *newEl = malloc(sizeof(struct PhoneForward));
+static void synchronizeReaders(PfSync *sync) {
+    size_t epoch = sync->epoch;
 
-    if (newEl == NULL)
-        return NULL;
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
 
-    for (int i = 0; i < DIGITS; i++) {
-        newEl->digits[i] = NULL;
-    }
+    while (countReaders(sync, (epoch - 1) & 1) != 0)
+        sched_yield();
 
-    List *atrap = (List*)malloc(sizeof(List));
-    atrap->next = NULL;
-    atrap->prev = NULL;
-    atrap->revNum = NULL;
+    freeLimbo(sync, (epoch - 1) & 1);
+    __atomic_store_n(&sync->epoch, epoch + 1, __ATOMIC_SEQ_CST);
 
-    newEl->rev = atrap;
-    newEl->this = NULL;
-    newEl->number = NULL;
+    // czytelnicy nowej epoki rozpoczęli odczyt po odłączeniu całej zapamiętanej pamięci.
+    while (countReaders(sync, epoch & 1) != 0)
+        sched_yield();
 
-    return newEl;
+    freeLimbo(sync, epoch & 1);
 }
 
 
-struct PhoneForward * phfwdNew(void) {
-    // w razie problemów z alokacją pamięci funkcja createNewElement zwróci NULL.
-    struct PhoneForward *pf = createNewElement();
+/** @brief Odkłada pamięć do zwolnienia po zakończeniu odczytów, które mogły ją widzieć.
+ * Bez współbieżnych odczytów pamięć jest zwalniana od razu.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania;
+ * @param[in] retired - opis odłączonej pamięci.
+ */
+static void retire(struct PhoneForward *pf, RetiredMemory retired) {
+    PfSync *sync = pf->sync;
+    size_t parity = sync != NULL ? sync->epoch & 1 : 0;
+
+    if (sync != NULL && sync->limboCount[parity] == sync->limboCapacity[parity]) {
+        size_t newCapacity = sync->limboCapacity[parity] == 0 ? 16 : 2 * sync->limboCapacity[parity];
+        RetiredMemory *newLimbo = realloc(sync->limbo[parity], newCapacity * sizeof(RetiredMemory));
+
+        // problem z alokacją pamięci, czekamy na czytelników i zwalniamy od razu.
+        if (newLimbo == NULL) {
+            synchronizeReaders(sync);
+            sync = NULL;
+        }
+        else {
+            sync->limbo[parity] = newLimbo;
+            sync->limboCapacity[parity] = newCapacity;
+        }
+    }
 
-    return pf;
+    if (sync != NULL)
+        sync->limbo[parity][sync->limboCount[parity]++] = retired;
+    else if (retired.ptr != NULL)
+        free(retired.ptr);
+    else
+        poolFree(retired.pool, retired.idx);
 }
 
 
-/** @brief Sprawdza, czy otrzymana tablica znaków zawiera numer.
- * Zwróci fałsz przy pierwszym napotkanym znaku, nie reprezentującym liczby.
- * @param[in] num – wskaźnik na napis reprezentujący potencjalny numer.
- * @return Wartość @p true, jeśli wszystkie znaki są cyframi,
- *         Wartość @p false, jeśli chociaż jeden znak okazał się nie być cyfrą.
+/** @brief Zwalnia pamięć, którą mogą jeszcze odczytywać współbieżni czytelnicy.
+ * Bez współbieżnych odczytów pamięć jest zwalniana od razu, w przeciwnym
+ * przypadku dopiero po zakończeniu odczytów, które mogły ją widzieć.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania;
+ * @param[in] ptr - wskaźnik na odłączony od struktury obszar pamięci lub NULL.
  */
-static bool checkIfNumber(char const *num) {
-    int i = 0;
-    char c = num[i];
-
-    while (c != '\0') {
-        if (!isdigit(c) && !(c == ':') && !(c == ';'))
-            return false;
+static void retireMemory(struct PhoneForward *pf, void *ptr) {
+    if (ptr != NULL)
+        retire(pf, (RetiredMemory) {ptr, NULL, NO_NODE});
+}
 
-        i++;
-        c = num[i];
-    }
 
-    return true;
+/** @brief Zwraca do puli element, który mogą jeszcze odczytywać współbieżni czytelnicy.
+ * Indeks nie zostanie przydzielony ponownie, dopóki trwają odczyty, które
+ * mogły go widzieć, a do tego czasu zawartość elementu się nie zmienia.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania;
+ * @param[in] pool - wskaźnik na pulę;
+ * @param[in] idx - indeks odłączonego elementu.
+ */
+static void retireElement(struct PhoneForward *pf, PfPool *pool, uint32_t idx) {
+    retire(pf, (RetiredMemory) {NULL, pool, idx});
 }
 
 
-/** @brief Tworzy kopię numeru, otrzymanego od użytkownika.
- * @param[in] num – wskaźnik na napis reprezentujący numer do skopiowania.
- * @return wskaźnik na utworzoną kopię numeru
- *         lub NULL w przypadku błędów alokacji pamięci.
+/** @brief Rozpoczyna modyfikację struktury.
+ * Przy włączonych współbieżnych odczytach zajmuje blokadę modyfikacji.
+ * @param[in] pf - wskaźnik na modyfikowaną strukturę.
  */
-static char * copyNumber(char const *num) { // num napewno nie jest nullem
-    // dodana 1 rezerwuje miejsce na '\0'
-    size_t n = strlen(num) + 1;
+static void writeBegin(struct PhoneForward *pf) {
+    if (pf->sync != NULL)
+        pthread_mutex_lock(&pf->sync->writeLock);
+}
 
-    char *numToAdd = malloc(n * sizeof(char));
 
-    // problemy z alokacją pamięci.
-    if (numToAdd == NULL)
-        return NULL;
+/** @brief Kończy modyfikację struktury.
+ * Próbuje zwolnić odłączoną pamięć i zwalnia blokadę modyfikacji.
+ * @param[in] pf - wskaźnik na modyfikowaną strukturę.
+ */
+static void writeEnd(struct PhoneForward *pf) {
+    PfSync *sync = pf->sync;
 
-    strcpy(numToAdd, num);
+    if (sync == NULL)
+        return;
 
-    return numToAdd;
+    tryAdvanceEpoch(sync);
+    pthread_mutex_unlock(&sync->writeLock);
 }
 
 
-/** @brief Funkcja pomocnicza do phfwdAdd.
- * Odnajduje w strukturze PhoneForward dany numer.
- * @param[in] num - odnajdywany numer;
- * @param[in] pf - wskaźnik na strukturę PhoneForward, w której szukamy danego numeru.
- * @return Wskaźnik do węzła struktury PhoneForward, reprezentującego szukany numer.
+/** @brief Rejestruje czytelnika w bieżącej epoce.
+ * Nie czeka i nie powtarza rejestracji, nawet gdy epoka właśnie się zmienia:
+ * licznik dowolnej parzystości wstrzymuje zwolnienie pamięci odłączonej
+ * po jego zwiększeniu, bo epoka nie może wtedy przesunąć się o dwie.
+ * @param[in] sync - wskaźnik na strukturę synchronizacji;
+ * @param[out] parity - parzystość epoki, w której zarejestrowano czytelnika.
+ * @return Wskaźnik na licznik czytelników bieżącego wątku.
  */
-static struct PhoneForward * findNumInStructure(char const *num, struct PhoneForward *pf) {
-    struct PhoneForward *temp = pf;
-    int i = 0;
-    int x;
-    char c;
+static ReaderSlot * epochEnter(PfSync *sync, size_t *parity) {
+    ReaderSlot *slot = &sync->slots[threadReaderSlot()];
 
-    // szukanie num w strukturze phoneForward
-    c = num[i];
-    while (c != '\0') {
-        x = (int) c - (int) '0';
+    (*parity) = __atomic_load_n(&sync->epoch, __ATOMIC_RELAXED) & 1;
+    __atomic_fetch_add(&slot->readers[*parity], 1, __ATOMIC_SEQ_CST);
 
-        if (temp->digits[x] == NULL) {
-            struct PhoneForward *newEl = createNewElement();
+    return slot;
+}
 
-            // problem z alokacją pamięci.
-            if (newEl == NULL)
-                return false;
 
-            temp->digits[x] = newEl;
-        }
+/** @brief Wyrejestrowuje czytelnika.
+ * @param[in] slot - licznik czytelników bieżącego wątku;
+ * @param[in] parity - parzystość epoki, w której zarejestrowano czytelnika.
+ */
+static void epochLeave(ReaderSlot *slot, size_t parity) {
+    __atomic_fetch_sub(&slot->readers[parity], 1, __ATOMIC_RELEASE);
+}
 
-        temp = temp->digits[x];
-        i++;
-        c = num[i];
-    }
 
-    return temp;
+/** @brief Inicjuje pustą pulę elementów.
+ * Indeks NO_NODE jest zarezerwowany, więc pierwszy przydzielony element
+ * otrzyma indeks ROOT_NODE.
+ * @param[in] pool - wskaźnik na inicjowaną pulę;
+ * @param[in] elSize - rozmiar pojedynczego elementu puli.
+ */
+static void poolInit(PfPool *pool, size_t elSize) {
+    pool->slabs = NULL;
+    pool->slabCount = 0;
+    pool->slabCapacity = 0;
+    pool->elSize = elSize;
+    pool->count = ROOT_NODE;
+    pool->freeList = NO_NODE;
 }
 
 
-bool phfwdAdd(struct PhoneForward *pf, char const *num1, char const *num2) {
-    // num1 lub num2 lub struktura pf są nulami.
-    if (num1 == NULL || num2 == NULL || pf == NULL)
-        return false;
+/** @brief Przydziela element puli.
+ * Wykorzystuje element z listy zwolnionych lub zajmuje kolejny wolny indeks,
+ * w razie potrzeby alokując nowy blok elementów.
+ * @param[in] pf - wskaźnik na strukturę, do której należy pula;
+ * @param[in] pool - wskaźnik na pulę.
+ * @return Indeks przydzielonego elementu lub NO_NODE w przypadku problemów z alokacją pamięci.
+ */
+static uint32_t poolAlloc(struct PhoneForward *pf, PfPool *pool) {
+    uint32_t idx = pool->count;
+    size_t slab = idx >> SLAB_SHIFT;
 
-    // num1 lub num2 reprezentują pusty ciąg.
-    if (num1[0] == '\0' || num2[0] == '\0')
-        return false;
+    if (pool->freeList != NO_NODE) {
+        idx = pool->freeList;
+        memcpy(&pool->freeList, poolGet(pool, idx), sizeof(uint32_t));
 
-    bool isDigitNum1 = checkIfNumber(num1);
-    bool isDigitNum2 = checkIfNumber(num2);
-    int isTheSame = strcmp(num1, num2);
-    struct PhoneForward *temp1;
-    struct PhoneForward *temp2;
-    List *new;
+        return idx;
+    }
 
-    // num1 nie reprezentują numeru, lub są takie same.
-    if (!isDigitNum1 || !isDigitNum2 || isTheSame == 0)
-        return false;
+    // wyczerpano 32-bitowe indeksy, największe z nich są znacznikami rodzaju tablicy synów.
+    if (idx == POOL_LIMIT)
+        return NO_NODE;
 
+    // wszystkie bloki są zapełnione, alokujemy kolejny.
+    if (slab == pool->slabCount) {
+        if (pool->slabCount == pool->slabCapacity) {
+            size_t newCapacity = pool->slabCapacity == 0 ? 4 : 2 * pool->slabCapacity;
+            char **newSlabs = malloc(newCapacity * sizeof(char*));
 
-    // dodawanie przekierowania dla num1.
-    // szukanie num1 w strukturze phoneForward
-    temp1 = findNumInStructure(num1, pf);
+            // problem z alokacją pamięci.
+            if (newSlabs == NULL)
+                return NO_NODE;
 
-    // dodanie num2 do struktury.
-    char *numToAdd = copyNumber(num2);
+            // współbieżni czytelnicy mogą jeszcze korzystać z poprzedniej tablicy bloków.
+            if (pool->slabCount > 0)
+                memcpy(newSlabs, pool->slabs, pool->slabCount * sizeof(char*));
 
-    // problem z alokacją pamięci.
-    if (numToAdd == NULL)
-        return false;
+            char **oldSlabs = pool->slabs;
 
-    if (temp1->number != NULL) {
-        // usuwanie starego przekierowania.
-        free(temp1->number);
+            __atomic_store_n(&pool->slabs, newSlabs, __ATOMIC_RELEASE);
+            pool->slabCapacity = newCapacity;
+            retireMemory(pf, oldSlabs);
+        }
+
+        char *newSlab = malloc(SLAB_SIZE * pool->elSize);
+
+        // problem z alokacją pamięci.
+        if (newSlab == NULL)
+            return NO_NODE;
 
-        // usuwanie num1 z listy rev starego przekierowania.
-        removeRevListEl(temp1->this);
+        pool->slabs[pool->slabCount] = newSlab;
+        pool->slabCount++;
     }
 
-    temp1->number = numToAdd;
+    pool->count++;
 
+    return idx;
+}
 
-    // dodawanie odwrotnego przekierowania do listy rev dla num2.
-    // szukanie num2 w strukturze phoneForward.
-    temp2 = findNumInStructure(num2, pf);
 
-    // dodanie num1 do listy rev.
-    char *numToAdd2 = copyNumber(num1);
+/** @brief Zwalnia wszystkie bloki puli.
+ * @param[in] pool - wskaźnik na usuwaną pulę.
+ */
+static void poolDelete(PfPool *pool) {
+    for (size_t i = 0; i < pool->slabCount; i++)
+        free(pool->slabs[i]);
+
+    free(pool->slabs);
+    pool->slabs = NULL;
+}
 
-    // problem z alokacją pamięci.
-    if (numToAdd2 == NULL)
-        return false;
 
-    new = addRevListEl(temp2->rev, numToAdd2);
-    temp1->this = new;
+/** @brief Udostępnia węzeł o danym indeksie.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania;
+ * @param[in] idx - indeks węzła, różny od NO_NODE.
+ * @return Wskaźnik na węzeł.
+ */
+static inline PfNode * getNode(struct PhoneForward const *pf, uint32_t idx) {
+    return (PfNode*) poolGet(&pf->nodes, idx);
+}
 
-    // problem z alokacją pamięci.
-    if (new == NULL)
-        return false;
 
-    return true;
+/** @brief Odczytuje cyfrę numeru węzła.
+ * @param[in] node - wskaźnik na węzeł;
+ * @param[in] pos - pozycja cyfry w numerze, jedna z ostatnich LABEL_MAX pozycji.
+ * @return Wartość cyfry, od 0 do 11.
+ */
+static inline int numberDigit(PfNode const *node, uint32_t pos) {
+    uint32_t slot = pos % LABEL_MAX;
+
+    return (node->label[slot >> 1] >> ((slot & 1) * 4)) & 0xF;
 }
 
 
-/** @brief Usuwa wybrane przekierowania ze struktury PhoneForward,
- * Wskaźnik na usunięte pola ustawia na NULL.
- * @param[in] pf  – wskaźnik na strukturę przechowującą przekierowania numerów.
+/** @brief Odczytuje cyfrę etykiety węzła.
+ * @param[in] node - wskaźnik na węzeł;
+ * @param[in] i - pozycja cyfry w etykiecie.
+ * @return Wartość cyfry, od 0 do 11.
  */
-static void removeChosenNumbers(struct PhoneForward *pf) {
-    if (pf == NULL)
-        return;
-    else {
-        for (int i = 0; i < DIGITS; i++) {
-            removeChosenNumbers(pf->digits[i]);
-        }
+static inline int labelDigit(PfNode const *node, int i) {
+    return numberDigit(node, node->depth - node->labelLen + (uint32_t) i);
+}
 
-        if (pf->number != NULL) {
-            free(pf->number);
-            removeRevListEl(pf->this);
-        }
 
-        pf->number = NULL;
-        pf->this = NULL;
+/** @brief Ustawia etykietę nowego węzła.
+ * Ostatnie cyfry numeru ojca przechodzą do węzła, a za nimi dopisywana
+ * jest etykieta. Wyznacza też głębokość węzła.
+ * @param[in] node - wskaźnik na węzeł, jeszcze niedostępny dla czytelników;
+ * @param[in] parent - wskaźnik na ojca węzła;
+ * @param[in] digits - napis z cyframi etykiety;
+ * @param[in] len - liczba cyfr, od 1 do LABEL_MAX.
+ */
+static void setLabel(PfNode *node, PfNode const *parent, char const *digits, int len) {
+    memcpy(node->label, parent->label, LABEL_BYTES);
+    node->labelLen = (uint8_t) len;
+    node->depth = parent->depth + (uint32_t) len;
+
+    for (int i = 0; i < len; i++) {
+        uint32_t slot = (parent->depth + (uint32_t) i) % LABEL_MAX;
+        int shift = (int) (slot & 1) * 4;
+        int x = (int) digits[i] - (int) '0';
+
+        node->label[slot >> 1] = (uint8_t) ((node->label[slot >> 1] & ~(0xF << shift)) | (x << shift));
     }
 }
 
 
-void phfwdRemove(struct PhoneForward *pf, char const *num) {
-    // num lub strunktura są nullami.
-    if (num == NULL || pf == NULL)
-        return;
-
-    bool isDigitNum = checkIfNumber(num);
-    int i = 0;
-    char c = num[i];
+/** @brief Porównuje fragment numeru węzła z napisem.
+ * @param[in] node - wskaźnik na węzeł;
+ * @param[in] start - pozycja początku fragmentu, nie mniejsza niż depth - LABEL_MAX;
+ * @param[in] end - pozycja końca fragmentu, nie większa niż depth;
+ * @param[in] num - wskaźnik na napis porównywany od pozycji start.
+ * @return Liczbę początkowych cyfr fragmentu zgodnych z napisem.
+ */
+static inline uint32_t matchDigits(PfNode const *node, uint32_t start, uint32_t end, char const *num) {
+    uint32_t p = 0;
 
-    // num nie reprezentuje numeru.
-    if (!isDigitNum || c == '\0')
-        return;
+    // pierwsza cyfra zajmuje drugą połowę bajtu.
+    if (start % 2 == 1 && start < end) {
+        if ((int) num[0] - (int) '0' != numberDigit(node, start))
+            return 0;
 
-    // poniższa pętla szuka miejsca, od którego przekierowania powinny być usunięte.
-    struct PhoneForward *temp = pf;
+        p = 1;
+    }
 
-    while (c != '\0') {
-        int x = (int) c - (int) '0';
+    // porównanie całymi bajtami, po dwie cyfry.
+    while (start + p + 1 < end && num[p] != '\0') {
+        unsigned pair = (uint8_t) (num[p] - '0') | ((unsigned) (uint8_t) (num[p + 1] - '0') << 4);
 
-        if (temp->digits[x] != NULL) {
-            temp = temp->digits[x];
-        }
-        // nie znaleziono przekierowań do usunięcia.
-        else
-            return;
+        if (pair != node->label[((start + p) % LABEL_MAX) >> 1])
+            break;
 
-        i++;
-        c = num[i];
+        p += 2;
     }
 
-    removeChosenNumbers(temp);
+    // koniec napisu nie jest cyfrą, więc porównanie się na nim zatrzyma.
+    while (start + p < end && (int) num[p] - (int) '0' == numberDigit(node, start + p))
+        p++;
+
+    return p;
 }
 
 
-/** @brief Tworzy pojedynczy element struktury PhoneNumbers,
- * ustawiając jednocześnie jego pola na NULL.
- * @return Wskaźnik na utworzony element struktury phoneNumbers.
+/** @brief Zapisuje fragment numeru węzła jako znaki.
+ * @param[in] node - wskaźnik na węzeł;
+ * @param[in] start - pozycja początku fragmentu, nie mniejsza niż depth - LABEL_MAX;
+ * @param[in] end - pozycja końca fragmentu, nie większa niż depth;
+ * @param[in] buf - bufor na end - start znaków.
  */
-static struct PhoneNumbers * createPhoneNumbers() {
-    struct PhoneNumbers *phnum = malloc(sizeof(struct PhoneNumbers));
-
-    phnum->next = NULL;
-    phnum->number = NULL;
-
-    return phnum;
+static inline void writeDigits(PfNode const *node, uint32_t start, uint32_t end, char *buf) {
+    for (uint32_t pos = start; pos < end; pos++)
+        buf[pos - start] = (char) ('0' + numberDigit(node, pos));
 }
 
 
-/** @brief Wyznacza przekierowanie podanego numeru dla funkcji pfwdGet.
- * @param[in] where  – wartość, wskazująca na miejsce, w którym skończy się
- *            przekierowanie w tworzonym numerze;
- * @param[in] num – wskaźnik na napis reprezentujący numer do przekierowania;
- * @param [in] foundNum – wskaźnik na napis reprezentujący znalezione przekierowanie;
- * @return Wskaźnik na nowo utworzony numer.
+/** @brief Porównuje leksykograficznie numery reprezentowane przez dwa węzły.
+ * Podnosi głębszy z węzłów (oba, gdy są równie głębokie) aż do wspólnego
+ * przodka, a następnie porównuje pierwsze cyfry etykiet synów tego przodka,
+ * leżących na ścieżkach obu węzłów. Kolejność węzłów w drzewie odpowiada
+ * kolejności ich numerów, a przodek poprzedza swoich potomków.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania;
+ * @param[in] a - indeks pierwszego węzła;
+ * @param[in] b - indeks drugiego węzła.
+ * @return Wartość ujemna, zero lub dodatnia, jak dla funkcji strcmp.
  */
-static char * createFinalNumber(char const *num, char *foundNum, int where) {
-    // obliczenie rozmiaru tablicy na tworzony numer.
-    // foundNum i num nie są nullami.
-    int numLength = (int) strlen(num);
-    int foundNumLength = (int) strlen(foundNum);
+static int compareNodes(struct PhoneForward const *pf, uint32_t a, uint32_t b) {
+    uint32_t lastA = NO_NODE;
+    uint32_t lastB = NO_NODE;
 
-    int n = numLength + 1 - where + foundNumLength;
+    while (a != b) {
+        PfNode const *nodeA = getNode(pf, a);
+        PfNode const *nodeB = getNode(pf, b);
 
-    char *finalNumber = malloc(sizeof(char)*n);
-    for (int j = 0; j < foundNumLength; j++) {
-        finalNumber[j] = foundNum[j];
-    }
+        if (nodeA->depth >= nodeB->depth) {
+            lastA = a;
+            a = nodeA->parent;
+        }
 
-    for (int j = where; j < numLength; j++) {
-        finalNumber[foundNumLength + j - where] = num[j];
+        if (nodeB->depth >= nodeA->depth) {
+            lastB = b;
+            b = nodeB->parent;
+        }
     }
-    finalNumber[n-1] = '\0';
 
-    return finalNumber;
+    // jeden z węzłów jest przodkiem drugiego.
+    if (lastA == NO_NODE)
+        return lastB == NO_NODE ? 0 : -1;
+
+    if (lastB == NO_NODE)
+        return 1;
+
+    return labelDigit(getNode(pf, lastA), 0) - labelDigit(getNode(pf, lastB), 0);
 }
 
 
-/** @brief Wyznacza przekierowanie numeru,
- * szuka najdłuższego pasującego prefiksu;
- * @param[in] pf  – wskaźnik na strukturę przechowującą przekierowania numerów;
- * @param[in] num – wskaźnik na napis reprezentujący numer;
- * @param[in] counter  – wskazuje, na to która cyfra z tablicy numerów jest aktualnie rozpatrywana;
- * @param[in] memoryProblems – zmienna, zmieni wartość na 1, jeśli wystąpią problemy z alokacją pamięci;
- * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
- *         udało się zaalokować pamięci.
+/** @brief Wyszukuje binarnie węzeł w posortowanej tablicy rev.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania;
+ * @param[in] rev - wskaźnik na tablicę rev;
+ * @param[in] idx - indeks szukanego węzła;
+ * @param[in] found - wskaźnik na zmienną, która przyjmie wartość true,
+ *            jeśli węzeł jest w tablicy.
+ * @return Pozycję węzła w tablicy lub pozycję, na której należy go wstawić.
  */
-static struct PhoneNumbers * findRightNumber(struct PhoneForward *pf, char const *num, int counter, int *memoryProblems) {
-    char c = num[counter]; // num nie jest nullem.
-    struct PhoneNumbers *prev = NULL;
-    int x = (int) c - (int) '0';
-
-    if (c != '\0' && pf->digits[x] != NULL) {
-        prev = findRightNumber(pf->digits[x], num, counter + 1, memoryProblems);
-    }
+static uint32_t findRevPosition(struct PhoneForward const *pf, RevArray const *rev, uint32_t idx, bool *found) {
+    uint32_t begin = 0;
+    uint32_t end = rev->count;
 
-    if (prev == NULL && pf->number == NULL)
-        return NULL;
-    else {
-        // nejdłuższy numer właśnie został znaleziony.
-        if (prev == NULL && pf->number != NULL) {
-            //tworzenie zwracanej struktury.
-            struct PhoneNumbers *pnum = createPhoneNumbers();
-            char *newNumber = createFinalNumber(num, pf->number, counter);
+    (*found) = false;
 
-            // problem z alokacją pamięci.
-            if (pnum == NULL || newNumber == NULL)
-                (*memoryProblems) = 1;
-            else
-                pnum->number = newNumber;
+    while (begin < end) {
+        uint32_t mid = begin + (end - begin) / 2;
+        int cmp = compareNodes(pf, rev->nums[mid], idx);
 
-            return pnum;
+        if (cmp == 0) {
+            (*found) = true;
+            return mid;
         }
+
+        if (cmp < 0)
+            begin = mid + 1;
         else
-            return prev;
+            end = mid;
     }
+
+    return begin;
 }
 
 
-struct PhoneNumbers const * phfwdGet(struct PhoneForward *pf, char const *num) {
-    if (pf == NULL || num == NULL)
-        return NULL;
+/** @brief Zmienia rozmiar tablicy rev.
+ * Używana tylko bez współbieżnych odczytów, przy których tablice rev są
+ * zastępowane kopiami (zob. reserveRevArray).
+ * @param[in] rev - wskaźnik na tablicę rev lub NULL;
+ * @param[in] capacity - nowa liczba miejsc, nie mniejsza niż liczba numerów w tablicy.
+ * @return Wskaźnik na tablicę o nowym rozmiarze lub NULL w przypadku problemów
+ *         z alokacją pamięci, tablica @p rev pozostaje wtedy niezmieniona.
+ */
+static RevArray * resizeRevArray(RevArray *rev, uint32_t capacity) {
+    return realloc(rev, sizeof(RevArray) + capacity * sizeof(uint32_t));
+}
 
-    struct PhoneNumbers *pnum;
 
-    bool isDigitNum = checkIfNumber(num);
-    // num nie reprezentuje numeru.
-    if (!isDigitNum || num[0] == '\0') {
-        pnum = createPhoneNumbers();
-    }
-    else {
-        // gdy wystąpią problemy z alokacją pamięci wartość zmiennej wyniesie 1.
-        int memoryProblems = 0;
-        pnum = findRightNumber(pf, num, 0, &memoryProblems); // pf nie jest nullem.
+/** @brief Zapewnia miejsce na kolejny węzeł w tablicy rev.
+ * Tworzy tablicę, jeśli jeszcze nie istnieje, lub ją powiększa, gdy jest pełna.
+ * Opublikowanej tablicy nie można zmieniać przy współbieżnych odczytach,
+ * więc wtedy przygotowywana jest jej kopia z miejscem na jeden węzeł więcej.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania;
+ * @param[in] node - wskaźnik na węzeł, do którego tablicy dodamy węzeł;
+ * @param[out] copy - wskaźnik na przygotowaną kopię lub NULL bez współbieżnych odczytów.
+ * @return Wartość @p true, jeśli jest miejsce na kolejny węzeł.
+ *         Wartość @p false w przypadku problemów z alokacją pamięci.
+ */
+static bool reserveRevArray(struct PhoneForward *pf, PfNode *node, RevArray **copy) {
+    RevArray *rev = node->rev;
 
-        // problem z alokacją pamięci.
-        if (memoryProblems == 1)
-            return NULL;
+    (*copy) = NULL;
 
-        // nie znaleziono żadnego przekierowania.
-        if (pnum == NULL) {
-            pnum = createPhoneNumbers();
-            char *newNumber = copyNumber(num);
+    if (pf->sync != NULL) {
+        uint32_t capacity = (rev != NULL ? rev->count : 0) + 1;
 
-            // problem z alokacją pamięci.
-            if (newNumber == NULL)
-                return NULL;
+        (*copy) = resizeRevArray(NULL, capacity);
 
-            pnum->number = newNumber;
-        }
-    }
+        if ((*copy) == NULL)
+            return false;
 
-    return pnum;
-}
+        (*copy)->capacity = capacity;
+        return true;
+    }
 
+    if (rev != NULL && rev->count < rev->capacity)
+        return true;
 
-/** @brief Zlicza elementy struktury PhoneNumbers,
- * @param[in] pnum  – wskaźnik na strukturę przechowującą numery telefonów;
- * @return Liczbę całkowitą, wskazującą na liczbę elementów strunktury PnhoneNumbers.
- */
-static int pnumElCounter(struct PhoneNumbers const *pnum) {
-    int counter = 0;
-    struct PhoneNumbers const *temp = pnum;
+    uint32_t capacity = rev == NULL ? 2 : 2 * rev->capacity;
+    RevArray *new = resizeRevArray(rev, capacity);
 
-    while (temp != NULL) {
-        counter++;
-        temp = temp->next;
-    }
+    // błędy z alokacją pamięci.
+    if (new == NULL)
+        return false;
 
-    return counter;
-}
+    if (rev == NULL)
+        new->count = 0;
 
+    new->capacity = capacity;
+    node->rev = new;
 
-char const * phnumGet(struct PhoneNumbers const *pnum, size_t idx) {
-    if (pnum ==  NULL)
-        return NULL;
+    return true;
+}
 
-    int idxInt = (int) idx;
-    int elAmount = pnumElCounter(pnum);
 
-    // index jest spoza zakresu.
-    if (elAmount <= idxInt)
-        return NULL;
+/** @brief Dodaje węzeł do tablicy rev, zachowując jej uporządkowanie.
+ * Miejsce musi być wcześniej zapewnione przez reserveRevArray. Kopia tablicy
+ * z dodanym węzłem jest publikowana jednym zapisem, a poprzednia tablica
+ * zwalniana, gdy nie mogą jej już czytać czytelnicy.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania;
+ * @param[in] node - wskaźnik na węzeł, do którego tablicy dodajemy węzeł;
+ * @param[in] copy - kopia przygotowana przez reserveRevArray lub NULL;
+ * @param[in] idx - indeks węzła, który dodajemy do tablicy.
+ */
+static void addRevListEl(struct PhoneForward *pf, PfNode *node, RevArray *copy, uint32_t idx) {
+    RevArray *rev = node->rev;
+    uint32_t count = rev != NULL ? rev->count : 0;
+    bool found = false;
+    uint32_t pos = rev != NULL ? findRevPosition(pf, rev, idx, &found) : 0;
+
+    // węzeł już jest w tablicy.
+    if (found) {
+        free(copy);
+        return;
+    }
 
-    // Szukanie właściwego numeru.
-    int counter = 0;
-    struct PhoneNumbers const *temp = pnum;
+    if (copy == NULL) {
+        memmove(rev->nums + pos + 1, rev->nums + pos, (count - pos) * sizeof(uint32_t));
+        rev->nums[pos] = idx;
+        rev->count++;
+        return;
+    }
 
-    while (counter < idxInt) {
-        counter++;
-        temp = temp->next;
+    if (rev != NULL) {
+        memcpy(copy->nums, rev->nums, pos * sizeof(uint32_t));
+        memcpy(copy->nums + pos + 1, rev->nums + pos, (count - pos) * sizeof(uint32_t));
     }
 
-    return temp->number;
+    copy->nums[pos] = idx;
+    copy->count = count + 1;
+
+    __atomic_store_n(&node->rev, copy, __ATOMIC_RELEASE);
+    retireMemory(pf, rev);
 }
 
 
-/** @brief Szuka miejsca w liście, w którym należy dodać jej nowy element,
- * aby numery były uporządkowane leksykograficznie.
- * @param[in] l - wskaźnik na strukturę PhoneNumbers, w której poszukujemy odpowiedniego miejsca;
- * @param[in] num - numer, który próbujemy umiejscowić w liście.
- * @param[in] alreadyExsist - wskaźnik na zmienną, przechowującąinformację o tym, czy dany numer
- *            został już wcześniej dodany. Jeśli w strukturze l natrafimy na numer num
- *            wartość zmiennej wyniesie true.
- * @return Wskaźnik na miejsce w strukturze PhoneNumbers, w którym należy dodać nowy element.
+/** @brief Usuwa węzeł z tablicy rev.
+ * Przy współbieżnych odczytach publikuje kopię tablicy bez usuwanego węzła
+ * (NULL, gdy tablica opustoszała). Jeśli zabraknie na nią pamięci, przesuwa
+ * numery w miejscu, od początku tablicy, a czytelnicy przeglądają ją od końca,
+ * więc żaden z pozostających numerów nie zostanie przez nich pominięty.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania;
+ * @param[in] node - wskaźnik na węzeł z niepustą tablicą rev;
+ * @param[in] idx - indeks usuwanego węzła.
  */
-static struct PhoneNumbers * findPlaceInList(struct PhoneNumbers *l, char const *num, bool *alreadyExsist) {
-    // poniższa pętla sprawdza, który numer jest większy.
-    while (l->next!=NULL && strcmp((l->next)->number, num) < 0) {
-        l = l->next;
+static void removeRevListEl(struct PhoneForward *pf, PfNode *node, uint32_t idx) {
+    RevArray *rev = node->rev;
+    bool found;
+    uint32_t pos = findRevPosition(pf, rev, idx, &found);
+
+    if (!found)
+        return;
+
+    if (pf->sync == NULL) {
+        memmove(rev->nums + pos, rev->nums + pos + 1, (rev->count - pos - 1) * sizeof(uint32_t));
+        rev->count--;
+        return;
     }
 
-    if (l->next!=NULL && strcmp((l->next)->number, num) == 0)
-        (*alreadyExsist) = true;
+    RevArray *copy = NULL;
 
-    return l;
-}
+    if (rev->count > 1) {
+        copy = resizeRevArray(NULL, rev->count - 1);
 
+        // problem z alokacją pamięci, przesuwamy numery w miejscu.
+        if (copy == NULL) {
+            for (uint32_t j = pos; j + 1 < rev->count; j++)
+                __atomic_store_n(&rev->nums[j], rev->nums[j + 1], __ATOMIC_RELEASE);
 
-/** @brief Funkcja pomocnicza dla funkcji phfwdReverse.
- * Dodaje kolejny elemnt struktury PhoneNumbers, zawierający numer num
- * do wynikowej listy funkcji phfwdReverse.
- * @param[in] num - wskaźnik na numer. który mamy dodać;
- * @param[in] place - wskaźnik na miejsce w strukturze PhoneNumbers,
- *            w którym ma zostać dodany nowy element, aby zachować
- *            porządek leksykograficzny numerów;
- * @param[in] memoryProblems - wskażnik na zmienną, przechowującą informację o tym,
- *            czy wystąpiły problemy z alokacją pamięci.
- **/
-static void addToFinalList(char *num, struct PhoneNumbers *place, bool *memoryProblems) {
-    struct PhoneNumbers *newEl = createPhoneNumbers();
-    struct PhoneNumbers *temp = place->next;
-
-    if (newEl == NULL) {
-        (*memoryProblems) = true;
-        return;
+            __atomic_store_n(&rev->count, rev->count - 1, __ATOMIC_RELEASE);
+            return;
+        }
+
+        memcpy(copy->nums, rev->nums, pos * sizeof(uint32_t));
+        memcpy(copy->nums + pos, rev->nums + pos + 1, (rev->count - pos - 1) * sizeof(uint32_t));
+        copy->count = rev->count - 1;
+        copy->capacity = rev->count - 1;
     }
 
-    place->next = newEl;
-    newEl->next = temp;
-    newEl->number = num;
+    __atomic_store_n(&node->rev, copy, __ATOMIC_RELEASE);
+    retireMemory(pf, rev);
 }
 
 
-/** @brief Funkcja pomocnicza dla funkcji phfwdReverse.
- * Tworzy numer dla odwrotnego przekierowania.
- * @param[in] usersNum - wskaźnik na numer otrzymany od użytkownika;
- * @param[in] where - liczba cyfr numeru usersNum, które należy pominąć
- *            (miejsce, odktóregomamy zacząć kopiować dane);
- * @param[in] revNum - numer odwrotnego przekierowania.
- * @return Wskaźnik na nowo utworzony numer wynikowy.
+/** @brief Zmniejsza tablicę rev, gdy jest w większości pusta.
+ * Kopie publikowane przy współbieżnych odczytach mają już najmniejszy rozmiar.
+ * W razie problemów z alokacją pamięci tablica pozostaje niezmieniona.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania;
+ * @param[in] node - wskaźnik na węzeł z niepustą tablicą rev.
  */
-static char * createReverseNumber(char const *usersNum, int where, char *revNum) {
-    size_t len1 = strlen(usersNum);
-    size_t len2 = strlen(revNum);
+static void shrinkRevArray(struct PhoneForward const *pf, PfNode *node) {
+    RevArray *rev = node->rev;
 
-    // dodana 1 rezerwuje miejsce na '\0'
-    size_t n = len1 - where + len2 + 1;
+    if (pf->sync != NULL || rev->capacity <= 2 || 4 * rev->count > rev->capacity)
+        return;
 
-    char *new = malloc(n * sizeof(char));
+    uint32_t capacity = rev->capacity / 2;
+    RevArray *new = resizeRevArray(rev, capacity);
 
     if (new == NULL)
-        return NULL;
+        return;
+
+    new->capacity = capacity;
+    node->rev = new;
+}
 
-    for (size_t j = 0; j < len2; j++)
-        new[j] = revNum[j];
 
-    for (size_t j = 0; j < len1 - where; j++)
-        new[len2 + j] = usersNum[where +j];
+/** @brief Zapisuje numer reprezentowany przez węzeł.
+ * Węzeł przechowuje ostatnie LABEL_MAX cyfr swojego numeru, więc numer
+ * nie dłuższy niż LABEL_MAX jest przepisywany z samego węzła. Dłuższy numer
+ * jest uzupełniany od końca cyframi przodków.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania;
+ * @param[in] idx - indeks węzła;
+ * @param[in] buf - bufor na co najmniej depth znaków węzła, numer nie jest
+ *            zakończony znakiem '\0'.
+ */
+static void writeKey(struct PhoneForward const *pf, uint32_t idx, char *buf) {
+    PfNode const *node = getNode(pf, idx);
+    uint32_t end = node->depth;
 
-    new[n - 1] = '\0';
+    while (end > 0) {
+        uint32_t start = node->depth > LABEL_MAX ? node->depth - LABEL_MAX : 0;
 
-    return new;
-}
+        // etykieta ma co najwyżej LABEL_MAX cyfr, więc ojciec nie jest płytszy niż end.
+        if (start < end) {
+            writeDigits(node, start, end, buf + start);
+            end = start;
+        }
 
+        if (end > 0)
+            node = getNode(pf, node->parent);
+    }
+}
 
-struct PhoneNumbers const * phfwdReverse(struct PhoneForward *pf, char const *num) {
-    if (pf == NULL || num == NULL)
-        return NULL;
 
-    bool isDigitNum = checkIfNumber(num);
-    // num nie reprezentuje numeru lub num jest pustym ciagiem.
-    if (!isDigitNum || num[0] == '\0')
-        return createPhoneNumbers();
+/** @brief Udostępnia czytelnikom oba pola kids węzła jednym zapisem.
+ * @param[in] node - wskaźnik na węzeł;
+ * @param[in] first - nowa wartość kids[0];
+ * @param[in] second - nowa wartość kids[1].
+ */
+static inline void publishKids(PfNode *node, uint32_t first, uint32_t second) {
+    union {
+        uint32_t kids[2];
+        uint64_t word;
+    } pair = {{first, second}};
 
+    __atomic_store_n(&node->kidsWord, pair.word, __ATOMIC_RELEASE);
+}
 
-    int i = 0;
-    char c = num[i];
-    char *newNum;
-    bool memoryProblems = false;
-    bool alreadyExsist = false;
-    struct PhoneNumbers *place;
-    struct PhoneNumbers *list = createPhoneNumbers();
-    struct PhoneForward *temp = pf;
 
-    // problemy z alokacją pamięci.
-    if (list == NULL)
-        return NULL;
+/** @brief Wyznacza syna węzła, którego etykieta zaczyna się od danej cyfry.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania;
+ * @param[in] node - wskaźnik na węzeł;
+ * @param[in] x - cyfra.
+ * @return Indeks syna lub NO_NODE, jeśli takiego syna nie ma.
+ */
+static inline uint32_t getChild(struct PhoneForward const *pf, PfNode const *node, int x) {
+    if (node->kind == NODE12)
+        return ((PfNode12*) poolGet(&pf->blocks12, node->kids[0]))->kids[x];
 
-    while (c != '\0') {
-        int x = (int) c - (int) '0';
+    if (node->kind == NODE4) {
+        PfNode4 *block = poolGet(&pf->blocks4, node->kids[0]);
 
-        temp = temp->digits[x];
+        for (int i = 0; i < 4; i++) {
+            if (block->kids[i] != NO_NODE && block->keys[i] == x)
+                return block->kids[i];
+        }
 
-        // napewno niżej nie ma żadnych przekierowań.
-        if (temp == NULL)
-            break;
+        return NO_NODE;
+    }
 
-        // dany numer posiada jakieś elementy na swojej liście rev.
-        if ((temp->rev)->next != NULL) {
-            List *l = temp->rev;
+    for (int i = 0; i < node->childCount; i++) {
+        if (node->keys[i] == x)
+            return node->kids[i];
+    }
 
-            // dodajemy numery reverse dla kolejnych numerów z listy rev danego węzła.
-            while (l->next != NULL) {
-                alreadyExsist = false;
-                l = l->next;
-                newNum = createReverseNumber(num, i + 1, l->revNum);
+    return NO_NODE;
+}
 
-                // problemy z alokacją pamięci.
-                if (newNum == NULL)
-                    return NULL;
 
-                place = findPlaceInList(list, newNum, &alreadyExsist);
+/** @brief Wypisuje synów węzła w kolejności ich cyfr.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania;
+ * @param[in] node - wskaźnik na węzeł;
+ * @param[in] keys - tablica, do której zostaną zapisane cyfry synów;
+ * @param[in] kids - tablica, do której zostaną zapisane indeksy synów.
+ * @return Liczbę synów węzła.
+ */
+static int listChildren(struct PhoneForward const *pf, PfNode const *node, uint8_t keys[], uint32_t kids[]) {
+    int counter = 0;
 
-                if (!alreadyExsist)
-                    addToFinalList(newNum, place, &memoryProblems);
-                else
-                    free(newNum);
+    if (node->kind == NODE12) {
+        PfNode12 *block = poolGet(&pf->blocks12, node->kids[0]);
 
-                if (memoryProblems)
-                    return NULL;
+        for (int i = 0; i < DIGITS; i++) {
+            if (block->kids[i] != NO_NODE) {
+                keys[counter] = (uint8_t) i;
+                kids[counter] = block->kids[i];
+                counter++;
             }
         }
 
-        i++;
-        c = num[i];
+        return counter;
     }
 
-    // dodanie numeru otrzymanego od uzytkownika.
-    alreadyExsist = false;
-    memoryProblems = false;
-    place = findPlaceInList(list, num, &alreadyExsist);
+    if (node->kind == NODE2) {
+        for (counter = 0; counter < node->childCount; counter++) {
+            keys[counter] = node->keys[counter];
+            kids[counter] = node->kids[counter];
+        }
 
-    if (!alreadyExsist) {
-        char *usersNum = copyNumber(num);
+        return counter;
+    }
 
-        // problem z alokacją pamięci.
-        if (usersNum == NULL)
-            return NULL;
+    PfNode4 *block = poolGet(&pf->blocks4, node->kids[0]);
 
-        addToFinalList(usersNum, place, &memoryProblems);
+    // synowie zajmują dowolne miejsca, wstawiamy ich według cyfr.
+    for (int i = 0; i < 4; i++) {
+        if (block->kids[i] == NO_NODE)
+            continue;
 
-        // problem z alokacją pamięci.
-        if (memoryProblems)
-            return NULL;
-    }
+        int j = counter;
 
-    // usuwanie pierwszego, pustego elementu.
-    struct PhoneNumbers *p = list;
-    list = list->next;
-    free(p);
+        while (j > 0 && keys[j - 1] > block->keys[i]) {
+            keys[j] = keys[j - 1];
+            kids[j] = kids[j - 1];
+            j--;
+        }
+
+        keys[j] = block->keys[i];
+        kids[j] = block->kids[i];
+        counter++;
+    }
+
+    return counter;
+}
+
+
+/** @brief Zmienia rodzaj węzła, przenosząc jego synów do tablicy odpowiedniego rozmiaru.
+ * Nowa tablica jest udostępniana czytelnikom dopiero po wypełnieniu,
+ * a poprzednia zwalniana, gdy nie mogą jej już odczytywać.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania;
+ * @param[in] node - wskaźnik na węzeł;
+ * @param[in] kind - nowy rodzaj węzła, mieszczący wszystkich jego synów.
+ * @return Wartość @p true, jeśli udało się zmienić rodzaj węzła.
+ *         Wartość @p false w przypadku problemów z alokacją pamięci,
+ *         węzeł pozostaje wtedy niezmieniony.
+ */
+static bool changeKind(struct PhoneForward *pf, PfNode *node, uint8_t kind) {
+    uint8_t keys[DIGITS];
+    uint32_t kids[DIGITS];
+    int n = listChildren(pf, node, keys, kids);
+    uint32_t block = NO_NODE;
+
+    if (kind == NODE4)
+        block = poolAlloc(pf, &pf->blocks4);
+    else if (kind == NODE12)
+        block = poolAlloc(pf, &pf->blocks12);
+
+    // problem z alokacją pamięci.
+    if (kind != NODE2 && block == NO_NODE)
+        return false;
+
+    uint8_t oldKind = node->kind;
+    uint32_t oldBlock = node->kids[0];
+
+    if (kind == NODE2) {
+        for (int i = 0; i < n; i++)
+            __atomic_store_n(&node->keys[i], keys[i], __ATOMIC_RELAXED);
+
+        publishKids(node, n > 0 ? kids[0] : NO_NODE, n > 1 ? kids[1] : NO_NODE);
+    }
+    else if (kind == NODE4) {
+        PfNode4 *newBlock = poolGet(&pf->blocks4, block);
+
+        for (int i = 0; i < 4; i++) {
+            newBlock->keys[i] = i < n ? keys[i] : 0;
+            newBlock->kids[i] = i < n ? kids[i] : NO_NODE;
+        }
+
+        publishKids(node, block, KIDS_NODE4);
+    }
+    else {
+        PfNode12 *newBlock = poolGet(&pf->blocks12, block);
+
+        for (int i = 0; i < DIGITS; i++)
+            newBlock->kids[i] = NO_NODE;
+
+        for (int i = 0; i < n; i++)
+            newBlock->kids[keys[i]] = kids[i];
+
+        publishKids(node, block, KIDS_NODE12);
+    }
+
+    node->kind = kind;
+
+    // zwolnienie dotychczasowej tablicy synów.
+    if (oldKind == NODE4)
+        retireElement(pf, &pf->blocks4, oldBlock);
+    else if (oldKind == NODE12)
+        retireElement(pf, &pf->blocks12, oldBlock);
+
+    return true;
+}
+
+
+/** @brief Ustawia syna węzła pod daną cyfrą.
+ * Zastępuje istniejącego syna lub dodaje nowego, w razie potrzeby
+ * powiększając tablicę synów. Zmiana jest udostępniana czytelnikom
+ * jednym zapisem.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania;
+ * @param[in] node - wskaźnik na węzeł;
+ * @param[in] x - cyfra, od której zaczyna się etykieta syna;
+ * @param[in] child - indeks syna, różny od NO_NODE.
+ * @return Wartość @p true, jeśli udało się ustawić syna.
+ *         Wartość @p false w przypadku problemów z alokacją pamięci.
+ */
+static bool setChild(struct PhoneForward *pf, PfNode *node, int x, uint32_t child) {
+    if (node->kind == NODE12) {
+        PfNode12 *block = poolGet(&pf->blocks12, node->kids[0]);
+
+        if (block->kids[x] == NO_NODE)
+            node->childCount++;
+
+        __atomic_store_n(&block->kids[x], child, __ATOMIC_RELEASE);
+
+        return true;
+    }
+
+    if (node->kind == NODE4) {
+        PfNode4 *block = poolGet(&pf->blocks4, node->kids[0]);
+        int empty = -1;
+
+        for (int i = 0; i < 4; i++) {
+            if (block->kids[i] == NO_NODE) {
+                if (empty < 0)
+                    empty = i;
+            }
+            else if (block->keys[i] == x) {
+                // syn o tej cyfrze już istnieje, zastępujemy go.
+                __atomic_store_n(&block->kids[i], child, __ATOMIC_RELEASE);
+                return true;
+            }
+        }
+
+        // tablica synów jest pełna, powiększamy węzeł.
+        if (empty < 0) {
+            if (!changeKind(pf, node, NODE12))
+                return false;
+
+            return setChild(pf, node, x, child);
+        }
+
+        __atomic_store_n(&block->keys[empty], (uint8_t) x, __ATOMIC_RELAXED);
+        __atomic_store_n(&block->kids[empty], child, __ATOMIC_RELEASE);
+        node->childCount++;
+
+        return true;
+    }
+
+    uint8_t keys[2] = {node->keys[0], node->keys[1]};
+    uint32_t kids[2] = {node->kids[0], node->kids[1]};
+    int i = 0;
+
+    while (i < node->childCount && keys[i] < x)
+        i++;
+
+    // syn o tej cyfrze już istnieje, zastępujemy go.
+    if (i < node->childCount && keys[i] == x) {
+        kids[i] = child;
+        publishKids(node, kids[0], kids[1]);
+        return true;
+    }
+
+    // tablica synów jest pełna, powiększamy węzeł.
+    if (node->childCount == 2) {
+        if (!changeKind(pf, node, NODE4))
+            return false;
+
+        return setChild(pf, node, x, child);
+    }
+
+    // wstawienie nowego syna z zachowaniem porządku cyfr.
+    if (i == 0 && node->childCount == 1) {
+        keys[1] = keys[0];
+        kids[1] = kids[0];
+    }
+
+    keys[i] = (uint8_t) x;
+    kids[i] = child;
+
+    for (int j = 0; j <= node->childCount; j++)
+        __atomic_store_n(&node->keys[j], keys[j], __ATOMIC_RELAXED);
+
+    publishKids(node, kids[0], kids[1]);
+    node->childCount++;
+
+    return true;
+}
+
+
+/** @brief Usuwa syna węzła spod danej cyfry.
+ * Gdy synów zostaje mało, przenosi ich do mniejszej tablicy.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania;
+ * @param[in] node - wskaźnik na węzeł;
+ * @param[in] x - cyfra, od której zaczyna się etykieta usuwanego syna.
+ */
+static void removeChild(struct PhoneForward *pf, PfNode *node, int x) {
+    if (node->kind == NODE12) {
+        PfNode12 *block = poolGet(&pf->blocks12, node->kids[0]);
+
+        __atomic_store_n(&block->kids[x], NO_NODE, __ATOMIC_RELEASE);
+        node->childCount--;
+
+        // w razie problemów z alokacją pamięci węzeł pozostaje większy.
+        if (node->childCount <= 4)
+            changeKind(pf, node, node->childCount <= 2 ? NODE2 : NODE4);
+
+        return;
+    }
+
+    if (node->kind == NODE4) {
+        PfNode4 *block = poolGet(&pf->blocks4, node->kids[0]);
+
+        for (int i = 0; i < 4; i++) {
+            if (block->kids[i] != NO_NODE && block->keys[i] == x)
+                __atomic_store_n(&block->kids[i], NO_NODE, __ATOMIC_RELEASE);
+        }
+
+        node->childCount--;
+
+        if (node->childCount <= 2)
+            changeKind(pf, node, NODE2);
+
+        return;
+    }
+
+    // pozostały syn przechodzi na pierwsze miejsce, puste miejsce ma indeks NO_NODE.
+    if (node->keys[0] == x) {
+        if (node->childCount == 2)
+            __atomic_store_n(&node->keys[0], node->keys[1], __ATOMIC_RELAXED);
+
+        publishKids(node, node->kids[1], NO_NODE);
+    }
+    else {
+        publishKids(node, node->kids[0], NO_NODE);
+    }
+
+    node->childCount--;
+}
+
+
+/** @brief Zwalnia wynik wpisu pamięci podręcznej, jeśli był alokowany osobno.
+ * @param[in] entry - wskaźnik na wpis.
+ */
+static inline void releaseResult(ResultEntry *entry) {
+    if (!entry->inSlot)
+        free(entry->result);
+}
+
+
+/** @brief Usuwa pamięć podręczną wyników wraz z zapamiętanymi wynikami.
+ * Nic nie robi, jeśli wskaźnik @p cache ma wartość NULL.
+ * @param[in] cache - wskaźnik na pamięć podręczną.
+ */
+static void deleteResultCache(ResultCache *cache) {
+    if (cache == NULL)
+        return;
+
+    for (uint32_t i = 1; i <= cache->count; i++)
+        releaseResult(&cache->entries[i]);
+
+    free(cache->entries);
+    free(cache->slots);
+    free(cache->buckets);
+    free(cache);
+}
+
+
+void phfwdDelete(struct PhoneForward *pf) {
+    if (pf == NULL)
+        return;
+
+    deleteResultCache(pf->results);
+
+    // węzły leżą w blokach, wystarczy liniowo zwolnić należące do nich tablice.
+    for (uint32_t i = ROOT_NODE; i < pf->nodes.count; i++) {
+        PfNode *node = getNode(pf, i);
+
+        if (node->rev != NULL)
+            free(node->rev);
+    }
+
+    free(pf->pending);
+
+    // nikt już nie odczytuje struktury, zwalniamy całą odłączoną pamięć.
+    if (pf->sync != NULL) {
+        for (size_t parity = 0; parity < 2; parity++) {
+            freeLimbo(pf->sync, parity);
+            free(pf->sync->limbo[parity]);
+        }
+
+        pthread_mutex_destroy(&pf->sync->writeLock);
+        free(pf->sync);
+    }
+
+    // usunięcie całych bloków węzłów i tablic synów.
+    poolDelete(&pf->nodes);
+    poolDelete(&pf->blocks4);
+    poolDelete(&pf->blocks12);
+
+    free(pf);
+}
+
+
+/** @brief Kopiuje pulę elementów wraz z jej blokami.
+ * W przypadku niepowodzenia pula docelowa pozostaje pusta.
+ * @param[out] dst - wskaźnik na kopię puli;
+ * @param[in] src - wskaźnik na kopiowaną pulę.
+ * @return Wartość @p true, jeśli się udało.
+ *         Wartość @p false w przypadku problemów z alokacją pamięci.
+ */
+static bool poolCopy(PfPool *dst, PfPool const *src) {
+    poolInit(dst, src->elSize);
+
+    if (src->slabCapacity == 0)
+        return true;
+
+    dst->slabs = malloc(src->slabCapacity * sizeof(char*));
+
+    // problem z alokacją pamięci.
+    if (dst->slabs == NULL)
+        return false;
+
+    dst->slabCapacity = src->slabCapacity;
+
+    for (size_t i = 0; i < src->slabCount; i++) {
+        char *slab = malloc(SLAB_SIZE * src->elSize);
+
+        // problem z alokacją pamięci, usuwamy skopiowane bloki.
+        if (slab == NULL) {
+            poolDelete(dst);
+            poolInit(dst, src->elSize);
+            return false;
+        }
+
+        memcpy(slab, src->slabs[i], SLAB_SIZE * src->elSize);
+        dst->slabs[i] = slab;
+        dst->slabCount++;
+    }
+
+    dst->count = src->count;
+    dst->freeList = src->freeList;
+
+    return true;
+}
+
+
+struct PhoneForward * phfwdClone(struct PhoneForward const *pf) {
+    if (pf == NULL)
+        return NULL;
+
+    struct PhoneForward *copy = malloc(sizeof(struct PhoneForward));
+
+    if (copy == NULL)
+        return NULL;
+
+    bool ok = poolCopy(&copy->blocks4, &pf->blocks4);
+    ok = poolCopy(&copy->blocks12, &pf->blocks12) && ok;
+    ok = poolCopy(&copy->nodes, &pf->nodes) && ok;
+    copy->pending = NULL;
+    copy->pendingCount = 0;
+    copy->pendingCapacity = 0;
+    copy->generation = 1;
+    memset(copy->countCache, 0, sizeof(copy->countCache));
+    copy->countThreads = pf->countThreads;
+    copy->sync = NULL;
+    copy->results = NULL;
+
+    // skopiowane węzły wskazują na tablice rev oryginału, zastępujemy je kopiami.
+    for (uint32_t i = ROOT_NODE; i < copy->nodes.count; i++) {
+        PfNode *node = getNode(copy, i);
+
+        if (node->rev == NULL)
+            continue;
+
+        RevArray *rev = NULL;
+
+        if (ok) {
+            size_t size = sizeof(RevArray) + node->rev->capacity * sizeof(uint32_t);
+
+            rev = malloc(size);
+
+            if (rev != NULL)
+                memcpy(rev, node->rev, size);
+            else ok = false;
+        }
+
+        node->rev = rev;
+    }
+
+    // problem z alokacją pamięci.
+    if (!ok) {
+        phfwdDelete(copy);
+        return NULL;
+    }
+
+    return copy;
+}
+
+
+/** @brief Tworzy pojedynczy węzeł struktury PhoneForward.
+ * Ustawia pola węzła na nulle.
+ * @param[in] pf - wskaźnik na strukturę, w której tworzymy węzeł.
+ * @return Indeks nowo utworzonego węzła lub NO_NODE w przypadku problemów z alokacją pamięci.
+ */
+static uint32_t createNewElement(struct PhoneForward *pf) {
+    uint32_t idx = poolAlloc(pf, &pf->nodes);
+
+    // problem z alokacją pamięci.
+    if (idx == NO_NODE)
+        return NO_NODE;
+
+    PfNode *newEl = getNode(pf, idx);
+
+    newEl->kidsWord = 0;
+    newEl->keys[0] = 0;
+    newEl->keys[1] = 0;
+    newEl->kind = NODE2;
+    newEl->childCount = 0;
+    newEl->labelLen = 0;
+    newEl->depth = 0;
+    newEl->minRevDepth = NO_REVERSE;
+    newEl->parent = NO_NODE;
+    newEl->target = NO_NODE;
+    newEl->rev = NULL;
+
+    return idx;
+}
+
+
+/** @brief Zwalnia pojedynczy węzeł struktury PhoneForward.
+ * Węzeł trafia na listę zwolnionych i zostanie wykorzystany ponownie, gdy nie
+ * mogą go już odczytywać czytelnicy. Węzeł nie może przechowywać przekierowania
+ * ani niepustej tablicy rev. Może mieć jednego syna, jeśli został scalony z nim
+ * (zob. tidyChild): syn pozostaje wtedy osiągalny dla czytelników, którzy
+ * jeszcze znajdują się w węźle. Do czasu ponownego wykorzystania węzeł ma
+ * pustą etykietę.
+ * @param[in] pf - wskaźnik na strukturę, do której należy węzeł;
+ * @param[in] idx - indeks zwalnianego węzła.
+ */
+static void freeElement(struct PhoneForward *pf, uint32_t idx) {
+    PfNode *node = getNode(pf, idx);
+
+    // usunięcie pustej tablicy rev.
+    retireMemory(pf, node->rev);
+    __atomic_store_n(&node->rev, NULL, __ATOMIC_RELEASE);
+
+    // węzeł mógł pozostać większy po nieudanym zmniejszeniu.
+    if (node->kind == NODE4)
+        retireElement(pf, &pf->blocks4, node->kids[0]);
+    else if (node->kind == NODE12)
+        retireElement(pf, &pf->blocks12, node->kids[0]);
+
+    // pusta etykieta oznacza zwolniony węzeł (zob. pruneUp).
+    node->labelLen = 0;
+
+    retireElement(pf, &pf->nodes, idx);
+}
+
+
+/// Tablica potęg powers[a][b] = a^b dla b < POWER_LIMIT.
+static size_t powers[DIGITS + 1][POWER_LIMIT];
+
+/// Informacja o tym, czy tablica powers została już wypełniona.
+static bool powersReady = false;
+
+
+/** @brief Wypełnia tablicę potęg, jeśli nie zrobiono tego wcześniej.
+ */
+static void initPowers(void) {
+    if (powersReady)
+        return;
+
+    for (size_t a = 0; a <= DIGITS; a++) {
+        powers[a][0] = 1;
+
+        for (size_t b = 1; b < POWER_LIMIT; b++)
+            powers[a][b] = powers[a][b - 1] * a;
+    }
+
+    powersReady = true;
+}
+
+
+struct PhoneForward * phfwdNew(void) {
+    struct PhoneForward *pf = malloc(sizeof(struct PhoneForward));
+
+    if (pf == NULL)
+        return NULL;
+
+    poolInit(&pf->nodes, sizeof(PfNode));
+    poolInit(&pf->blocks4, sizeof(PfNode4));
+    poolInit(&pf->blocks12, sizeof(PfNode12));
+    pf->pending = NULL;
+    pf->pendingCount = 0;
+    pf->pendingCapacity = 0;
+    pf->generation = 1;
+    memset(pf->countCache, 0, sizeof(pf->countCache));
+    pf->countThreads = 1;
+    pf->sync = NULL;
+    pf->results = NULL;
+    initPowers();
+
+    // problem z alokacją pamięci.
+    if (createNewElement(pf) != ROOT_NODE) {
+        phfwdDelete(pf);
+        return NULL;
+    }
+
+    return pf;
+}
+
+
+bool phfwdEnableConcurrentReads(struct PhoneForward *pf) {
+    if (pf == NULL)
+        return false;
+
+    if (pf->sync != NULL)
+        return true;
+
+    // liczniki czytelników są wyrównane do linii pamięci podręcznej.
+    PfSync *sync = aligned_alloc(CACHE_LINE, sizeof(PfSync));
+
+    if (sync == NULL)
+        return false;
+
+    memset(sync, 0, sizeof(PfSync));
+
+    if (pthread_mutex_init(&sync->writeLock, NULL) != 0) {
+        free(sync);
+        return false;
+    }
+
+    pf->sync = sync;
+
+    return true;
+}
+
+
+bool phfwdEnableResultCache(struct PhoneForward *pf, size_t capacity) {
+    if (pf == NULL || capacity >= UINT32_MAX)
+        return false;
+
+    deleteResultCache(pf->results);
+    pf->results = NULL;
+
+    if (capacity == 0)
+        return true;
+
+    ResultCache *cache = malloc(sizeof(ResultCache));
+    uint64_t bucketCount = 1;
+
+    // kubełków jest co najmniej dwa razy więcej niż wpisów, by listy były krótkie.
+    while (bucketCount < 2 * (uint64_t) capacity)
+        bucketCount *= 2;
+
+    if (cache != NULL) {
+        cache->entries = malloc((capacity + 1) * sizeof(ResultEntry));
+        cache->slots = malloc(capacity * RESULT_SLOT);
+        cache->buckets = calloc(bucketCount, sizeof(uint32_t));
+    }
+
+    // problem z alokacją pamięci.
+    if (cache == NULL || cache->entries == NULL || cache->slots == NULL || cache->buckets == NULL) {
+        if (cache != NULL) {
+            free(cache->entries);
+            free(cache->slots);
+            free(cache->buckets);
+        }
+
+        free(cache);
+        return false;
+    }
+
+    cache->capacity = (uint32_t) capacity;
+    cache->count = 0;
+    cache->bucketMask = bucketCount - 1;
+    cache->newest = 0;
+    cache->oldest = 0;
+    cache->hits = 0;
+    cache->misses = 0;
+    cache->evictions = 0;
+    pf->results = cache;
+
+    return true;
+}
+
+
+bool phfwdResultCacheStats(struct PhoneForward const *pf, struct PhfwdCacheStats *stats) {
+    if (pf == NULL || pf->results == NULL || stats == NULL)
+        return false;
+
+    stats->hits = pf->results->hits;
+    stats->misses = pf->results->misses;
+    stats->evictions = pf->results->evictions;
+    stats->entries = pf->results->count;
+
+    return true;
+}
+
+
+#if defined(__SSE2__)
+
+/** @brief Wyznacza, które znaki bloku należą do alfabetu numerów.
+ * @param[in] chars – blok 16 znaków.
+ * @return Maska, której i-ty bit jest ustawiony, gdy i-ty znak należy do alfabetu.
+ */
+static inline unsigned numberMask(__m128i chars) {
+    __m128i valid = _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)),
+                                  _mm_cmplt_epi8(chars, _mm_set1_epi8(';' + 1)));
+
+    return (unsigned) _mm_movemask_epi8(valid);
+}
+
+/** @brief Sprawdza, czy 16 kolejnych znaków należy do alfabetu numerów.
+ * @param[in] block – wskaźnik na pierwszy ze znaków.
+ * @return Wartość @p true, jeśli wszystkie znaki należą do alfabetu numerów.
+ */
+static inline bool block16IsNumber(char const *block) {
+    return numberMask(_mm_loadu_si128((__m128i const*) block)) == 0xFFFF;
+}
+
+/** @brief Sprawdza, czy 8 kolejnych znaków należy do alfabetu numerów.
+ * @param[in] block – wskaźnik na pierwszy ze znaków.
+ * @return Wartość @p true, jeśli wszystkie znaki należą do alfabetu numerów.
+ */
+static inline bool block8IsNumber(char const *block) {
+    return (numberMask(_mm_loadl_epi64((__m128i const*) block)) & 0xFF) == 0xFF;
+}
+
+#endif
+
+#if defined(__AVX2__)
+
+/** @brief Sprawdza, czy 32 kolejne znaki należą do alfabetu numerów.
+ * @param[in] block – wskaźnik na pierwszy ze znaków.
+ * @return Wartość @p true, jeśli wszystkie znaki należą do alfabetu numerów.
+ */
+static inline bool block32IsNumber(char const *block) {
+    __m256i chars = _mm256_loadu_si256((__m256i const*) block);
+    __m256i valid = _mm256_and_si256(_mm256_cmpgt_epi8(chars, _mm256_set1_epi8('0' - 1)),
+                                     _mm256_cmpgt_epi8(_mm256_set1_epi8(';' + 1), chars));
+
+    return (uint32_t) _mm256_movemask_epi8(valid) == UINT32_MAX;
+}
+
+#endif
+
+/** @brief Sprawdza, czy napis jest numerem, i wyznacza jego długość.
+ * Po wyznaczeniu długości napisu sprawdza go blokami po 32, 16 lub 8 znaków,
+ * zależnie od jego długości i dostępnych instrukcji. Ostatni blok kończy się
+ * razem z napisem i może zachodzić na poprzedni, więc czytane są tylko znaki
+ * napisu. Napisy krótsze od bloku są sprawdzane znak po znaku.
+ * @param[in] num – wskaźnik na napis reprezentujący potencjalny numer;
+ * @param[out] length - długość numeru, ustawiana tylko, gdy napis jest numerem.
+ * @return Wartość @p true, jeśli wszystkie znaki należą do alfabetu numerów.
+ */
+static bool scanNumber(char const *num, size_t *length) {
+    size_t len = strlen(num);
+    bool valid = true;
+
+#if defined(__AVX2__)
+    if (len >= 32) {
+        for (size_t i = 0; valid && i + 32 < len; i += 32)
+            valid = block32IsNumber(num + i);
+
+        valid = valid && block32IsNumber(num + len - 32);
+    }
+    else
+#endif
+#if defined(__SSE2__)
+    if (len >= 16) {
+        for (size_t i = 0; valid && i + 16 < len; i += 16)
+            valid = block16IsNumber(num + i);
+
+        valid = valid && block16IsNumber(num + len - 16);
+    }
+    else if (len >= 8) {
+        valid = block8IsNumber(num) && block8IsNumber(num + len - 8);
+    }
+    else
+#endif
+    {
+        for (size_t i = 0; valid && i < len; i++) {
+            // cyfry oraz znaki ':' i ';' leżą w ASCII obok siebie.
+            valid = num[i] >= '0' && num[i] <= ';';
+        }
+    }
+
+    if (valid)
+        (*length) = len;
+
+    return valid;
+}
+
+
+/** @brief Sprawdza, czy otrzymana tablica znaków zawiera numer.
+ * @param[in] num – wskaźnik na napis reprezentujący potencjalny numer.
+ * @return Wartość @p true, jeśli wszystkie znaki są cyframi,
+ *         Wartość @p false, jeśli chociaż jeden znak okazał się nie być cyfrą.
+ */
+static inline bool checkIfNumber(char const *num) {
+    size_t length;
+
+    return scanNumber(num, &length);
+}
+
+
+/** @brief Sprawdza, czy węzeł przechowuje przekierowanie lub przekierowania na swój numer.
+ * @param[in] node - wskaźnik na węzeł.
+ * @return Wartość @p true, jeśli węzeł jest potrzebny niezależnie od swoich synów.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static inline bool isUsed(PfNode const *node) {
+    return node->target != NO_NODE || hasReverse(node);
+}
+
+
+/** @brief Wyznacza długość wspólnego prefiksu etykiety węzła i numeru.
+ * @param[in] node - wskaźnik na węzeł;
+ * @param[in] num - wskaźnik na napis reprezentujący (pozostałą część) numeru.
+ * @return Liczbę początkowych cyfr etykiety zgodnych z numerem.
+ */
+static inline int commonPrefix(PfNode const *node, char const *num) {
+    return (int) matchDigits(node, node->depth - node->labelLen, node->depth, num);
+}
+
+
+/** @brief Uaktualnia pola minRevDepth węzła i jego przodków.
+ * Wywoływana, gdy tablica rev węzła staje się pusta lub przestaje być pusta.
+ * Rozdzielanie i scalanie krawędzi ani usuwanie pustych węzłów nie zmieniają
+ * tych pól u pozostałych węzłów.
+ * @param[in] pf - wskaźnik na strukturę PhoneForward;
+ * @param[in] idx - indeks węzła, którego tablica rev się zmieniła.
+ */
+static void updateRevDepth(struct PhoneForward *pf, uint32_t idx) {
+    while (idx != NO_NODE) {
+        PfNode *node = getNode(pf, idx);
+        uint32_t minDepth = NO_REVERSE;
+
+        if (hasReverse(node)) {
+            minDepth = node->depth;
+        }
+        else {
+            uint8_t keys[DIGITS];
+            uint32_t kids[DIGITS];
+            int n = listChildren(pf, node, keys, kids);
+
+            for (int i = 0; i < n; i++) {
+                uint32_t childDepth = getNode(pf, kids[i])->minRevDepth;
+
+                if (childDepth < minDepth)
+                    minDepth = childDepth;
+            }
+        }
+
+        // wyżej nic się nie zmieni.
+        if (node->minRevDepth == minDepth)
+            return;
+
+        node->minRevDepth = minDepth;
+        idx = node->parent;
+    }
+}
+
+
+/** @brief Odkłada węzeł, który mógł przestać być potrzebny.
+ * Węzeł i jego przodkowie zostaną uporządkowani w funkcji prunePending,
+ * gdy żadna operacja nie będzie już przechowywać wskaźników na węzły drzewa.
+ * Jeśli nie uda się go odłożyć, węzeł pozostaje w drzewie.
+ * @param[in] pf - wskaźnik na strukturę PhoneForward;
+ * @param[in] idx - indeks odkładanego węzła.
+ */
+static void deferPrune(struct PhoneForward *pf, uint32_t idx) {
+    if (pf->pendingCount == pf->pendingCapacity) {
+        size_t newCapacity = pf->pendingCapacity == 0 ? 4 : 2 * pf->pendingCapacity;
+        uint32_t *newPending = realloc(pf->pending, newCapacity * sizeof(uint32_t));
+
+        // problem z alokacją pamięci, węzeł pozostanie w drzewie.
+        if (newPending == NULL)
+            return;
+
+        pf->pending = newPending;
+        pf->pendingCapacity = newCapacity;
+    }
+
+    pf->pending[pf->pendingCount] = idx;
+    pf->pendingCount++;
+}
+
+
+/** @brief Usuwa węzeł z tablicy rev celu jego przekierowania.
+ * Jeśli tablica ta opustoszała, węzeł docelowy jest odkładany do uporządkowania.
+ * Samo przekierowanie węzła pozostaje niezmienione.
+ * @param[in] pf - wskaźnik na strukturę PhoneForward;
+ * @param[in] idx - indeks węzła z przekierowaniem.
+ */
+static void detachForwarding(struct PhoneForward *pf, uint32_t idx) {
+    uint32_t targetIdx = getNode(pf, idx)->target;
+    PfNode *target = getNode(pf, targetIdx);
+
+    removeRevListEl(pf, target, idx);
+
+    if (hasReverse(target)) {
+        shrinkRevArray(pf, target);
+    }
+    else {
+        updateRevDepth(pf, targetIdx);
+        deferPrune(pf, targetIdx);
+    }
+}
+
+
+/** @brief Usuwa przekierowanie węzła.
+ * Usuwa również węzeł z tablicy rev węzła docelowego. Jeśli tablica
+ * ta opustoszała, węzeł docelowy jest odkładany do uporządkowania.
+ * @param[in] pf - wskaźnik na strukturę PhoneForward;
+ * @param[in] idx - indeks węzła z przekierowaniem.
+ */
+static void removeForwarding(struct PhoneForward *pf, uint32_t idx) {
+    detachForwarding(pf, idx);
+    __atomic_store_n(&getNode(pf, idx)->target, NO_NODE, __ATOMIC_RELEASE);
+}
+
+
+/** @brief Porządkuje syna węzła po usunięciu przekierowań.
+ * Usuwa syna, który nie przechowuje żadnych informacji i nie ma synów,
+ * a pustego syna z jednym synem scala z nim, jeśli ich etykiety zmieszczą się
+ * w jednym węźle.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] parent - wskaźnik na węzeł, którego syna porządkujemy;
+ * @param[in] x - cyfra, pod którą znajduje się porządkowany syn.
+ */
+static void tidyChild(struct PhoneForward *pf, PfNode *parent, int x) {
+    uint32_t child = getChild(pf, parent, x);
+
+    if (child == NO_NODE)
+        return;
+
+    PfNode *childNode = getNode(pf, child);
+    uint8_t keys[DIGITS];
+    uint32_t kids[DIGITS];
+
+    if (isUsed(childNode))
+        return;
+
+    int n = listChildren(pf, childNode, keys, kids);
+
+    if (n == 0) {
+        removeChild(pf, parent, x);
+        freeElement(pf, child);
+    }
+    else if (n == 1) {
+        uint32_t grandson = kids[0];
+        PfNode *grandsonNode = getNode(pf, grandson);
+
+        // etykieta scalonej krawędzi nie zmieściłaby się w węźle.
+        if (childNode->labelLen + grandsonNode->labelLen > LABEL_MAX)
+            return;
+
+        // numer wnuka się nie zmienia, wystarczy wydłużyć jego etykietę. Zwolniony
+        // syn nadal wskazuje na wnuka, więc dojdą do niego czytelnicy, którzy są w synu.
+        setChild(pf, parent, x, grandson);
+        grandsonNode->labelLen = (uint8_t) (grandsonNode->labelLen + childNode->labelLen);
+        __atomic_store_n(&grandsonNode->parent, childNode->parent, __ATOMIC_RELEASE);
+        freeElement(pf, child);
+    }
+}
+
+
+/** @brief Usuwa wybrane przekierowania ze struktury PhoneForward,
+ * Wskaźnik na usunięte pola ustawia na NULL, a opustoszałych synów usuwa.
+ * @param[in] pf  – wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] idx – indeks węzła, od którego usuwamy przekierowania.
+ */
+static void removeChosenNumbers(struct PhoneForward *pf, uint32_t idx) {
+    if (idx == NO_NODE)
+        return;
+    else {
+        PfNode *node = getNode(pf, idx);
+        uint8_t keys[DIGITS];
+        uint32_t kids[DIGITS];
+        int n = listChildren(pf, node, keys, kids);
+
+        // porządkowanie synów może zmienić tablicę synów, dlatego przeglądamy jej kopię.
+        for (int i = 0; i < n; i++) {
+            removeChosenNumbers(pf, kids[i]);
+            tidyChild(pf, node, keys[i]);
+        }
+
+        if (node->target != NO_NODE)
+            removeForwarding(pf, idx);
+    }
+}
+
+
+/** @brief Funkcja pomocnicza do phfwdRemove.
+ * Schodzi w głąb drzewa do miejsca, od którego przekierowania powinny być usunięte,
+ * a wracając porządkuje węzły na ścieżce.
+ * @param[in] pf  – wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] node – wskaźnik na węzeł, którego numer jest prefiksem usuwanego numeru;
+ * @param[in] num – wskaźnik na pozostałą, niepustą część usuwanego numeru.
+ */
+static void removeFromNode(struct PhoneForward *pf, PfNode *node, char const *num) {
+    int x = (int) num[0] - (int) '0';
+    uint32_t child = getChild(pf, node, x);
+
+    // nie znaleziono przekierowań do usunięcia.
+    if (child == NO_NODE)
+        return;
+
+    PfNode *childNode = getNode(pf, child);
+    int p = commonPrefix(childNode, num);
+
+    // numer kończy się w obrębie etykiety, usuwamy całe poddrzewo syna.
+    if (num[p] == '\0')
+        removeChosenNumbers(pf, child);
+    else if (p == childNode->labelLen)
+        removeFromNode(pf, childNode, num + p);
+    // etykieta rozchodzi się z numerem, nie ma czego usuwać.
+    else
+        return;
+
+    tidyChild(pf, node, x);
+}
+
+
+/** @brief Porządkuje węzeł i jego przodków.
+ * Idąc w górę drzewa usuwa węzły, które nie przechowują żadnych informacji
+ * i nie mają synów, oraz scala pusty węzeł z jego jedynym synem.
+ * @param[in] pf  – wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] idx – indeks porządkowanego węzła; zwolnione węzły są pomijane.
+ */
+static void pruneUp(struct PhoneForward *pf, uint32_t idx) {
+    while (idx != ROOT_NODE) {
+        PfNode *node = getNode(pf, idx);
+
+        // węzeł został już zwolniony lub jest potrzebny.
+        if (node->labelLen == 0 || isUsed(node) || node->childCount > 1)
+            return;
+
+        uint32_t parent = node->parent;
+        bool isLeaf = node->childCount == 0;
+
+        tidyChild(pf, getNode(pf, parent), labelDigit(node, 0));
+
+        // po scaleniu z synem liczba synów ojca się nie zmienia.
+        if (!isLeaf)
+            return;
+
+        idx = parent;
+    }
+}
+
+
+/** @brief Porządkuje wszystkie odłożone węzły.
+ * @param[in] pf  – wskaźnik na strukturę przechowującą przekierowania numerów.
+ */
+static void prunePending(struct PhoneForward *pf) {
+    for (size_t i = 0; i < pf->pendingCount; i++)
+        pruneUp(pf, pf->pending[i]);
+
+    pf->pendingCount = 0;
+
+    // tablica nie jest potrzebna do czasu kolejnego usuwania.
+    free(pf->pending);
+    pf->pending = NULL;
+    pf->pendingCapacity = 0;
+}
+
+
+/** @brief Funkcja pomocnicza do phfwdAdd.
+ * Odnajduje w strukturze PhoneForward dany numer, tworząc brakujące węzły
+ * i rozdzielając krawędzie, w środku których kończy się numer.
+ * Rozdzielany węzeł zachowuje swój indeks i numer, nad nim powstaje nowy węzeł.
+ * W razie problemów z alokacją pamięci usuwa utworzone puste węzły.
+ * @param[in] num - odnajdywany numer;
+ * @param[in] pf - wskaźnik na strukturę PhoneForward, w której szukamy danego numeru.
+ * @return Indeks węzła struktury PhoneForward, reprezentującego szukany numer
+ *         lub NO_NODE w przypadku problemów z alokacją pamięci.
+ */
+static uint32_t findNumInStructure(char const *num, struct PhoneForward *pf) {
+    uint32_t tempIdx = ROOT_NODE;
+    PfNode *temp = getNode(pf, ROOT_NODE);
+    int i = 0;
+
+    // szukanie num w strukturze phoneForward
+    while (num[i] != '\0') {
+        int x = (int) num[i] - (int) '0';
+        uint32_t child = getChild(pf, temp, x);
+
+        // brak krawędzi, tworzymy węzeł z możliwie najdłuższą etykietą.
+        if (child == NO_NODE) {
+            uint32_t newEl = createNewElement(pf);
+
+            // problem z alokacją pamięci.
+            if (newEl == NO_NODE) {
+                pruneUp(pf, tempIdx);
+                return NO_NODE;
+            }
+
+            PfNode *newNode = getNode(pf, newEl);
+
+            int len = 0;
+
+            while (len < LABEL_MAX && num[i + len] != '\0')
+                len++;
+
+            setLabel(newNode, temp, num + i, len);
+            newNode->parent = tempIdx;
+            i += len;
+
+            // problem z alokacją pamięci.
+            if (!setChild(pf, temp, x, newEl)) {
+                freeElement(pf, newEl);
+                pruneUp(pf, tempIdx);
+                return NO_NODE;
+            }
+
+            tempIdx = newEl;
+            temp = newNode;
+            continue;
+        }
+
+        PfNode *childNode = getNode(pf, child);
+        int p = commonPrefix(childNode, num + i);
+
+        // numer kończy się lub rozchodzi w środku etykiety, rozdzielamy krawędź.
+        if (p < childNode->labelLen) {
+            uint32_t mid = createNewElement(pf);
+
+            // problem z alokacją pamięci.
+            if (mid == NO_NODE) {
+                pruneUp(pf, tempIdx);
+                return NO_NODE;
+            }
+
+            PfNode *midNode = getNode(pf, mid);
+
+            setLabel(midNode, temp, num + i, p);
+            midNode->parent = tempIdx;
+            midNode->minRevDepth = childNode->minRevDepth;
+            setChild(pf, midNode, numberDigit(childNode, midNode->depth), child);
+
+            // numer syna się nie zmienia, skraca się tylko jego etykieta.
+            childNode->labelLen = (uint8_t) (childNode->labelLen - p);
+            __atomic_store_n(&childNode->parent, mid, __ATOMIC_RELEASE);
+
+            // zastąpienie istniejącego syna nie wymaga alokacji pamięci.
+            setChild(pf, temp, x, mid);
+            child = mid;
+            childNode = midNode;
+        }
+
+        tempIdx = child;
+        temp = childNode;
+        i += p;
+    }
+
+    return tempIdx;
+}
+
+
+/** @brief Funkcja pomocnicza do phfwdAdd.
+ * Dodaje przekierowanie, nie synchronizując się ze współbieżnymi odczytami.
+ * @param[in,out] pf - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] num1 - wskaźnik na napis reprezentujący prefiks numerów przekierowywanych;
+ * @param[in] num2 - wskaźnik na napis reprezentujący prefiks numerów, na które jest
+ *            wykonywane przekierowanie.
+ * @return Wartość @p true, jeśli przekierowanie zostało dodane.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool addForwarding(struct PhoneForward *pf, char const *num1, char const *num2) {
+    // num1 lub num2 reprezentują pusty ciąg.
+    if (num1[0] == '\0' || num2[0] == '\0')
+        return false;
+
+    bool isDigitNum1 = checkIfNumber(num1);
+    bool isDigitNum2 = checkIfNumber(num2);
+    int isTheSame = strcmp(num1, num2);
+    uint32_t temp1;
+    uint32_t temp2;
+
+    // num1 nie reprezentują numeru, lub są takie same.
+    if (!isDigitNum1 || !isDigitNum2 || isTheSame == 0)
+        return false;
+
+
+    // dodawanie przekierowania dla num1.
+    // szukanie num1 w strukturze phoneForward
+    temp1 = findNumInStructure(num1, pf);
+
+    // problem z alokacją pamięci.
+    if (temp1 == NO_NODE)
+        return false;
+
+    // szukanie num2 w strukturze phoneForward.
+    temp2 = findNumInStructure(num2, pf);
+
+    RevArray *copy = NULL;
+
+    // problem z alokacją pamięci, usunięcie utworzonych pustych węzłów.
+    if (temp2 == NO_NODE || !reserveRevArray(pf, getNode(pf, temp2), &copy)) {
+        if (temp2 != NO_NODE)
+            pruneUp(pf, temp2);
+
+        pruneUp(pf, temp1);
+        return false;
+    }
+
+    PfNode *node1 = getNode(pf, temp1);
+    PfNode *node2 = getNode(pf, temp2);
+
+    // przekierowanie już istnieje.
+    if (node1->target == temp2) {
+        free(copy);
+        return true;
+    }
+
+    // usuwanie num1 z tablicy rev celu starego przekierowania. Nowe przekierowanie
+    // od razu zastępuje stare, czytelnicy nie widzą numeru bez przekierowania.
+    if (node1->target != NO_NODE)
+        detachForwarding(pf, temp1);
+
+    __atomic_store_n(&node1->target, temp2, __ATOMIC_RELEASE);
+
+    // dodawanie odwrotnego przekierowania do tablicy rev dla num2.
+    addRevListEl(pf, node2, copy, temp1);
+
+    if (node2->rev->count == 1)
+        updateRevDepth(pf, temp2);
+
+    // zapamiętane wyniki phfwdNonTrivialCount przestają być aktualne.
+    pf->generation++;
+
+    // usunięcie węzłów, na które nie ma już przekierowań.
+    prunePending(pf);
+
+    return true;
+}
+
+
+bool phfwdAdd(struct PhoneForward *pf, char const *num1, char const *num2) {
+    // num1 lub num2 lub struktura pf są nulami.
+    if (num1 == NULL || num2 == NULL || pf == NULL)
+        return false;
+
+    writeBegin(pf);
+    bool result = addForwarding(pf, num1, num2);
+    writeEnd(pf);
+
+    return result;
+}
+
+
+void phfwdRemove(struct PhoneForward *pf, char const *num) {
+    // num lub strunktura są nullami.
+    if (num == NULL || pf == NULL)
+        return;
+
+    bool isDigitNum = checkIfNumber(num);
+
+    // num nie reprezentuje numeru.
+    if (!isDigitNum || num[0] == '\0')
+        return;
+
+    writeBegin(pf);
+    removeFromNode(pf, getNode(pf, ROOT_NODE), num);
+    pf->generation++;
+
+    // usunięcie węzłów, na które nie ma już przekierowań.
+    prunePending(pf);
+    writeEnd(pf);
+}
+
+
+/** @brief Tworzy strukturę PhoneNumbers na podaną liczbę numerów.
+ * Tablica przesunięć i napisy numerów leżą w jednym bloku pamięci,
+ * zaraz za polem count struktury.
+ * @param[in] count - liczba numerów;
+ * @param[in] chars - łączna długość numerów wraz z kończącymi je znakami '\0'.
+ * @return Wskaźnik na utworzoną strukturę lub NULL w przypadku problemów z alokacją pamięci.
+ */
+static struct PhoneNumbers * createPhoneNumbers(size_t count, size_t chars) {
+    struct PhoneNumbers *phnum = malloc(sizeof(struct PhoneNumbers) + count * sizeof(size_t) + chars);
+
+    // problem z alokacją pamięci.
+    if (phnum == NULL)
+        return NULL;
+
+    phnum->count = count;
+
+    return phnum;
+}
+
+
+/** @brief Udostępnia obszar napisów struktury PhoneNumbers.
+ * @param[in] pnum - wskaźnik na strukturę przechowującą ciąg numerów.
+ * @return Wskaźnik na początek obszaru napisów.
+ */
+static inline char * numbersData(struct PhoneNumbers const *pnum) {
+    return (char*) (pnum->offsets + pnum->count);
+}
+
+
+/** @brief Wyznacza rozmiar bloku pamięci struktury PhoneNumbers.
+ * @param[in] pnum - wskaźnik na strukturę przechowującą ciąg numerów.
+ * @return Rozmiar bloku w bajtach.
+ */
+static size_t numbersSize(struct PhoneNumbers const *pnum) {
+    size_t size = sizeof(struct PhoneNumbers) + pnum->count * sizeof(size_t);
+
+    // numery leżą kolejno, ostatni kończy obszar napisów.
+    if (pnum->count > 0)
+        size += pnum->offsets[pnum->count - 1] + strlen(phnumGet(pnum, pnum->count - 1)) + 1;
+
+    return size;
+}
+
+
+/** @brief Wyznacza skrót numeru zapytania i rodzaju wyniku.
+ * @param[in] num - wskaźnik na numer;
+ * @param[in] kind - rodzaj wyniku.
+ * @return Skrót FNV-1a.
+ */
+static uint64_t hashResult(char const *num, uint8_t kind) {
+    uint64_t hash = 0xCBF29CE484222325u ^ kind;
+
+    for (size_t i = 0; num[i] != '\0'; i++)
+        hash = (hash ^ (uint8_t) num[i]) * 0x100000001B3u;
+
+    return hash;
+}
+
+
+/** @brief Wyszukuje wpis pamięci podręcznej wyników.
+ * @param[in] cache - wskaźnik na pamięć podręczną;
+ * @param[in] num - wskaźnik na numer zapytania;
+ * @param[in] kind - rodzaj wyniku;
+ * @param[in] hash - skrót numeru i rodzaju wyniku.
+ * @return Indeks wpisu, także nieaktualnego, lub 0, gdy wpisu nie ma.
+ */
+static uint32_t findResultEntry(ResultCache const *cache, char const *num, uint8_t kind, uint64_t hash) {
+    uint32_t idx = cache->buckets[hash & cache->bucketMask];
+
+    while (idx != 0) {
+        ResultEntry const *entry = &cache->entries[idx];
+
+        // numer zapytania leży za wynikiem.
+        if (entry->hash == hash && entry->kind == kind
+            && strcmp((char const*) entry->result + entry->resultSize, num) == 0)
+            return idx;
+
+        idx = entry->chain;
+    }
+
+    return 0;
+}
+
+
+/** @brief Odłącza wpis od listy wpisów od ostatnio do najdawniej użytego.
+ * @param[in] cache - wskaźnik na pamięć podręczną;
+ * @param[in] idx - indeks wpisu.
+ */
+static void unlinkResultEntry(ResultCache *cache, uint32_t idx) {
+    ResultEntry *entry = &cache->entries[idx];
+
+    if (entry->newer != 0)
+        cache->entries[entry->newer].older = entry->older;
+    else cache->newest = entry->older;
+
+    if (entry->older != 0)
+        cache->entries[entry->older].newer = entry->newer;
+    else cache->oldest = entry->newer;
+}
+
+
+/** @brief Umieszcza wpis na początku listy jako ostatnio użyty.
+ * @param[in] cache - wskaźnik na pamięć podręczną;
+ * @param[in] idx - indeks wpisu, niepołączonego z listą.
+ */
+static void pushResultEntry(ResultCache *cache, uint32_t idx) {
+    ResultEntry *entry = &cache->entries[idx];
+
+    entry->newer = 0;
+    entry->older = cache->newest;
+
+    if (cache->newest != 0)
+        cache->entries[cache->newest].newer = idx;
+    else cache->oldest = idx;
+
+    cache->newest = idx;
+}
+
+
+/** @brief Udostępnia aktualny zapamiętany wynik zapytania.
+ * Zlicza trafienia i chybienia. Nie używa pamięci podręcznej, gdy jest
+ * wyłączona lub włączono współbieżne odczyty.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] num - wskaźnik na numer zapytania;
+ * @param[in] kind - rodzaj wyniku.
+ * @return Wskaźnik na zapamiętany wynik lub NULL, gdy go nie ma.
+ */
+static struct PhoneNumbers const * findResult(struct PhoneForward *pf, char const *num, uint8_t kind) {
+    ResultCache *cache = pf->results;
+
+    if (cache == NULL || pf->sync != NULL)
+        return NULL;
+
+    uint32_t idx = findResultEntry(cache, num, kind, hashResult(num, kind));
+
+    // wynik zapamiętano przed ostatnią modyfikacją struktury.
+    if (idx == 0 || cache->entries[idx].generation != pf->generation) {
+        cache->misses++;
+        return NULL;
+    }
+
+    cache->hits++;
+    unlinkResultEntry(cache, idx);
+    pushResultEntry(cache, idx);
+
+    return cache->entries[idx].result;
+}
+
+
+/** @brief Przydziela miejsce na wynik zapytania w pamięci podręcznej.
+ * Zastępuje poprzedni wynik tego zapytania lub, gdy brakuje miejsca,
+ * najdawniej użyty wpis. Wynik należy zapisać w zwróconym bloku. Wynik
+ * mieszczący się razem z numerem zapytania w RESULT_SLOT bajtach trafia
+ * do miejsca przydzielonego wpisowi z góry, większy do osobno alokowanego bloku.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] num - wskaźnik na numer zapytania;
+ * @param[in] kind - rodzaj wyniku;
+ * @param[in] size - rozmiar bloku wyniku;
+ * @param[in] allocate - czy wolno alokować pamięć na wynik większy niż miejsce wpisu.
+ * @return Wskaźnik na blok wyniku lub NULL, gdy pamięć podręczna nie jest
+ *         używana, wynik się nie mieści, a alokacja jest niedozwolona,
+ *         lub nie udało się alokować pamięci; wynik nie zostanie wtedy zapamiętany.
+ */
+static struct PhoneNumbers * reserveResult(struct PhoneForward *pf, char const *num, uint8_t kind, size_t size,
+                                           bool allocate) {
+    ResultCache *cache = pf->results;
+
+    if (cache == NULL || pf->sync != NULL)
+        return NULL;
+
+    size_t numLength = strlen(num);
+    bool inSlot = size + numLength + 1 <= RESULT_SLOT;
+    struct PhoneNumbers *block = NULL;
+
+    if (!inSlot) {
+        if (!allocate)
+            return NULL;
+
+        block = malloc(size + numLength + 1);
+
+        // problem z alokacją pamięci.
+        if (block == NULL)
+            return NULL;
+    }
+
+    uint64_t hash = hashResult(num, kind);
+    uint32_t idx = findResultEntry(cache, num, kind, hash);
+
+    if (idx != 0) {
+        // nieaktualny wynik tego samego zapytania.
+        releaseResult(&cache->entries[idx]);
+        unlinkResultEntry(cache, idx);
+    }
+    else if (cache->count < cache->capacity) {
+        idx = ++cache->count;
+        cache->entries[idx].chain = cache->buckets[hash & cache->bucketMask];
+        cache->buckets[hash & cache->bucketMask] = idx;
+    }
+    else {
+        // zastępujemy najdawniej użyty wpis, odłączając go od jego kubełka.
+        idx = cache->oldest;
+
+        uint32_t *link = &cache->buckets[cache->entries[idx].hash & cache->bucketMask];
+
+        while ((*link) != idx)
+            link = &cache->entries[*link].chain;
+
+        (*link) = cache->entries[idx].chain;
+        releaseResult(&cache->entries[idx]);
+        unlinkResultEntry(cache, idx);
+        cache->evictions++;
+
+        cache->entries[idx].chain = cache->buckets[hash & cache->bucketMask];
+        cache->buckets[hash & cache->bucketMask] = idx;
+    }
+
+    if (inSlot)
+        block = (struct PhoneNumbers*) (cache->slots + (size_t) (idx - 1) * RESULT_SLOT);
+
+    memcpy((char*) block + size, num, numLength + 1);
+
+    ResultEntry *entry = &cache->entries[idx];
+
+    entry->generation = pf->generation;
+    entry->hash = hash;
+    entry->result = block;
+    entry->resultSize = size;
+    entry->inSlot = inSlot;
+    entry->kind = kind;
+    pushResultEntry(cache, idx);
+
+    return block;
+}
+
+
+/** @brief Zapamiętuje kopię wyniku zapytania w pamięci podręcznej.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] num - wskaźnik na numer zapytania;
+ * @param[in] kind - rodzaj wyniku;
+ * @param[in] pnum - wskaźnik na wynik lub NULL, który nie jest zapamiętywany.
+ */
+static void rememberResult(struct PhoneForward *pf, char const *num, uint8_t kind, struct PhoneNumbers const *pnum) {
+    if (pnum == NULL)
+        return;
+
+    size_t size = numbersSize(pnum);
+    struct PhoneNumbers *block = reserveResult(pf, num, kind, size, true);
+
+    if (block != NULL)
+        memcpy(block, pnum, size);
+}
+
+
+/** @brief Tworzy kopię zapamiętanego wyniku zapytania.
+ * @param[in] pnum - wskaźnik na zapamiętany wynik.
+ * @return Wskaźnik na kopię lub NULL w przypadku problemów z alokacją pamięci.
+ */
+static struct PhoneNumbers * copyResult(struct PhoneNumbers const *pnum) {
+    size_t size = numbersSize(pnum);
+    struct PhoneNumbers *copy = malloc(size);
+
+    if (copy != NULL)
+        memcpy(copy, pnum, size);
+
+    return copy;
+}
+
+
+/** @brief Wyznacza przekierowanie podanego numeru dla funkcji pfwdGet.
+ * @param[in] pf  – wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] where  – wartość, wskazująca na miejsce, w którym skończy się
+ *            przekierowanie w tworzonym numerze;
+ * @param[in] num – wskaźnik na napis reprezentujący numer do przekierowania;
+ * @param [in] target – indeks węzła docelowego znalezionego przekierowania
+ *             lub NO_NODE, gdy przekierowania nie ma;
+ * @return Wskaźnik na strukturę PhoneNumbers z nowo utworzonym numerem
+ *         lub NULL w przypadku problemów z alokacją pamięci.
+ */
+static struct PhoneNumbers * createFinalNumber(struct PhoneForward *pf, char const *num, uint32_t target, int where) {
+    // obliczenie rozmiaru tablicy na tworzony numer.
+    // num nie jest nullem.
+    size_t numLength = strlen(num);
+    size_t foundNumLength = target != NO_NODE ? getNode(pf, target)->depth : 0;
+
+    size_t n = numLength + 1 - where + foundNumLength;
+
+    struct PhoneNumbers *pnum = createPhoneNumbers(1, n);
+
+    // problem z alokacją pamięci.
+    if (pnum == NULL)
+        return NULL;
+
+    char *finalNumber = numbersData(pnum);
+    pnum->offsets[0] = 0;
+
+    if (target != NO_NODE)
+        writeKey(pf, target, finalNumber);
+
+    memcpy(finalNumber + foundNumLength, num + where, numLength - where);
+    finalNumber[n - 1] = '\0';
+
+    return pnum;
+}
+
+
+/** @brief Wyznacza najdłuższy przekierowany prefiks numeru.
+ * Przechodzi drzewo jednokrotnie od korzenia, zapamiętując najgłębszy
+ * napotkany węzeł z przekierowaniem i kończy, gdy ścieżka się urywa.
+ * @param[in] pf  – wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] num – wskaźnik na napis reprezentujący numer;
+ * @param[in] where – wskaźnik na zmienną, do której zostanie zapisana długość
+ *            znalezionego prefiksu.
+ * @return Wskaźnik na węzeł z przekierowaniem lub NULL, jeśli żaden prefiks
+ *         numeru nie jest przekierowany.
+ */
+static PfNode * findLongestPrefix(struct PhoneForward *pf, char const *num, size_t *where) {
+    PfNode *node = getNode(pf, ROOT_NODE);
+    PfNode *best = NULL;
+    size_t i = 0;
+
+    while (num[i] != '\0') {
+        uint32_t child = getChild(pf, node, (int) num[i] - (int) '0');
+
+        if (child == NO_NODE)
+            break;
+
+        node = getNode(pf, child);
+
+        // etykieta wychodzi poza numer lub się z nim rozchodzi.
+        if (commonPrefix(node, num + i) < node->labelLen)
+            break;
+
+        i += node->labelLen;
+
+        if (node->target != NO_NODE) {
+            best = node;
+            (*where) = i;
+        }
+    }
+
+    return best;
+}
+
+
+/** @brief Udostępnia węzeł czytelnikowi przy współbieżnych modyfikacjach.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania;
+ * @param[in] idx - indeks węzła.
+ * @return Wskaźnik na węzeł.
+ */
+static inline PfNode const * loadNode(struct PhoneForward const *pf, uint32_t idx) {
+    return poolLoad(&pf->nodes, idx);
+}
+
+
+/** @brief Sprawdza krawędź do węzła przy współbieżnych modyfikacjach.
+ * Korzysta tylko z głębokości i ostatnich cyfr numeru węzła, które nie
+ * zmieniają się, dopóki czytelnicy mogą węzeł odczytywać. Długość etykiety
+ * zmienia się przy rozdzielaniu i scalaniu krawędzi, więc nie jest używana.
+ * @param[in] node - wskaźnik na węzeł;
+ * @param[in] i - głębokość ojca, z którego czytelnik przeszedł do węzła;
+ * @param[in] num - wskaźnik na napis reprezentujący numer.
+ * @return Wartość @p true, jeśli cyfry numeru węzła od pozycji @p i
+ *         zgadzają się z numerem @p num.
+ */
+static inline bool edgeMatches(PfNode const *node, uint32_t i, char const *num) {
+    uint32_t depth = node->depth;
+
+    return depth > i && depth - i <= LABEL_MAX && matchDigits(node, i, depth, num + i) == depth - i;
+}
+
+
+/** @brief Wyznacza syna węzła przy współbieżnych modyfikacjach.
+ * Tablica synów jest odczytywana jednym atomowym odczytem pól kids,
+ * a cyfry synów służą tylko za wskazówkę, bo mogą pochodzić z innej wersji
+ * tablicy. Syn jest więc zwracany dopiero po sprawdzeniu jego krawędzi.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania;
+ * @param[in] node - wskaźnik na węzeł;
+ * @param[in] i - głębokość węzła, z której czytelnik do niego przeszedł;
+ * @param[in] num - wskaźnik na napis reprezentujący numer, dłuższy niż @p i.
+ * @return Indeks syna, którego cała krawędź jest zgodna z numerem,
+ *         lub NO_NODE, jeśli takiego syna nie ma.
+ */
+static uint32_t loadChild(struct PhoneForward const *pf, PfNode const *node, uint32_t i, char const *num) {
+    int x = (int) num[i] - (int) '0';
+    union {
+        uint32_t kids[2];
+        uint64_t word;
+    } pair;
+
+    pair.word = __atomic_load_n(&node->kidsWord, __ATOMIC_ACQUIRE);
+
+    if (pair.kids[1] == KIDS_NODE12) {
+        PfNode12 *block = poolLoad(&pf->blocks12, pair.kids[0]);
+        uint32_t child = __atomic_load_n(&block->kids[x], __ATOMIC_ACQUIRE);
+
+        return child != NO_NODE && edgeMatches(loadNode(pf, child), i, num) ? child : NO_NODE;
+    }
+
+    if (pair.kids[1] == KIDS_NODE4) {
+        PfNode4 *block = poolLoad(&pf->blocks4, pair.kids[0]);
+
+        for (int j = 0; j < 4; j++) {
+            uint32_t child = __atomic_load_n(&block->kids[j], __ATOMIC_ACQUIRE);
+
+            if (child != NO_NODE && __atomic_load_n(&block->keys[j], __ATOMIC_RELAXED) == x
+                && edgeMatches(loadNode(pf, child), i, num))
+                return child;
+        }
+
+        return NO_NODE;
+    }
+
+    // zaczynamy od syna wskazanego przez cyfry, a w razie niezgodności sprawdzamy drugiego.
+    int first = __atomic_load_n(&node->keys[0], __ATOMIC_RELAXED) == x ? 0 : 1;
+
+    for (int j = 0; j < 2; j++) {
+        uint32_t child = pair.kids[first ^ j];
+
+        if (child != NO_NODE && edgeMatches(loadNode(pf, child), i, num))
+            return child;
+    }
+
+    return NO_NODE;
+}
+
+
+/** @brief Zapisuje numer reprezentowany przez węzeł przy współbieżnych modyfikacjach.
+ * Działa jak writeKey, ale idzie po atomowo odczytywanych ojcach. Korzysta
+ * tylko z głębokości i ostatnich cyfr numeru węzłów, więc przepisane cyfry
+ * są poprawne niezależnie od tego, czy przodek został w tym czasie
+ * rozdzielony lub scalony.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania;
+ * @param[in] idx - indeks węzła;
+ * @param[in] buf - bufor na depth znaków węzła, numer nie jest zakończony
+ *            znakiem '\0'.
+ */
+static void writeKeyConcurrent(struct PhoneForward const *pf, uint32_t idx, char *buf) {
+    PfNode const *node = loadNode(pf, idx);
+    uint32_t end = node->depth;
+
+    while (end > 0) {
+        uint32_t start = node->depth > LABEL_MAX ? node->depth - LABEL_MAX : 0;
+
+        if (start < end) {
+            writeDigits(node, start, end, buf + start);
+            end = start;
+        }
+
+        if (end > 0)
+            node = loadNode(pf, __atomic_load_n(&node->parent, __ATOMIC_ACQUIRE));
+    }
+}
+
+
+/** @brief Wyznacza najdłuższy przekierowany prefiks numeru przy współbieżnych modyfikacjach.
+ * @param[in] pf  – wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] num – wskaźnik na napis reprezentujący numer;
+ * @param[out] where – długość znalezionego prefiksu.
+ * @return Indeks węzła, na który przekierowano prefiks, lub NO_NODE, jeśli
+ *         żaden prefiks nie jest przekierowany.
+ */
+static uint32_t findTargetConcurrent(struct PhoneForward const *pf, char const *num, size_t *where) {
+    PfNode const *node = loadNode(pf, ROOT_NODE);
+    uint32_t target = NO_NODE;
+    uint32_t i = 0;
+
+    while (num[i] != '\0') {
+        uint32_t child = loadChild(pf, node, i, num);
+
+        if (child == NO_NODE)
+            break;
+
+        node = loadNode(pf, child);
+        i = node->depth;
+
+        uint32_t nodeTarget = __atomic_load_n(&node->target, __ATOMIC_ACQUIRE);
+
+        if (nodeTarget != NO_NODE) {
+            target = nodeTarget;
+            (*where) = i;
+        }
+    }
+
+    return target;
+}
+
+
+/** @brief Wyznacza przekierowanie numeru przy włączonych współbieżnych odczytach.
+ * @param[in] pf  – wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] num – wskaźnik na napis reprezentujący numer.
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci.
+ */
+static struct PhoneNumbers * getConcurrent(struct PhoneForward *pf, char const *num) {
+    size_t parity;
+    ReaderSlot *slot = epochEnter(pf->sync, &parity);
+    size_t numLength = strlen(num);
+    size_t where = 0;
+    uint32_t target = findTargetConcurrent(pf, num, &where);
+    size_t depth = target != NO_NODE ? loadNode(pf, target)->depth : 0;
+    struct PhoneNumbers *pnum = createPhoneNumbers(1, numLength + 1 - where + depth);
+
+    // w razie problemów z alokacją pamięci pnum wyniesie NULL.
+    if (pnum != NULL) {
+        char *finalNumber = numbersData(pnum);
+
+        pnum->offsets[0] = 0;
+
+        if (target != NO_NODE)
+            writeKeyConcurrent(pf, target, finalNumber);
+
+        memcpy(finalNumber + depth, num + where, numLength - where + 1);
+    }
+
+    epochLeave(slot, parity);
+
+    return pnum;
+}
+
+
+/** @brief Zapisuje przekierowanie numeru do bufora przy włączonych współbieżnych odczytach.
+ * @param[in] pf  – wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] num – wskaźnik na napis reprezentujący niepusty numer;
+ * @param[in] numLength – długość numeru;
+ * @param[out] buf – bufor na wynik lub NULL;
+ * @param[in] buflen – rozmiar bufora.
+ * @return Długość wyniku bez znaku '\0'.
+ */
+static size_t getIntoConcurrent(struct PhoneForward *pf, char const *num, size_t numLength, char *buf, size_t buflen) {
+    size_t parity;
+    ReaderSlot *slot = epochEnter(pf->sync, &parity);
+    size_t where = 0;
+    uint32_t target = findTargetConcurrent(pf, num, &where);
+    size_t depth = target != NO_NODE ? loadNode(pf, target)->depth : 0;
+    size_t n = depth + numLength - where;
+
+    // wynik zapisujemy tylko, gdy zmieści się w buforze razem z '\0'.
+    if (buf != NULL && n < buflen) {
+        if (target != NO_NODE)
+            writeKeyConcurrent(pf, target, buf);
+
+        memcpy(buf + depth, num + where, numLength - where + 1);
+    }
+
+    epochLeave(slot, parity);
+
+    return n;
+}
+
+
+struct PhoneNumbers const * phfwdGet(struct PhoneForward *pf, char const *num) {
+    if (pf == NULL || num == NULL)
+        return NULL;
+
+    struct PhoneNumbers *pnum;
+    struct PhoneNumbers const *cached;
+
+    bool isDigitNum = checkIfNumber(num);
+    // num nie reprezentuje numeru.
+    if (!isDigitNum || num[0] == '\0') {
+        pnum = createPhoneNumbers(0, 0);
+    }
+    else if (pf->sync != NULL) {
+        pnum = getConcurrent(pf, num);
+    }
+    else if ((cached = findResult(pf, num, RESULT_GET)) != NULL) {
+        pnum = copyResult(cached);
+    }
+    else {
+        size_t where = 0;
+        PfNode *found = findLongestPrefix(pf, num, &where); // pf nie jest nullem.
+
+        // gdy nie znaleziono żadnego przekierowania, wynikiem jest sam numer.
+        // w razie problemów z alokacją pamięci pnum wyniesie NULL.
+        pnum = createFinalNumber(pf, num, found != NULL ? found->target : NO_NODE, (int) where);
+        rememberResult(pf, num, RESULT_GET, pnum);
+    }
+
+    return pnum;
+}
+
+
+size_t phfwdGetInto(struct PhoneForward *pf, char const *num, char *buf, size_t buflen) {
+    size_t numLength = 0;
+
+    // num nie reprezentuje numeru, wynikiem jest pusty napis.
+    if (pf == NULL || num == NULL || !scanNumber(num, &numLength) || numLength == 0) {
+        if (buf != NULL && buflen > 0)
+            buf[0] = '\0';
+
+        return 0;
+    }
+
+    if (pf->sync != NULL)
+        return getIntoConcurrent(pf, num, numLength, buf, buflen);
+
+    struct PhoneNumbers const *cached = findResult(pf, num, RESULT_GET);
+
+    if (cached != NULL) {
+        char const *result = phnumGet(cached, 0);
+        size_t n = strlen(result);
+
+        if (buf != NULL && n < buflen)
+            memcpy(buf, result, n + 1);
+
+        return n;
+    }
+
+    size_t where = 0;
+    PfNode *found = findLongestPrefix(pf, num, &where);
+    uint32_t target = found != NULL ? found->target : NO_NODE;
+
+    size_t prefixLength = target != NO_NODE ? getNode(pf, target)->depth : 0;
+    size_t restLength = numLength - where;
+    size_t n = prefixLength + restLength;
+
+    // wynik zapisujemy tylko, gdy zmieści się w buforze razem z '\0'.
+    if (buf != NULL && n < buflen) {
+        if (target != NO_NODE)
+            writeKey(pf, target, buf);
+
+        memcpy(buf + prefixLength, num + where, restLength + 1);
+
+        // zapamiętany wynik ma postać jednoelementowego ciągu numerów;
+        // zapamiętujemy go tylko bez alokowania pamięci.
+        size_t size = sizeof(struct PhoneNumbers) + sizeof(size_t) + n + 1;
+        struct PhoneNumbers *block = reserveResult(pf, num, RESULT_GET, size, false);
+
+        if (block != NULL) {
+            block->count = 1;
+            block->offsets[0] = 0;
+            memcpy(numbersData(block), buf, n + 1);
+        }
+    }
+
+    return n;
+}
+
+
+/**
+ * Stan pojedynczego wyszukiwania prowadzonego przez funkcję phfwdGetBatch.
+ */
+typedef struct batchLookup {
+    char const *num; // wyszukiwany numer.
+    size_t index; // pozycja numeru w tablicy wejściowej.
+    size_t pos; // liczba cyfr numeru przed następnym węzłem ścieżki.
+    size_t where; // długość najdłuższego przekierowanego prefiksu.
+    uint32_t next; // indeks następnego węzła ścieżki lub NO_NODE po zakończeniu.
+    uint32_t target; // cel najdłuższego przekierowanego prefiksu lub NO_NODE.
+    bool valid; // czy napis num reprezentuje numer.
+    bool inBlock; // czy następnym krokiem jest odczyt tablicy synów węzła NODE4 next.
+} BatchLookup;
+
+
+/** @brief Funkcja pomocnicza dla phfwdGetBatch.
+ * Rozpoczyna wyszukiwanie numeru od syna korzenia.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] lookup - wskaźnik na stan wyszukiwania;
+ * @param[in] num - wskaźnik na wyszukiwany numer;
+ * @param[in] index - pozycja numeru w tablicy wejściowej.
+ * @return Wartość @p true, jeśli wyszukiwanie wymaga kolejnych kroków.
+ */
+static bool startLookup(struct PhoneForward *pf, BatchLookup *lookup, char const *num, size_t index) {
+    lookup->num = num;
+    lookup->index = index;
+    lookup->pos = 0;
+    lookup->where = 0;
+    lookup->next = NO_NODE;
+    lookup->target = NO_NODE;
+    lookup->inBlock = false;
+    lookup->valid = num != NULL && num[0] != '\0' && checkIfNumber(num);
+
+    // num nie reprezentuje numeru.
+    if (!lookup->valid)
+        return false;
+
+    lookup->next = getChild(pf, getNode(pf, ROOT_NODE), (int) num[0] - (int) '0');
+
+    if (lookup->next == NO_NODE)
+        return false;
+
+    PREFETCH(getNode(pf, lookup->next));
+
+    return true;
+}
+
+
+/** @brief Funkcja pomocnicza dla phfwdGetBatch.
+ * Wykonuje jeden krok wyszukiwania: odczytuje węzeł next albo jego tablicę
+ * synów i zleca wczesne pobranie pamięci potrzebnej w następnym kroku.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] lookup - wskaźnik na stan wyszukiwania.
+ * @return Wartość @p true, jeśli wyszukiwanie wymaga kolejnych kroków.
+ */
+static bool advanceLookup(struct PhoneForward *pf, BatchLookup *lookup) {
+    PfNode *node = getNode(pf, lookup->next);
+    char const *num = lookup->num;
+
+    if (!lookup->inBlock) {
+        // etykieta wychodzi poza numer lub się z nim rozchodzi.
+        if (commonPrefix(node, num + lookup->pos) < node->labelLen)
+            return false;
+
+        lookup->pos += node->labelLen;
+
+        if (node->target != NO_NODE) {
+            lookup->target = node->target;
+            lookup->where = lookup->pos;
+        }
+
+        if (num[lookup->pos] == '\0')
+            return false;
+
+        // tablicę synów odczytamy w następnym kroku. Węzły NODE12 mają wielu
+        // potomków i zwykle leżą w pamięci podręcznej, dodatkowy krok się nie opłaca.
+        if (node->kind == NODE4) {
+            PREFETCH(poolGet(&pf->blocks4, node->kids[0]));
+            lookup->inBlock = true;
+            return true;
+        }
+    }
+
+    lookup->inBlock = false;
+    lookup->next = getChild(pf, node, (int) num[lookup->pos] - (int) '0');
+
+    if (lookup->next == NO_NODE)
+        return false;
+
+    PREFETCH(getNode(pf, lookup->next));
+
+    return true;
+}
+
+
+/** @brief Funkcja pomocnicza dla phfwdGetBatch.
+ * Tworzy wynik zakończonego wyszukiwania.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] lookup - wskaźnik na stan wyszukiwania;
+ * @param[out] out - tablica wyników.
+ * @return Wartość @p true, jeśli wynik jest różny od NULL.
+ */
+static bool finishLookup(struct PhoneForward *pf, BatchLookup const *lookup, struct PhoneNumbers const **out) {
+    char const *num = lookup->num;
+
+    if (num == NULL)
+        out[lookup->index] = NULL;
+    else if (!lookup->valid)
+        out[lookup->index] = createPhoneNumbers(0, 0);
+    else
+        out[lookup->index] = createFinalNumber(pf, num, lookup->target, (int) lookup->where);
+
+    return out[lookup->index] != NULL;
+}
+
+
+bool phfwdGetBatch(struct PhoneForward *pf, char const * const *nums, size_t n, struct PhoneNumbers const **out) {
+    if (out == NULL)
+        return false;
+
+    if (pf == NULL || nums == NULL) {
+        for (size_t i = 0; i < n; i++)
+            out[i] = NULL;
+
+        return n == 0;
+    }
+
+    BatchLookup group[BATCH_GROUP];
+    size_t active = 0;
+    size_t nextNum = 0;
+    bool result = true;
+
+    while (active > 0 || nextNum < n) {
+        // uzupełnienie grupy kolejnymi numerami.
+        while (active < BATCH_GROUP && nextNum < n) {
+            if (startLookup(pf, &group[active], nums[nextNum], nextNum))
+                active++;
+            else if (!finishLookup(pf, &group[active], out))
+                result = false;
+
+            nextNum++;
+        }
+
+        // po jednym kroku każdego wyszukiwania, zakończone zastępujemy ostatnim.
+        for (size_t j = 0; j < active;) {
+            if (advanceLookup(pf, &group[j])) {
+                j++;
+                continue;
+            }
+
+            if (!finishLookup(pf, &group[j], out))
+                result = false;
+
+            active--;
+            group[j] = group[active];
+        }
+    }
+
+    return result;
+}
+
+
+size_t phnumCount(struct PhoneNumbers const *pnum) {
+    if (pnum == NULL)
+        return 0;
+
+    return pnum->count;
+}
+
+
+char const * phnumGet(struct PhoneNumbers const *pnum, size_t idx) {
+    if (pnum ==  NULL)
+        return NULL;
+
+    // index jest spoza zakresu.
+    if (pnum->count <= idx)
+        return NULL;
+
+    return numbersData(pnum) + pnum->offsets[idx];
+}
+
+
+/**
+ * Strumień kandydatów na wynik funkcji phfwdReverse: numery z tablicy rev
+ * jednego węzła ścieżki, do których dopisujemy wspólną resztę numeru.
+ */
+typedef struct revStream {
+    uint32_t const *sources; // indeksy węzłów z tablicy rev, NULL dla samego numeru.
+    char const **nums; // numery strumienia w kolejności wynikowej.
+    uint32_t count; // liczba numerów strumienia.
+    uint32_t pos; // indeks następnego numeru strumienia.
+    char const *suffix; // reszta numeru dopisywana do numerów strumienia.
+} RevStream;
+
+/**
+ * Numer wynikowy funkcji phfwdReverse, złożony z dwóch części.
+ */
+typedef struct joinedNumber {
+    char const *prefix; // numer węzła z tablicy rev.
+    char const *suffix; // dopisywana reszta numeru.
+} JoinedNumber;
+
+
+/** @brief Funkcja pomocnicza dla funkcji phfwdReverse.
+ * Porównuje leksykograficznie dwa numery złożone z dwóch części,
+ * nie tworząc ich kopii.
+ * @param[in] prefix1 - pierwsza część pierwszego numeru;
+ * @param[in] suffix1 - druga część pierwszego numeru;
+ * @param[in] prefix2 - pierwsza część drugiego numeru;
+ * @param[in] suffix2 - druga część drugiego numeru.
+ * @return Wartość ujemna, zero lub dodatnia, jak dla funkcji strcmp.
+ */
+static int compareJoined(char const *prefix1, char const *suffix1, char const *prefix2, char const *suffix2) {
+    char const *a = prefix1;
+    char const *b = prefix2;
+    bool aInSuffix = false;
+    bool bInSuffix = false;
+
+    while (true) {
+        if (*a == '\0' && !aInSuffix) {
+            a = suffix1;
+            aInSuffix = true;
+            continue;
+        }
+
+        if (*b == '\0' && !bInSuffix) {
+            b = suffix2;
+            bInSuffix = true;
+            continue;
+        }
+
+        if (*a != *b || *a == '\0')
+            return (int) (unsigned char) *a - (int) (unsigned char) *b;
+
+        a++;
+        b++;
+    }
+}
+
+
+/** @brief Funkcja pomocnicza dla funkcji phfwdReverse.
+ * Porównuje bieżące numery dwóch strumieni.
+ * @param[in] a - wskaźnik na pierwszy strumień;
+ * @param[in] b - wskaźnik na drugi strumień.
+ * @return Wartość ujemna, zero lub dodatnia, jak dla funkcji strcmp.
+ */
+static inline int compareStreams(RevStream const *a, RevStream const *b) {
+    return compareJoined(a->nums[a->pos], a->suffix, b->nums[b->pos], b->suffix);
+}
+
+
+/** @brief Funkcja pomocnicza dla funkcji phfwdReverse.
+ * Przywraca własność kopca, przesuwając w dół element z danej pozycji.
+ * @param[in] streams - tablica strumieni;
+ * @param[in] heap - kopiec indeksów niewyczerpanych strumieni;
+ * @param[in] size - rozmiar kopca;
+ * @param[in] pos - pozycja przesuwanego elementu.
+ */
+static void siftDown(RevStream const *streams, uint32_t *heap, size_t size, size_t pos) {
+    while (2 * pos + 1 < size) {
+        size_t child = 2 * pos + 1;
+
+        if (child + 1 < size && compareStreams(&streams[heap[child + 1]], &streams[heap[child]]) < 0)
+            child++;
+
+        if (compareStreams(&streams[heap[pos]], &streams[heap[child]]) <= 0)
+            return;
+
+        uint32_t temp = heap[pos];
+        heap[pos] = heap[child];
+        heap[child] = temp;
+        pos = child;
+    }
+}
+
+
+/** @brief Funkcja pomocnicza dla funkcji phfwdReverse.
+ * Ustawia numery strumienia w kolejności wynikowej. Tablica rev jest posortowana,
+ * a dopisanie wspólnej reszty numeru może zmienić kolejność tylko numerów,
+ * z których jeden jest prefiksem drugiego, więc zwykle wystarcza jedno
+ * porównanie na numer.
+ * @param[in] stream - wskaźnik na porządkowany strumień.
+ */
+static void orderStream(RevStream *stream) {
+    for (uint32_t j = 1; j < stream->count; j++) {
+        char const *current = stream->nums[j];
+        uint32_t k = j;
+
+        while (k > 0 && compareJoined(stream->nums[k - 1], stream->suffix, current, stream->suffix) > 0) {
+            stream->nums[k] = stream->nums[k - 1];
+            k--;
+        }
+
+        stream->nums[k] = current;
+    }
+}
+
+
+/** @brief Funkcja pomocnicza dla funkcji phfwdReverse.
+ * Tworzy strumień kandydatów z tablicy rev węzła.
+ * @param[in] stream - wskaźnik na tworzony strumień;
+ * @param[in] node - wskaźnik na węzeł z niepustą tablicą rev;
+ * @param[in] suffix - reszta numeru, dopisywana do numerów strumienia.
+ */
+static inline void setStream(RevStream *stream, PfNode const *node, char const *suffix) {
+    stream->sources = node->rev->nums;
+    stream->count = node->rev->count;
+    stream->pos = 0;
+    stream->suffix = suffix;
+}
+
+
+/** @brief Funkcja pomocnicza dla funkcji phfwdReverse.
+ * Przechodzi ścieżkę numeru num i tworzy strumień kandydatów dla każdego
+ * węzła ścieżki z niepustą tablicą rev.
+ * @param[in] pf  – wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] num – wskaźnik na napis reprezentujący numer;
+ * @param[in] streams - tablica, do której zostaną zapisane strumienie;
+ * @param[in] total - wskaźnik na zmienną, do której zostanie zapisana łączna
+ *            liczba kandydatów.
+ * @return Liczbę utworzonych strumieni.
+ */
+static size_t reverseStreams(struct PhoneForward *pf, char const *num, RevStream *streams, size_t *total) {
+    uint32_t temp = ROOT_NODE;
+    size_t streamCount = 0;
+    size_t i = 0;
+
+    (*total) = 0;
+
+    while (num[i] != '\0') {
+        int x = (int) num[i] - (int) '0';
+
+        temp = getChild(pf, getNode(pf, temp), x);
+
+        // napewno niżej nie ma żadnych przekierowań.
+        if (temp == NO_NODE)
+            break;
+
+        PfNode *node = getNode(pf, temp);
+
+        // etykieta wychodzi poza numer lub się z nim rozchodzi, niżej nie ma przekierowań.
+        if (commonPrefix(node, num + i) < node->labelLen)
+            break;
+
+        i += node->labelLen;
+
+        // dany numer posiada jakieś elementy w swojej tablicy rev.
+        if (hasReverse(node)) {
+            setStream(&streams[streamCount], node, num + i);
+            (*total) += node->rev->count;
+            streamCount++;
+        }
+    }
+
+    return streamCount;
+}
+
+
+/** @brief Funkcja pomocnicza dla funkcji phfwdReverse.
+ * Porządkuje strumienie, scala je z pominięciem powtórzeń i tworzy wynikowy
+ * ciąg numerów. Nie odczytuje struktury przekierowań.
+ * @param[in] streams - tablica strumieni z odtworzonymi numerami węzłów;
+ * @param[in] heap - tablica na streamCount indeksów strumieni;
+ * @param[in] streamCount - liczba strumieni;
+ * @param[in] total - łączna liczba kandydatów w strumieniach.
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się zaalokować pamięci.
+ */
+static struct PhoneNumbers * mergeStreams(RevStream *streams, uint32_t *heap, size_t streamCount, size_t total) {
+    JoinedNumber *out = malloc(total * sizeof(JoinedNumber));
+
+    // problemy z alokacją pamięci.
+    if (out == NULL)
+        return NULL;
+
+    for (size_t j = 0; j < streamCount; j++) {
+        orderStream(&streams[j]);
+        heap[j] = (uint32_t) j;
+    }
+
+    for (size_t j = streamCount; j > 0; j--)
+        siftDown(streams, heap, streamCount, j - 1);
+
+    // scalanie strumieni z pominięciem powtórzeń.
+    size_t heapSize = streamCount;
+    size_t unique = 0;
+    size_t chars = 0;
+
+    while (heapSize > 0) {
+        RevStream *top = &streams[heap[0]];
+        char const *prefix = top->nums[top->pos];
+
+        if (unique == 0 || compareJoined(out[unique - 1].prefix, out[unique - 1].suffix, prefix, top->suffix) != 0) {
+            out[unique].prefix = prefix;
+            out[unique].suffix = top->suffix;
+            chars += strlen(prefix) + strlen(top->suffix) + 1;
+            unique++;
+        }
+
+        top->pos++;
+
+        // strumień się wyczerpał, zastępujemy go ostatnim elementem kopca.
+        if (top->pos == top->count) {
+            heapSize--;
+            heap[0] = heap[heapSize];
+        }
+
+        siftDown(streams, heap, heapSize, 0);
+    }
+
+    struct PhoneNumbers *result = createPhoneNumbers(unique, chars);
+
+    // przepisanie numerów do wynikowej struktury.
+    if (result != NULL) {
+        char *data = numbersData(result);
+        size_t offset = 0;
+
+        for (size_t j = 0; j < unique; j++) {
+            size_t prefixLength = strlen(out[j].prefix);
+            size_t suffixLength = strlen(out[j].suffix);
+
+            result->offsets[j] = offset;
+            memcpy(data + offset, out[j].prefix, prefixLength);
+            memcpy(data + offset + prefixLength, out[j].suffix, suffixLength + 1);
+            offset += prefixLength + suffixLength + 1;
+        }
+    }
+
+    free(out);
+
+    return result;
+}
+
+
+/** @brief Funkcja pomocnicza dla funkcji phfwdReverse.
+ * Dodaje strumień zawierający sam numer, scala wszystkie strumienie
+ * z pominięciem powtórzeń i tworzy wynikowy ciąg numerów.
+ * @param[in] pf  – wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] num – wskaźnik na napis reprezentujący numer;
+ * @param[in] streams - tablica strumieni ścieżki numeru z miejscem na jeszcze jeden;
+ * @param[in] heap - tablica na streamCount + 1 indeksów strumieni;
+ * @param[in] streamCount - liczba strumieni ścieżki;
+ * @param[in] total - łączna liczba kandydatów w strumieniach ścieżki.
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się zaalokować pamięci.
+ */
+static struct PhoneNumbers * mergeReverse(struct PhoneForward *pf, char const *num, RevStream *streams, uint32_t *heap, size_t streamCount, size_t total) {
+    static char const empty[] = "";
+
+    streams[streamCount].sources = NULL;
+    streams[streamCount].count = 1;
+    streams[streamCount].pos = 0;
+    streams[streamCount].suffix = num;
+    streamCount++;
+    total++;
+
+    // łączna długość numerów węzłów z tablic rev wraz ze znakami '\0'.
+    size_t keyChars = 0;
+
+    for (size_t j = 0; j + 1 < streamCount; j++) {
+        for (uint32_t k = 0; k < streams[j].count; k++)
+            keyChars += getNode(pf, streams[j].sources[k])->depth + 1;
+    }
+
+    // numery węzłów strumieni, porządkowane w miejscu.
+    char const **order = malloc(total * sizeof(char const*));
+    char *keys = malloc(keyChars);
+
+    // problemy z alokacją pamięci.
+    if (order == NULL || (keys == NULL && keyChars > 0)) {
+        free(order);
+        free(keys);
+        return NULL;
+    }
+
+    size_t used = 0;
+    size_t keyOffset = 0;
+
+    for (size_t j = 0; j < streamCount; j++) {
+        streams[j].nums = order + used;
+
+        // odtworzenie numerów węzłów strumienia.
+        for (uint32_t k = 0; k < streams[j].count; k++) {
+            if (streams[j].sources == NULL) {
+                order[used + k] = empty;
+                continue;
+            }
+
+            uint32_t source = streams[j].sources[k];
+            size_t depth = getNode(pf, source)->depth;
+
+            writeKey(pf, source, keys + keyOffset);
+            keys[keyOffset + depth] = '\0';
+            order[used + k] = keys + keyOffset;
+            keyOffset += depth + 1;
+        }
+
+        used += streams[j].count;
+    }
+
+    struct PhoneNumbers *result = mergeStreams(streams, heap, streamCount, total);
+
+    free(order);
+    free(keys);
+
+    return result;
+}
+
+
+/** @brief Funkcja pomocnicza dla funkcji phfwdReverse przy współbieżnych modyfikacjach.
+ * Przechodzi ścieżkę numeru num i kopiuje tablice rev jej węzłów,
+ * tworząc dla każdej z nich strumień kandydatów. Numery tablicy są
+ * kopiowane od końca, zob. removeRevListEl.
+ * @param[in] pf  – wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] num – wskaźnik na napis reprezentujący numer;
+ * @param[out] streams - tablica, do której zostaną zapisane strumienie;
+ * @param[out] streamCount - liczba utworzonych strumieni;
+ * @param[in,out] sources - adres bufora na kopie tablic rev, powiększanego w razie potrzeby;
+ * @param[in,out] capacity - rozmiar bufora sources;
+ * @param[out] total - łączna liczba kandydatów.
+ * @return Wartość @p true, jeśli się udało.
+ *         Wartość @p false w przypadku problemów z alokacją pamięci.
+ */
+static bool copyReverseStreams(struct PhoneForward const *pf, char const *num, RevStream *streams, size_t *streamCount,
+                               uint32_t **sources, size_t *capacity, size_t *total) {
+    PfNode const *node = loadNode(pf, ROOT_NODE);
+    uint32_t i = 0;
+
+    (*streamCount) = 0;
+    (*total) = 0;
+
+    while (num[i] != '\0') {
+        uint32_t child = loadChild(pf, node, i, num);
+
+        // napewno niżej nie ma żadnych przekierowań.
+        if (child == NO_NODE)
+            break;
+
+        node = loadNode(pf, child);
+        i = node->depth;
+
+        RevArray const *rev = __atomic_load_n(&node->rev, __ATOMIC_ACQUIRE);
+
+        if (rev == NULL)
+            continue;
+
+        uint32_t count = __atomic_load_n(&rev->count, __ATOMIC_ACQUIRE);
+
+        if (count == 0)
+            continue;
+
+        if ((*total) + count > (*capacity)) {
+            size_t newCapacity = 2 * ((*total) + count);
+            uint32_t *newSources = realloc((*sources), newCapacity * sizeof(uint32_t));
+
+            // problem z alokacją pamięci.
+            if (newSources == NULL)
+                return false;
+
+            (*sources) = newSources;
+            (*capacity) = newCapacity;
+        }
+
+        for (uint32_t j = count; j-- > 0;)
+            (*sources)[(*total) + j] = __atomic_load_n(&rev->nums[j], __ATOMIC_ACQUIRE);
+
+        streams[*streamCount].count = count;
+        streams[*streamCount].pos = 0;
+        streams[*streamCount].suffix = num + i;
+        (*streamCount)++;
+        (*total) += count;
+    }
+
+    return true;
+}
+
+
+/** @brief Funkcja pomocnicza dla funkcji phfwdReverse przy współbieżnych modyfikacjach.
+ * Odtwarza numery węzłów skopiowanych z tablic rev.
+ * @param[in] pf  – wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] sources - indeksy węzłów;
+ * @param[in] total - liczba węzłów;
+ * @param[out] order - tablica na total wskaźników na odtworzone numery;
+ * @param[out] keys - adres bufora na numery.
+ * @return Wartość @p true, jeśli się udało.
+ *         Wartość @p false w przypadku problemów z alokacją pamięci.
+ */
+static bool copyReverseKeys(struct PhoneForward const *pf, uint32_t const *sources, size_t total, char const **order,
+                            char **keys) {
+    size_t keyChars = 0;
+
+    for (size_t k = 0; k < total; k++)
+        keyChars += loadNode(pf, sources[k])->depth + 1;
+
+    (*keys) = malloc(keyChars);
+
+    // problem z alokacją pamięci.
+    if ((*keys) == NULL)
+        return false;
+
+    size_t keyOffset = 0;
+
+    for (size_t k = 0; k < total; k++) {
+        size_t depth = loadNode(pf, sources[k])->depth;
+
+        writeKeyConcurrent(pf, sources[k], (*keys) + keyOffset);
+        (*keys)[keyOffset + depth] = '\0';
+        order[k] = (*keys) + keyOffset;
+        keyOffset += depth + 1;
+    }
+
+    return true;
+}
+
+
+/** @brief Wyznacza przekierowania na dany numer przy włączonych współbieżnych odczytach.
+ * Kopiuje potrzebne tablice rev i numery węzłów, a następnie, już poza
+ * strukturą, scala kopie.
+ * @param[in] pf  – wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] num – wskaźnik na napis reprezentujący numer;
+ * @param[in] streams - tablica na numLength + 1 strumieni;
+ * @param[in] heap - tablica na numLength + 1 indeksów strumieni.
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci.
+ */
+static struct PhoneNumbers * reverseConcurrent(struct PhoneForward *pf, char const *num, RevStream *streams, uint32_t *heap) {
+    static char const empty[] = "";
+    uint32_t *sources = NULL;
+    char const **order = NULL;
+    char *keys = NULL;
+    size_t sourcesCapacity = 0;
+    size_t streamCount = 0;
+    size_t total = 0;
+    size_t parity;
+    ReaderSlot *slot = epochEnter(pf->sync, &parity);
+
+    bool ok = copyReverseStreams(pf, num, streams, &streamCount, &sources, &sourcesCapacity, &total);
+
+    // miejsce na numery węzłów i numer strumienia zawierającego sam numer.
+    if (ok) {
+        order = malloc((total + 1) * sizeof(char const*));
+        ok = order != NULL && copyReverseKeys(pf, sources, total, order, &keys);
+    }
+
+    epochLeave(slot, parity);
+
+    struct PhoneNumbers *result = NULL;
+
+    if (ok) {
+        size_t used = 0;
+
+        for (size_t j = 0; j < streamCount; j++) {
+            streams[j].sources = sources + used;
+            streams[j].nums = order + used;
+            used += streams[j].count;
+        }
+
+        order[total] = empty;
+        streams[streamCount].sources = NULL;
+        streams[streamCount].nums = order + total;
+        streams[streamCount].count = 1;
+        streams[streamCount].pos = 0;
+        streams[streamCount].suffix = num;
+
+        result = mergeStreams(streams, heap, streamCount + 1, total + 1);
+    }
+
+    free(sources);
+    free(order);
+    free(keys);
+
+    return result;
+}
+
+
+struct PhoneNumbers const * phfwdReverse(struct PhoneForward *pf, char const *num) {
+    if (pf == NULL || num == NULL)
+        return NULL;
+
+    size_t numLength;
+    bool isDigitNum = scanNumber(num, &numLength);
+    // num nie reprezentuje numeru lub num jest pustym ciagiem.
+    if (!isDigitNum || numLength == 0)
+        return createPhoneNumbers(0, 0);
+
+    struct PhoneNumbers const *cached = findResult(pf, num, RESULT_REVERSE);
+
+    if (cached != NULL)
+        return copyResult(cached);
+
+    // każdy węzeł ścieżki odpowiada co najmniej jednej cyfrze numeru,
+    // dodatkowy strumień zawiera sam numer otrzymany od użytkownika.
+    RevStream *streams = malloc((numLength + 1) * sizeof(RevStream));
+    uint32_t *heap = malloc((numLength + 1) * sizeof(uint32_t));
+    size_t total = 0;
+
+    // problemy z alokacją pamięci.
+    if (streams == NULL || heap == NULL) {
+        free(streams);
+        free(heap);
+        return NULL;
+    }
+
+    struct PhoneNumbers *result;
+
+    if (pf->sync != NULL) {
+        result = reverseConcurrent(pf, num, streams, heap);
+    }
+    else {
+        size_t streamCount = reverseStreams(pf, num, streams, &total);
+        result = mergeReverse(pf, num, streams, heap, streamCount, total);
+        rememberResult(pf, num, RESULT_REVERSE, result);
+    }
+
+    free(streams);
+    free(heap);
+
+    return result;
+}
+
+
+/**
+ * Zapytanie wsadowe wraz z jego pozycją w tablicy wejściowej.
+ */
+typedef struct sortedQuery {
+    char const *num; // numer zapytania.
+    size_t index; // pozycja numeru w tablicy wejściowej.
+} SortedQuery;
+
+/**
+ * Węzeł ścieżki współdzielonej przez kolejne zapytania wsadowe.
+ */
+typedef struct pathFrame {
+    uint32_t node; // indeks węzła ścieżki.
+    uint32_t target; // cel najdłuższego przekierowanego prefiksu aż do węzła lub NO_NODE.
+    size_t pos; // długość numeru reprezentowanego przez węzeł.
+    size_t where; // długość najdłuższego przekierowanego prefiksu aż do węzła.
+} PathFrame;
+
+
+/** @brief Porównuje zapytania wsadowe według ich numerów.
+ * @param[in] a - wskaźnik na pierwsze zapytanie;
+ * @param[in] b - wskaźnik na drugie zapytanie.
+ * @return Wartość ujemna, zero lub dodatnia, jak dla funkcji strcmp.
+ */
+static int compareQueries(void const *a, void const *b) {
+    return strcmp(((SortedQuery const*) a)->num, ((SortedQuery const*) b)->num);
+}
+
+
+/** @brief Sprawdza, czy napis zapytania wsadowego reprezentuje numer.
+ * @param[in] num - wskaźnik na napis.
+ * @return Wartość @p true, jeśli napis jest niepustym numerem.
+ */
+static inline bool isQueryNumber(char const *num) {
+    return num != NULL && num[0] != '\0' && checkIfNumber(num);
+}
+
+
+/** @brief Wyznacza wyniki zapytań wsadowych, które nie reprezentują numerów.
+ * Wyniki są takie, jak dla pojedynczych zapytań.
+ * @param[in] nums - tablica wskaźników na napisy reprezentujące numery;
+ * @param[in] n - liczba numerów;
+ * @param[out] out - tablica wyników.
+ * @return Wartość @p false, jeśli któryś z wyznaczonych wyników wynosi NULL.
+ */
+static bool answerInvalidQueries(char const * const *nums, size_t n, struct PhoneNumbers const **out) {
+    bool result = true;
+
+    for (size_t i = 0; i < n; i++) {
+        if (!isQueryNumber(nums[i])) {
+            out[i] = nums[i] == NULL ? NULL : createPhoneNumbers(0, 0);
+
+            if (out[i] == NULL)
+                result = false;
+        }
+    }
+
+    return result;
+}
+
+
+/** @brief Porządkuje zapytania wsadowe.
+ * Pomija napisy, które nie reprezentują numerów, a pozostałe zapytania
+ * porządkuje leksykograficznie, chyba że już są uporządkowane.
+ * @param[in] nums - tablica wskaźników na napisy reprezentujące numery;
+ * @param[in] n - liczba numerów, większa od zera;
+ * @param[out] count - liczba uporządkowanych zapytań;
+ * @param[out] maxLength - długość najdłuższego numeru.
+ * @return Wskaźnik na tablicę uporządkowanych zapytań lub NULL
+ *         w przypadku problemów z alokacją pamięci.
+ */
+static SortedQuery * sortQueries(char const * const *nums, size_t n, size_t *count, size_t *maxLength) {
+    SortedQuery *queries = malloc(n * sizeof(SortedQuery));
+
+    // problem z alokacją pamięci.
+    if (queries == NULL)
+        return NULL;
+
+    bool sorted = true;
+
+    (*count) = 0;
+    (*maxLength) = 0;
+
+    for (size_t i = 0; i < n; i++) {
+        char const *num = nums[i];
+        size_t length;
+
+        // wynik takiego zapytania wyznacza funkcja answerInvalidQueries.
+        if (num == NULL || !scanNumber(num, &length) || length == 0)
+            continue;
+
+        if ((*count) > 0 && strcmp(queries[(*count) - 1].num, num) > 0)
+            sorted = false;
+
+        if (length > (*maxLength))
+            (*maxLength) = length;
+
+        queries[(*count)].num = num;
+        queries[(*count)].index = i;
+        (*count)++;
+    }
+
+    if (!sorted)
+        qsort(queries, (*count), sizeof(SortedQuery), compareQueries);
+
+    return queries;
+}
+
+
+/** @brief Dopasowuje ścieżkę w drzewie do kolejnego zapytania wsadowego.
+ * Zdejmuje ze stosu węzły, których numery nie są już prefiksami numeru,
+ * i schodzi w głąb drzewa od ostatniego pozostawionego węzła.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] path - stos węzłów ścieżki, na dnie leży korzeń;
+ * @param[in] height - liczba węzłów na stosie;
+ * @param[in] num - wskaźnik na numer zapytania;
+ * @param[in] shared - długość wspólnego prefiksu numeru i poprzedniego zapytania.
+ * @return Liczbę węzłów na stosie po dopasowaniu ścieżki.
+ */
+static size_t followPath(struct PhoneForward *pf, PathFrame *path, size_t height, char const *num, size_t shared) {
+    while (path[height - 1].pos > shared)
+        height--;
+
+    PfNode *node = getNode(pf, path[height - 1].node);
+    size_t i = path[height - 1].pos;
+
+    while (num[i] != '\0') {
+        uint32_t child = getChild(pf, node, (int) num[i] - (int) '0');
+
+        if (child == NO_NODE)
+            break;
+
+        node = getNode(pf, child);
+
+        // etykieta wychodzi poza numer lub się z nim rozchodzi.
+        if (commonPrefix(node, num + i) < node->labelLen)
+            break;
+
+        i += node->labelLen;
+
+        path[height] = path[height - 1];
+        path[height].node = child;
+        path[height].pos = i;
+
+        if (node->target != NO_NODE) {
+            path[height].target = node->target;
+            path[height].where = i;
+        }
+
+        height++;
+    }
+
+    return height;
+}
+
+
+/** @brief Wyznacza długość wspólnego prefiksu dwóch napisów.
+ * @param[in] a - wskaźnik na pierwszy napis;
+ * @param[in] b - wskaźnik na drugi napis.
+ * @return Długość wspólnego prefiksu.
+ */
+static size_t sharedPrefix(char const *a, char const *b) {
+    size_t i = 0;
+
+    while (a[i] != '\0' && a[i] == b[i])
+        i++;
+
+    return i;
+}
+
+
+bool phfwdGetSorted(struct PhoneForward *pf, char const * const *nums, size_t n, struct PhoneNumbers const **out) {
+    if (out == NULL)
+        return false;
+
+    if (pf == NULL || nums == NULL || n == 0)
+        return phfwdGetBatch(pf, nums, n, out);
+
+    size_t count;
+    size_t maxLength;
+    SortedQuery *queries = sortQueries(nums, n, &count, &maxLength);
+    PathFrame *path = queries != NULL ? malloc((maxLength + 1) * sizeof(PathFrame)) : NULL;
+
+    // problem z alokacją pamięci, wyznaczamy wyniki bez współdzielenia ścieżki.
+    if (path == NULL) {
+        free(queries);
+        return phfwdGetBatch(pf, nums, n, out);
+    }
+
+    bool result = count == n || answerInvalidQueries(nums, n, out);
+
+    size_t height = 1;
+    char const *previous = "";
+
+    path[0].node = ROOT_NODE;
+    path[0].target = NO_NODE;
+    path[0].pos = 0;
+    path[0].where = 0;
+
+    for (size_t j = 0; j < count; j++) {
+        char const *num = queries[j].num;
+
+        height = followPath(pf, path, height, num, sharedPrefix(previous, num));
+        previous = num;
+
+        PathFrame const *top = &path[height - 1];
+        out[queries[j].index] = createFinalNumber(pf, num, top->target, (int) top->where);
+
+        if (out[queries[j].index] == NULL)
+            result = false;
+    }
+
+    free(path);
+    free(queries);
+
+    return result;
+}
+
+
+bool phfwdReverseSorted(struct PhoneForward *pf, char const * const *nums, size_t n, struct PhoneNumbers const **out) {
+    if (out == NULL)
+        return false;
+
+    bool result = true;
+
+    if (pf == NULL || nums == NULL || n == 0) {
+        for (size_t i = 0; i < n; i++)
+            out[i] = NULL;
+
+        return n == 0;
+    }
+
+    size_t count;
+    size_t maxLength;
+    SortedQuery *queries = sortQueries(nums, n, &count, &maxLength);
+    PathFrame *path = NULL;
+    RevStream *streams = NULL;
+    uint32_t *heap = NULL;
+
+    if (queries != NULL) {
+        path = malloc((maxLength + 1) * sizeof(PathFrame));
+        streams = malloc((maxLength + 1) * sizeof(RevStream));
+        heap = malloc((maxLength + 1) * sizeof(uint32_t));
+    }
+
+    // problem z alokacją pamięci, wyznaczamy wyniki pojedynczo.
+    if (path == NULL || streams == NULL || heap == NULL) {
+        free(queries);
+        free(path);
+        free(streams);
+        free(heap);
+
+        for (size_t i = 0; i < n; i++) {
+            out[i] = phfwdReverse(pf, nums[i]);
+
+            if (out[i] == NULL)
+                result = false;
+        }
+
+        return result;
+    }
+
+    result = count == n || answerInvalidQueries(nums, n, out);
+
+    size_t height = 1;
+    char const *previous = "";
+
+    path[0].node = ROOT_NODE;
+    path[0].target = NO_NODE;
+    path[0].pos = 0;
+    path[0].where = 0;
+
+    for (size_t j = 0; j < count; j++) {
+        char const *num = queries[j].num;
+        size_t streamCount = 0;
+        size_t total = 0;
+
+        height = followPath(pf, path, height, num, sharedPrefix(previous, num));
+        previous = num;
+
+        // strumienie kandydatów z węzłów ścieżki, z pominięciem korzenia.
+        for (size_t k = 1; k < height; k++) {
+            PfNode *node = getNode(pf, path[k].node);
+
+            if (hasReverse(node)) {
+                setStream(&streams[streamCount], node, num + path[k].pos);
+                total += node->rev->count;
+                streamCount++;
+            }
+        }
+
+        out[queries[j].index] = mergeReverse(pf, num, streams, heap, streamCount, total);
+
+        if (out[queries[j].index] == NULL)
+            result = false;
+    }
+
+    free(path);
+    free(streams);
+    free(heap);
+    free(queries);
+
+    return result;
+}
+
+
+/** @brief Funkcja pomocnicza dla phfwdNonTrivialCount.
+ * Oblicza wynik działania a^b. Dla małych wykładników korzysta z tablicy potęg.
+ * @param[in] a - podstawa poęgi;
+ * @param[in] b - wykładnik potęgi.
+ * @return Wynik działania a^b.
+ */
+static size_t raiseToPower(size_t a, size_t b) {
+    if (a <= DIGITS && b < POWER_LIMIT)
+        return powers[a][b];
+
+    size_t result = 1;
+
+    while (b > 0) {
+        if (b % 2 == 1)
+            result *= a;
+
+        a *= a;
+        b /= 2;
+    }
+
+    return result;
+}
+
+
+/** @brief Funkcja pomocnicza dla phfwdNonTrivialCount.
+ * Sprawdza, czy wszystkie cyfry etykiety węzła należą do setu.
+ * @param[in] node - wskaźnik na węzeł;
+ * @param[in] mask - maska cyfr, które wystąpiły w secie.
+ * @return Wartość @p true, jeśli cała etykieta składa się z cyfr setu.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool labelInSet(PfNode const *node, uint16_t mask) {
+    for (int i = 0; i < node->labelLen; i++) {
+        if (!(mask & (1u << labelDigit(node, i))))
+            return false;
+    }
+
+    return true;
+}
+
+
+/** @brief Funkcja pomocnicza dla phfwdNonTrivialCount.
+ * Wywołuje się rekurencyjnie na całym drzewie, zliczając nietrywialne numery.
+ * @param[in] pf - wskaźnik na strukturę przekierowań, na której operujemy;
+ * @param[in] idx - indeks rozpatrywanego węzła.
+ * @param[in] mask - maska cyfr, które wystąpiły w secie;
+ * @param[in] len - długość numeru, jaką rozpatrujemy;
+ * @param[in] actLen - długość numeru reprezentowanego przez węzeł, w którym jesteśmy;
+ * @param[in] n - liczba różnych cyfr w napisie set.
+ * @return Wyliczoną liczbę nietrywialnych numerów.
+ */
+size_t countNonTrivial(struct PhoneForward *pf, uint32_t idx, uint16_t mask, size_t len, size_t actLen, size_t n) {
+    size_t result = 0;
+
+    if (idx == NO_NODE)
+        return result;
+
+    PfNode *node = getNode(pf, idx);
+
+    // w poddrzewie nie ma przekierowań na numery nie dłuższe niż len.
+    if (node->minRevDepth > len)
+        return result;
+
+    // zeszliśmy na maksymalną głębokość, nie szukamy dłuższego numeru.
+    if (actLen == len) {
+        if (hasReverse(node))
+            result = 1;
+
+        return result;
+    }
+
+    // dany węzeł posiada jakieś odwrotne przekierowania, dodajemy odpowiednią wartość do wyniku,
+    // nie szchodzimy już dojego synów.
+    if (hasReverse(node)) {
+        result = raiseToPower(n, len - actLen);
+
+        return result;
+    }
+
+    uint8_t keys[DIGITS];
+    uint32_t kids[DIGITS];
+    int childCount = listChildren(pf, node, keys, kids);
+
+    // jeśli nie posiadał żadnych numerów na liście rev,
+    // wywołujemy się rekurencyjnie na synach, których cała etykieta jest w secie,
+    // których numer nie jest dłuższy niż len i w których poddrzewach są przekierowania.
+    for (int i = 0; i < childCount; i++) {
+        if (mask & (1u << keys[i])) {
+            PfNode *child = getNode(pf, kids[i]);
+
+            if (child->minRevDepth <= len && actLen + child->labelLen <= len && labelInSet(child, mask))
+                result += countNonTrivial(pf, kids[i], mask, len, actLen + child->labelLen, n);
+        }
+    }
+
+    return result;
+}
+
+
+/**
+ * Poddrzewo do policzenia przez jeden z wątków.
+ */
+typedef struct countTask {
+    uint32_t node; // indeks korzenia poddrzewa.
+    size_t actLen; // długość numeru reprezentowanego przez ten węzeł.
+} CountTask;
+
+/**
+ * Stan zliczania równoległego, współdzielony przez wątki.
+ */
+typedef struct countJob {
+    struct PhoneForward *pf; // przeglądana struktura przekierowań.
+    CountTask *tasks; // poddrzewa do policzenia.
+    size_t taskCount; // liczba poddrzew.
+    size_t next; // indeks następnego niepobranego poddrzewa, zwiększany atomowo.
+    uint16_t mask; // maska cyfr setu.
+    size_t len; // długość numerów.
+    size_t n; // liczba różnych cyfr setu.
+} CountJob;
+
+/**
+ * Wątek zliczający wraz z jego częściowym wynikiem.
+ */
+typedef struct countWorker {
+    CountJob *job; // wspólny stan zliczania.
+    size_t result; // suma wyników poddrzew policzonych przez wątek.
+    pthread_t thread; // uruchomiony wątek.
+} CountWorker;
+
+
+/** @brief Funkcja pomocnicza dla phfwdNonTrivialCount.
+ * Pobiera kolejne poddrzewa ze wspólnej tablicy zadań i zlicza ich numery,
+ * dopóki zadania się nie skończą. Wątek, który skończy swoje poddrzewo wcześniej,
+ * bierze następne, więc nierówne poddrzewa rozkładają się między wątki.
+ * @param[in,out] arg - wskaźnik na strukturę CountWorker wątku.
+ * @return Wartość NULL.
+ */
+static void * countWorker(void *arg) {
+    CountWorker *worker = arg;
+    CountJob *job = worker->job;
+    size_t i;
+
+    while ((i = __atomic_fetch_add(&job->next, 1, __ATOMIC_RELAXED)) < job->taskCount) {
+        CountTask *task = &job->tasks[i];
+
+        worker->result += countNonTrivial(job->pf, task->node, job->mask, job->len, task->actLen, job->n);
+    }
+
+    return NULL;
+}
+
+
+/** @brief Funkcja pomocnicza dla phfwdNonTrivialCount.
+ * Rozwija górne poziomy drzewa, aż uzyska co najmniej @p wanted poddrzew
+ * lub drzewo nie da się bardziej rozwinąć. Węzły, które kończą zliczanie
+ * (z niepustą tablicą rev lub długości len), są liczone od razu.
+ * @param[in] job - stan zliczania, którego tablica zadań jest wypełniana;
+ * @param[in] wanted - docelowa liczba poddrzew;
+ * @param[out] result - wynik dla węzłów policzonych podczas rozwijania.
+ * @return Wartość @p true, jeśli się udało.
+ *         Wartość @p false w przypadku problemów z alokacją pamięci.
+ */
+static bool splitCountTasks(CountJob *job, size_t wanted, size_t *result) {
+    struct PhoneForward *pf = job->pf;
+    size_t capacity = wanted * DIGITS;
+    CountTask *level = malloc(capacity * sizeof(CountTask));
+    CountTask *nextLevel = malloc(capacity * sizeof(CountTask));
+
+    if (level == NULL || nextLevel == NULL) {
+        free(level);
+        free(nextLevel);
+        return false;
+    }
+
+    size_t count = 1;
+
+    level[0].node = ROOT_NODE;
+    level[0].actLen = 0;
+    *result = 0;
+
+    // rozwijamy cały poziom naraz, dopóki zadań jest za mało, a kolejny poziom się mieści.
+    while (count > 0 && count < wanted && count * DIGITS <= capacity) {
+        size_t nextCount = 0;
+
+        for (size_t i = 0; i < count; i++) {
+            PfNode *node = getNode(pf, level[i].node);
+            size_t actLen = level[i].actLen;
+
+            // węzeł kończący zliczanie liczymy od razu.
+            if (node->minRevDepth > job->len || actLen == job->len || hasReverse(node)) {
+                *result += countNonTrivial(pf, level[i].node, job->mask, job->len, actLen, job->n);
+                continue;
+            }
+
+            uint8_t keys[DIGITS];
+            uint32_t kids[DIGITS];
+            int childCount = listChildren(pf, node, keys, kids);
+
+            for (int j = 0; j < childCount; j++) {
+                if (job->mask & (1u << keys[j])) {
+                    PfNode *child = getNode(pf, kids[j]);
+
+                    if (child->minRevDepth <= job->len && actLen + child->labelLen <= job->len
+                        && labelInSet(child, job->mask)) {
+                        nextLevel[nextCount].node = kids[j];
+                        nextLevel[nextCount].actLen = actLen + child->labelLen;
+                        nextCount++;
+                    }
+                }
+            }
+        }
+
+        CountTask *swap = level;
+
+        level = nextLevel;
+        nextLevel = swap;
+        count = nextCount;
+    }
+
+    free(nextLevel);
+    job->tasks = level;
+    job->taskCount = count;
+    job->next = 0;
+
+    return true;
+}
+
+
+/** @brief Funkcja pomocnicza dla phfwdNonTrivialCount.
+ * Zlicza nietrywialne numery, dzieląc drzewo na poddrzewa liczone przez
+ * @p threads wątków, w tym wątek wywołujący. Jeśli nie uda się zaalokować
+ * pamięci, liczy sekwencyjnie; jeśli nie uda się uruchomić któregoś wątku,
+ * jego pracę przejmują pozostałe.
+ * @param[in] pf - wskaźnik na strukturę przekierowań;
+ * @param[in] mask - maska cyfr setu;
+ * @param[in] len - długość numerów;
+ * @param[in] n - liczba różnych cyfr setu;
+ * @param[in] threads - liczba wątków.
+ * @return Wyliczoną liczbę nietrywialnych numerów.
+ */
+static size_t countParallel(struct PhoneForward *pf, uint16_t mask, size_t len, size_t n, unsigned threads) {
+    CountJob job = {.pf = pf, .mask = mask, .len = len, .n = n};
+    CountWorker workers[MAX_COUNT_THREADS];
+    size_t result;
+
+    if (!splitCountTasks(&job, (size_t) threads * TASKS_PER_THREAD, &result))
+        return countNonTrivial(pf, ROOT_NODE, mask, len, 0, n);
+
+    // za mało poddrzew, by opłacało się uruchamiać wątki.
+    if (job.taskCount < 2)
+        threads = 1;
+
+    unsigned started = 1;
+
+    for (unsigned i = 0; i < threads; i++) {
+        workers[i].job = &job;
+        workers[i].result = 0;
+    }
+
+    for (unsigned i = 1; i < threads; i++) {
+        if (pthread_create(&workers[i].thread, NULL, countWorker, &workers[i]) != 0)
+            break;
+
+        started++;
+    }
+
+    // wątek wywołujący również pobiera poddrzewa.
+    countWorker(&workers[0]);
+    result += workers[0].result;
+
+    for (unsigned i = 1; i < started; i++) {
+        pthread_join(workers[i].thread, NULL);
+        result += workers[i].result;
+    }
+
+    free(job.tasks);
+
+    return result;
+}
+
+
+/** @brief Przegląda otrzymany zestaw znaków set, pomijając te, które nie są cyframi.
+ * @param set - wskaźnik na rozpatrywany zestaw znaków set.
+ * @return Maskę cyfr, które pojawiły się w secie: bit i odpowiada cyfrze o wartości i.
+ */
+static uint16_t selectJustDigits(char const *set) {
+    uint16_t mask = 0;
+
+    // w masce zaznaczamy wystepujące w napisie set cyfry.
+    for (size_t i = 0; set[i] != '\0'; i++) {
+        char c = set[i];
+
+        if (c <= ';' && c >= '0')
+            mask |= (uint16_t) (1u << (c - '0'));
+    }
+
+    return mask;
+}
+
+
+/** @brief Wyznacza miejsce wpisu o danym kluczu w pamięci podręcznej wyników.
+ * @param[in] mask - maska cyfr setu;
+ * @param[in] len - długość numerów.
+ * @return Indeks wpisu w tablicy countCache.
+ */
+static size_t countCacheSlot(uint16_t mask, size_t len) {
+    size_t h = (size_t) mask * 31 + len;
+
+    h ^= h >> 7;
+
+    return h % COUNT_CACHE_SIZE;
+}
+
+
+/** @brief Funkcja pomocnicza dla phfwdNonTrivialCount.
+ * Zlicza nietrywialne numery, dzieląc duże drzewo między wątki.
+ * @param[in] pf - wskaźnik na strukturę przekierowań;
+ * @param[in] mask - maska cyfr setu;
+ * @param[in] len - długość numerów.
+ * @return Wyliczoną liczbę nietrywialnych numerów.
+ */
+static size_t computeNonTrivial(struct PhoneForward *pf, uint16_t mask, size_t len) {
+    size_t d = (size_t) __builtin_popcount(mask);
+
+    // duże drzewo liczymy równolegle.
+    if (pf->countThreads > 1 && pf->nodes.count >= PARALLEL_MIN_NODES)
+        return countParallel(pf, mask, len, d, pf->countThreads);
+
+    return countNonTrivial(pf, ROOT_NODE, mask, len, 0, d);
+}
+
+
+size_t phfwdNonTrivialCount(struct PhoneForward *pf, char const *set, size_t len) {
+    if (pf == NULL || set == NULL)
+        return 0;
+
+    //  num jest pustym ciagiem, lub len wynosi 0, zwracamy 0.
+    if (set[0] == '\0' || len == 0)
+        return 0;
+
+    uint16_t mask = selectJustDigits(set);
+    CountCacheEntry *entry = &pf->countCache[countCacheSlot(mask, len)];
+
+    // wynik dla tego zestawu cyfr i długości policzono od ostatniej modyfikacji.
+    if (entry->generation == pf->generation && entry->mask == mask && entry->len == len)
+        return entry->result;
+
+    size_t result = computeNonTrivial(pf, mask, len);
+
+    entry->generation = pf->generation;
+    entry->mask = mask;
+    entry->len = len;
+    entry->result = result;
+
+    return result;
+}
+
+
+size_t phfwdNonTrivialCountUncached(struct PhoneForward *pf, char const *set, size_t len) {
+    if (pf == NULL || set == NULL || set[0] == '\0' || len == 0)
+        return 0;
+
+    return computeNonTrivial(pf, selectJustDigits(set), len);
+}
+
+
+void phfwdSetCountThreads(struct PhoneForward *pf, unsigned threads) {
+    if (pf == NULL)
+        return;
+
+    if (threads == 0)
+        threads = 1;
+
+    if (threads > MAX_COUNT_THREADS)
+        threads = MAX_COUNT_THREADS;
+
+    pf->countThreads = threads;
+}
+
+
+/** @brief Funkcja pomocnicza dla funkcji phfwdFreeze.
+ * Ustala kolejność węzłów zamrożonej struktury, przechodząc drzewo wszerz,
+ * i zlicza elementy tablic rev oraz bajty długich etykiet.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania;
+ * @param[out] order - tablica na indeksy węzłów w kolejności przejścia;
+ * @param[out] map - tablica, w której pod indeksem węzła zostanie zapisany
+ *             jego indeks w zamrożonej strukturze;
+ * @param[out] revCount - łączna liczba elementów tablic rev;
+ * @param[out] labelBytes - łączny rozmiar etykiet dłuższych niż FROZEN_INLINE.
+ * @return Liczbę węzłów drzewa.
+ */
+static uint32_t orderFrozen(struct PhoneForward const *pf, uint32_t *order, uint32_t *map, size_t *revCount, size_t *labelBytes) {
+    uint8_t keys[DIGITS];
+    uint32_t kids[DIGITS];
+    uint32_t count = 1;
+
+    order[0] = ROOT_NODE;
+    map[ROOT_NODE] = ROOT_NODE;
+    (*revCount) = 0;
+    (*labelBytes) = 0;
+
+    // synowie każdego węzła trafiają do kolejki obok siebie, w porządku cyfr.
+    for (uint32_t head = 0; head < count; head++) {
+        PfNode const *node = getNode(pf, order[head]);
+        int childCount = listChildren(pf, node, keys, kids);
+
+        if (hasReverse(node))
+            (*revCount) += node->rev->count;
+
+        if (node->labelLen > FROZEN_INLINE)
+            (*labelBytes) += (node->labelLen + 1) / 2;
+
+        for (int i = 0; i < childCount; i++) {
+            map[kids[i]] = ROOT_NODE + count;
+            order[count++] = kids[i];
+        }
+    }
+
+    return count;
+}
+
+
+/** @brief Funkcja pomocnicza dla funkcji phfwdFreeze.
+ * Przepisuje węzły drzewa do tablic zamrożonej struktury.
+ * @param[in] pf - wskaźnik na strukturę przechowującą przekierowania;
+ * @param[in] order - indeksy węzłów w kolejności przejścia wszerz;
+ * @param[in] map - indeksy węzłów w zamrożonej strukturze;
+ * @param[in] count - liczba węzłów drzewa;
+ * @param[in,out] frozen - wskaźnik na zamrożoną strukturę z przydzielonymi tablicami.
+ */
+static void fillFrozen(struct PhoneForward const *pf, uint32_t const *order, uint32_t const *map,
+                       uint32_t count, struct PhfwdFrozen *frozen) {
+    FrozenNode *nodes = (FrozenNode*) frozen->nodes;
+    uint32_t *revs = (uint32_t*) frozen->revs;
+    uint8_t *labels = (uint8_t*) frozen->labels;
+    uint8_t keys[DIGITS];
+    uint32_t kids[DIGITS];
+    uint32_t revPos = 0;
+    uint32_t labelPos = 0;
+    // kolejni synowie w kolejności przejścia dostają kolejne indeksy.
+    uint32_t nextChild = ROOT_NODE + 1;
+
+    memset(&nodes[NO_NODE], 0, sizeof(FrozenNode));
+
+    for (uint32_t i = 0; i < count; i++) {
+        PfNode const *node = getNode(pf, order[i]);
+        FrozenNode *copy = &nodes[ROOT_NODE + i];
+        int childCount = listChildren(pf, node, keys, kids);
+
+        copy->firstChild = nextChild;
+        copy->parent = node->parent != NO_NODE ? map[node->parent] : NO_NODE;
+        copy->target = node->target != NO_NODE ? map[node->target] : NO_NODE;
+        copy->revStart = revPos;
+        copy->depth = node->depth;
+        copy->minRevDepth = node->minRevDepth;
+        copy->childMask = 0;
+        copy->labelLen = node->labelLen;
+        copy->unused = 0;
+
+        for (int j = 0; j < childCount; j++)
+            copy->childMask |= (uint16_t) (1u << keys[j]);
+
+        nextChild += (uint32_t) childCount;
+
+        // tablica rev jest posortowana według numerów, kolejność się nie zmienia.
+        if (hasReverse(node)) {
+            for (uint32_t j = 0; j < node->rev->count; j++)
+                revs[revPos++] = map[node->rev->nums[j]];
+        }
+
+        uint8_t *label = copy->label;
+
+        if (node->labelLen > FROZEN_INLINE) {
+            copy->labelStart = labelPos;
+            label = labels + labelPos;
+            labelPos += (node->labelLen + 1) / 2;
+        }
+        else {
+            memset(copy->label, 0, FROZEN_INLINE / 2);
+        }
+
+        // zamrożona etykieta zaczyna się od pierwszej cyfry krawędzi, po dwie cyfry w bajcie.
+        for (int j = 0; j < node->labelLen; j += 2) {
+            int high = j + 1 < node->labelLen ? labelDigit(node, j + 1) : 0;
+
+            label[j >> 1] = (uint8_t) (labelDigit(node, j) | (high << 4));
+        }
+    }
+
+    // strażnik wyznacza koniec tablicy rev ostatniego węzła.
+    memset(&nodes[ROOT_NODE + count], 0, sizeof(FrozenNode));
+    nodes[ROOT_NODE + count].revStart = revPos;
+}
+
+
+struct PhfwdFrozen * phfwdFreeze(struct PhoneForward const *pf) {
+    if (pf == NULL)
+        return NULL;
+
+    struct PhfwdFrozen *frozen = malloc(sizeof(struct PhfwdFrozen));
+    uint32_t *order = malloc(pf->nodes.count * sizeof(uint32_t));
+    uint32_t *map = malloc(pf->nodes.count * sizeof(uint32_t));
+
+    // problem z alokacją pamięci.
+    if (frozen == NULL || order == NULL || map == NULL) {
+        free(frozen);
+        free(order);
+        free(map);
+        return NULL;
+    }
+
+    // przy współbieżnych odczytach modyfikacje mogą trwać, wstrzymujemy je.
+    if (pf->sync != NULL)
+        pthread_mutex_lock(&pf->sync->writeLock);
+
+    size_t revCount;
+    size_t labelBytes;
+    uint32_t count = orderFrozen(pf, order, map, &revCount, &labelBytes);
+    size_t nodesSize = ((size_t) count + 2) * sizeof(FrozenNode);
+    size_t revsSize = revCount * sizeof(uint32_t);
+
+    // węzły, tablice rev i etykiety leżą w jednym bloku pamięci.
+    frozen->block = malloc(nodesSize + revsSize + labelBytes);
+
+    if (frozen->block != NULL) {
+        frozen->nodes = frozen->block;
+        frozen->revs = (uint32_t*) ((char*) frozen->block + nodesSize);
+        frozen->labels = (uint8_t*) frozen->block + nodesSize + revsSize;
+        frozen->nodeCount = count + 2;
+        frozen->revCount = (uint32_t) revCount;
+        frozen->labelBytes = labelBytes;
+        frozen->mapping = NULL;
+        frozen->mappingSize = 0;
+        fillFrozen(pf, order, map, count, frozen);
+    }
+
+    if (pf->sync != NULL)
+        pthread_mutex_unlock(&pf->sync->writeLock);
+
+    free(order);
+    free(map);
+
+    // problem z alokacją pamięci.
+    if (frozen->block == NULL) {
+        free(frozen);
+        return NULL;
+    }
+
+    return frozen;
+}
+
+
+void phfwdFrozenDelete(struct PhfwdFrozen *frozen) {
+    if (frozen == NULL)
+        return;
+
+    if (frozen->mapping != NULL)
+        munmap(frozen->mapping, frozen->mappingSize);
+
+    free(frozen->block);
+    free(frozen);
+}
+
+
+/** @brief Udostępnia spakowaną etykietę węzła zamrożonej struktury.
+ * @param[in] frozen - wskaźnik na zamrożoną strukturę;
+ * @param[in] node - wskaźnik na węzeł.
+ * @return Wskaźnik na cyfry etykiety zapisane po dwie w bajcie.
+ */
+static inline uint8_t const * frozenLabel(struct PhfwdFrozen const *frozen, FrozenNode const *node) {
+    return node->labelLen > FROZEN_INLINE ? frozen->labels + node->labelStart : node->label;
+}
+
+
+/** @brief Wyznacza syna węzła zamrożonej struktury.
+ * @param[in] node - wskaźnik na węzeł;
+ * @param[in] x - cyfra, od której zaczyna się etykieta syna.
+ * @return Indeks syna lub NO_NODE, jeśli takiego syna nie ma.
+ */
+static inline uint32_t frozenChild(FrozenNode const *node, int x) {
+    if (!(node->childMask & (1u << x)))
+        return NO_NODE;
+
+    return node->firstChild + (uint32_t) __builtin_popcount(node->childMask & ((1u << x) - 1));
+}
+
+
+/** @brief Przechodzi krawędź zamrożonej struktury zgodnie z numerem.
+ * @param[in] frozen - wskaźnik na zamrożoną strukturę;
+ * @param[in] node - indeks ojca;
+ * @param[in] num - wskaźnik na napis reprezentujący pozostałą część numeru.
+ * @return Indeks syna, którego cała etykieta jest prefiksem @p num,
+ *         lub NO_NODE, jeśli takiego syna nie ma.
+ */
+static inline uint32_t frozenStep(struct PhfwdFrozen const *frozen, uint32_t node, char const *num) {
+    uint32_t child = frozenChild(&frozen->nodes[node], (int) num[0] - (int) '0');
+
+    if (child == NO_NODE)
+        return NO_NODE;
+
+    FrozenNode const *next = &frozen->nodes[child];
+    uint8_t const *label = frozenLabel(frozen, next);
+
+    // pierwsza cyfra etykiety jest zgodna, koniec numeru nie jest cyfrą,
+    // więc porównanie się na nim zatrzyma.
+    for (int p = 1; p < next->labelLen; p++) {
+        if ((int) num[p] - (int) '0' != ((label[p >> 1] >> ((p & 1) << 2)) & 0xF))
+            return NO_NODE;
+    }
+
+    return child;
+}
+
+
+/** @brief Zapisuje numer reprezentowany przez węzeł zamrożonej struktury.
+ * @param[in] frozen - wskaźnik na zamrożoną strukturę;
+ * @param[in] idx - indeks węzła;
+ * @param[in] buf - bufor na co najmniej depth znaków węzła, numer nie jest
+ *            zakończony znakiem '\0'.
+ */
+static void writeFrozenKey(struct PhfwdFrozen const *frozen, uint32_t idx, char *buf) {
+    FrozenNode const *node = &frozen->nodes[idx];
+    size_t end = node->depth;
+
+    while (node->labelLen > 0) {
+        uint8_t const *label = frozenLabel(frozen, node);
+
+        end -= node->labelLen;
+
+        for (int p = 0; p < node->labelLen; p++)
+            buf[end + p] = (char) ('0' + ((label[p >> 1] >> ((p & 1) << 2)) & 0xF));
+
+        node = &frozen->nodes[node->parent];
+    }
+}
+
+
+struct PhoneNumbers const * phfwdFrozenGet(struct PhfwdFrozen const *frozen, char const *num) {
+    if (frozen == NULL || num == NULL)
+        return NULL;
+
+    // num nie reprezentuje numeru.
+    if (!checkIfNumber(num) || num[0] == '\0')
+        return createPhoneNumbers(0, 0);
+
+    uint32_t node = ROOT_NODE;
+    uint32_t target = NO_NODE;
+    size_t where = 0;
+    size_t i = 0;
+
+    while (num[i] != '\0') {
+        node = frozenStep(frozen, node, num + i);
+
+        if (node == NO_NODE)
+            break;
+
+        i += frozen->nodes[node].labelLen;
+
+        if (frozen->nodes[node].target != NO_NODE) {
+            target = frozen->nodes[node].target;
+            where = i;
+        }
+    }
+
+    size_t numLength = i + strlen(num + i);
+    size_t foundNumLength = target != NO_NODE ? frozen->nodes[target].depth : 0;
+    size_t n = numLength + 1 - where + foundNumLength;
+    struct PhoneNumbers *pnum = createPhoneNumbers(1, n);
+
+    // problem z alokacją pamięci.
+    if (pnum == NULL)
+        return NULL;
+
+    char *finalNumber = numbersData(pnum);
+    pnum->offsets[0] = 0;
+
+    if (target != NO_NODE)
+        writeFrozenKey(frozen, target, finalNumber);
+
+    memcpy(finalNumber + foundNumLength, num + where, numLength - where + 1);
 
-    return list;
+    return pnum;
 }
 
 
-/** @brief Funkcja pomocnicza dla phfwdNonTrivialCount.
- * Oblicza wynik działania a^b.
- * @param[in] a - podstawa poęgi;
- * @param[in] b - wykładnik potęgi.
- * @return Wynik działania a^b.
+/** @brief Funkcja pomocnicza dla funkcji phfwdFrozenReverse.
+ * Przechodzi ścieżkę numeru num i tworzy strumień kandydatów dla każdego
+ * węzła ścieżki z niepustą tablicą rev.
+ * @param[in] frozen - wskaźnik na zamrożoną strukturę;
+ * @param[in] num – wskaźnik na napis reprezentujący numer;
+ * @param[in] streams - tablica, do której zostaną zapisane strumienie;
+ * @param[in] total - wskaźnik na zmienną, do której zostanie zapisana łączna
+ *            liczba kandydatów.
+ * @return Liczbę utworzonych strumieni.
  */
-static size_t raiseToPower(size_t a, size_t b) {
-    size_t result = 1;
+static size_t frozenReverseStreams(struct PhfwdFrozen const *frozen, char const *num, RevStream *streams, size_t *total) {
+    uint32_t node = ROOT_NODE;
+    size_t streamCount = 0;
+    size_t i = 0;
 
-    while (b > 0) {
-        if (b % 2 == 1)
-            result *= a;
+    (*total) = 0;
 
-        a *= a;
-        b /= 2;
+    while (num[i] != '\0') {
+        node = frozenStep(frozen, node, num + i);
+
+        // niżej nie ma przekierowań.
+        if (node == NO_NODE)
+            break;
+
+        i += frozen->nodes[node].labelLen;
+
+        uint32_t start = frozen->nodes[node].revStart;
+        uint32_t count = frozen->nodes[node + 1].revStart - start;
+
+        if (count > 0) {
+            streams[streamCount].sources = frozen->revs + start;
+            streams[streamCount].count = count;
+            streams[streamCount].pos = 0;
+            streams[streamCount].suffix = num + i;
+            (*total) += count;
+            streamCount++;
+        }
+    }
+
+    return streamCount;
+}
+
+
+struct PhoneNumbers const * phfwdFrozenReverse(struct PhfwdFrozen const *frozen, char const *num) {
+    static char const empty[] = "";
+
+    if (frozen == NULL || num == NULL)
+        return NULL;
+
+    size_t numLength;
+    // num nie reprezentuje numeru lub num jest pustym ciagiem.
+    if (!scanNumber(num, &numLength) || numLength == 0)
+        return createPhoneNumbers(0, 0);
+
+    // każdy węzeł ścieżki odpowiada co najmniej jednej cyfrze numeru,
+    // dodatkowy strumień zawiera sam numer otrzymany od użytkownika.
+    RevStream *streams = malloc((numLength + 1) * sizeof(RevStream));
+    uint32_t *heap = malloc((numLength + 1) * sizeof(uint32_t));
+    size_t total = 0;
+    size_t streamCount = streams != NULL ? frozenReverseStreams(frozen, num, streams, &total) : 0;
+    size_t keyChars = 0;
+
+    for (size_t j = 0; j < streamCount; j++) {
+        for (uint32_t k = 0; k < streams[j].count; k++)
+            keyChars += frozen->nodes[streams[j].sources[k]].depth + 1;
     }
 
+    char const **order = malloc((total + 1) * sizeof(char const*));
+    char *keys = malloc(keyChars);
+    struct PhoneNumbers *result = NULL;
+
+    if (streams != NULL && heap != NULL && order != NULL && (keys != NULL || keyChars == 0)) {
+        size_t used = 0;
+        size_t keyOffset = 0;
+
+        // odtworzenie numerów węzłów strumieni.
+        for (size_t j = 0; j < streamCount; j++) {
+            streams[j].nums = order + used;
+
+            for (uint32_t k = 0; k < streams[j].count; k++) {
+                uint32_t source = streams[j].sources[k];
+                size_t depth = frozen->nodes[source].depth;
+
+                writeFrozenKey(frozen, source, keys + keyOffset);
+                keys[keyOffset + depth] = '\0';
+                order[used + k] = keys + keyOffset;
+                keyOffset += depth + 1;
+            }
+
+            used += streams[j].count;
+        }
+
+        order[total] = empty;
+        streams[streamCount].sources = NULL;
+        streams[streamCount].nums = order + total;
+        streams[streamCount].count = 1;
+        streams[streamCount].pos = 0;
+        streams[streamCount].suffix = num;
+
+        result = mergeStreams(streams, heap, streamCount + 1, total + 1);
+    }
+
+    free(streams);
+    free(heap);
+    free(order);
+    free(keys);
+
     return result;
 }
 
 
-/** @brief Funkcja pomocnicza dla phfwdNonTrivialCount.
- * Wywołuje się rekurencyjnie na całym drzewie, zliczając nietrywialne numery.
- * @param[in] pf - wskaźnik na strukturę przekierowań, na której operujemy.
- * @param[in] tab - tablica, mówiąca nam o tym, które cyfry wystapiły w secie;
+/** @brief Funkcja pomocnicza dla phfwdFrozenNonTrivialCount.
+ * Wywołuje się rekurencyjnie na poddrzewie, zliczając nietrywialne numery,
+ * tak jak funkcja countNonTrivial.
+ * @param[in] frozen - wskaźnik na zamrożoną strukturę;
+ * @param[in] idx - indeks rozpatrywanego węzła;
+ * @param[in] mask - maska cyfr, które wystąpiły w secie;
  * @param[in] len - długość numeru, jaką rozpatrujemy;
- * @param[in] actLen - aktualna głębokość węzła w którym jesteśmy;
  * @param[in] n - liczba różnych cyfr w napisie set.
  * @return Wyliczoną liczbę nietrywialnych numerów.
  */
-size_t countNonTrivial(struct PhoneForward *pf, bool tab[], size_t len, size_t actLen, size_t n) {
+static size_t countFrozen(struct PhfwdFrozen const *frozen, uint32_t idx, uint16_t mask, size_t len, size_t n) {
+    FrozenNode const *node = &frozen->nodes[idx];
+
+    // dany węzeł posiada jakieś odwrotne przekierowania.
+    if (frozen->nodes[idx + 1].revStart > node->revStart)
+        return raiseToPower(n, len - node->depth);
+
     size_t result = 0;
+    uint16_t kids = node->childMask & mask;
+    uint32_t child = node->firstChild;
+
+    // synowie leżą obok siebie, kolejni w porządku cyfr.
+    for (int x = 0; x < DIGITS; x++) {
+        if (!(node->childMask & (1u << x)))
+            continue;
+
+        FrozenNode const *next = &frozen->nodes[child];
+
+        if ((kids & (1u << x)) && next->minRevDepth <= len && next->depth <= len) {
+            uint8_t const *label = frozenLabel(frozen, next);
+            bool inSet = true;
+
+            for (int p = 1; p < next->labelLen && inSet; p++)
+                inSet = (mask & (1u << ((label[p >> 1] >> ((p & 1) << 2)) & 0xF))) != 0;
+
+            if (inSet)
+                result += countFrozen(frozen, child, mask, len, n);
+        }
+
+        child++;
+    }
+
+    return result;
+}
+
+
+size_t phfwdFrozenNonTrivialCount(struct PhfwdFrozen const *frozen, char const *set, size_t len) {
+    if (frozen == NULL || set == NULL || set[0] == '\0' || len == 0)
+        return 0;
+
+    uint16_t mask = selectJustDigits(set);
+
+    // w strukturze nie ma przekierowań na numery nie dłuższe niż len.
+    if (frozen->nodes[ROOT_NODE].minRevDepth > len)
+        return 0;
+
+    return countFrozen(frozen, ROOT_NODE, mask, len, (size_t) __builtin_popcount(mask));
+}
+
+
+/** @brief Funkcja pomocnicza dla funkcji phfwdThaw.
+ * Przepisuje węzeł zamrożonej struktury do węzła o tym samym indeksie.
+ * @param[in] pf - wskaźnik na tworzoną strukturę, zawierającą już wszystkie węzły;
+ * @param[in] frozen - wskaźnik na zamrożoną strukturę;
+ * @param[in] idx - indeks węzła.
+ * @return Wartość @p true, jeśli się udało.
+ *         Wartość @p false w przypadku problemów z alokacją pamięci.
+ */
+static bool thawNode(struct PhoneForward *pf, struct PhfwdFrozen const *frozen, uint32_t idx) {
+    FrozenNode const *copy = &frozen->nodes[idx];
+    PfNode *node = getNode(pf, idx);
+    uint32_t revCount = frozen->nodes[idx + 1].revStart - copy->revStart;
+    uint32_t child = copy->firstChild;
+
+    node->parent = copy->parent;
+    node->target = copy->target;
+    node->depth = copy->depth;
+    node->minRevDepth = copy->minRevDepth;
+    node->labelLen = copy->labelLen;
+    memset(node->label, 0, LABEL_BYTES);
+
+    // ojciec leży wcześniej w kolejności przejścia wszerz, ma już ustawione cyfry numeru.
+    if (copy->labelLen > 0) {
+        uint8_t const *label = frozenLabel(frozen, copy);
+        char digits[LABEL_MAX];
+
+        for (int p = 0; p < copy->labelLen; p++)
+            digits[p] = (char) ('0' + ((label[p >> 1] >> ((p & 1) << 2)) & 0xF));
+
+        setLabel(node, getNode(pf, copy->parent), digits, copy->labelLen);
+    }
+
+    // synowie mają te same indeksy, kolejni w porządku cyfr.
+    for (int x = 0; x < DIGITS; x++) {
+        if ((copy->childMask & (1u << x)) && !setChild(pf, node, x, child++))
+            return false;
+    }
+
+    if (revCount > 0) {
+        node->rev = resizeRevArray(NULL, revCount);
+
+        // problem z alokacją pamięci.
+        if (node->rev == NULL)
+            return false;
+
+        node->rev->count = revCount;
+        node->rev->capacity = revCount;
+        memcpy(node->rev->nums, frozen->revs + copy->revStart, revCount * sizeof(uint32_t));
+    }
 
+    return true;
+}
+
+
+struct PhoneForward * phfwdThaw(struct PhfwdFrozen const *frozen) {
+    if (frozen == NULL)
+        return NULL;
+
+    struct PhoneForward *pf = phfwdNew();
+
+    // problem z alokacją pamięci.
     if (pf == NULL)
-        return result;
+        return NULL;
 
-    // zeszliśmy na maksymalną głębokość, nie szukamy dłuższego numeru.
-    if (actLen == len) {
-        if ((pf->rev)->next != NULL)
-            result = 1;
+    // węzły świeżej struktury dostają kolejne indeksy, takie jak w zamrożonej.
+    bool ok = true;
 
-        return result;
+    for (uint32_t i = ROOT_NODE + 1; ok && i + 1 < frozen->nodeCount; i++)
+        ok = createNewElement(pf) == i;
+
+    for (uint32_t i = ROOT_NODE; ok && i + 1 < frozen->nodeCount; i++)
+        ok = thawNode(pf, frozen, i);
+
+    // problem z alokacją pamięci.
+    if (!ok) {
+        phfwdDelete(pf);
+        return NULL;
     }
 
-    // dany węzeł posiada jakieś odwrotne przekierowania, dodajemy odpowiednią wartość do wyniku,
-    // nie szchodzimy już dojego synów.
-    if ((pf->rev)->next != NULL) {
-        result = raiseToPower(n, len - actLen);
+    return pf;
+}
 
-        return result;
+
+/**
+ * Numer przekierowania przy tworzeniu struktury z wielu przekierowań naraz.
+ */
+typedef struct buildEntry {
+    char const *num; // numer.
+    size_t order; // podwojona pozycja przekierowania, powiększona o 1 dla numeru docelowego.
+    uint64_t key; // pierwsze BUILD_KEY_DIGITS cyfr numeru powiększonych o 1, po cztery bity, od najstarszych.
+} BuildEntry;
+
+
+/** @brief Wyznacza klucz numeru, uporządkowany tak jak jego początek.
+ * Krótszy numer ma na końcu klucza zera, więc poprzedza swoje przedłużenia.
+ * @param[in] num - wskaźnik na numer.
+ * @return Klucz numeru.
+ */
+static inline uint64_t entryKey(char const *num) {
+    uint64_t key = 0;
+
+    for (int i = 0; i < BUILD_KEY_DIGITS && num[i] != '\0'; i++)
+        key |= (uint64_t) ((int) num[i] - (int) '0' + 1) << (60 - 4 * i);
+
+    return key;
+}
+
+
+/** @brief Porównuje numery przekierowań według ich napisów i pozycji.
+ * @param[in] a - wskaźnik na pierwszy numer;
+ * @param[in] b - wskaźnik na drugi numer.
+ * @return Wartość ujemna, zero lub dodatnia, jak dla funkcji strcmp.
+ */
+static int compareEntries(void const *a, void const *b) {
+    BuildEntry const *entryA = a;
+    BuildEntry const *entryB = b;
+    int cmp = strcmp(entryA->num, entryB->num);
+
+    if (cmp != 0)
+        return cmp;
+
+    return entryA->order < entryB->order ? -1 : entryA->order > entryB->order;
+}
+
+
+/** @brief Sprawdza, czy dwa numery przekierowań są równe.
+ * @param[in] a - wskaźnik na pierwszy numer;
+ * @param[in] b - wskaźnik na drugi numer.
+ * @return Wartość @p true, jeśli numery są równe.
+ */
+static inline bool sameEntries(BuildEntry const *a, BuildEntry const *b) {
+    // zero na końcu klucza oznacza, że numer się w nim mieści.
+    return a->key == b->key
+           && ((a->key & 0xF) == 0 || strcmp(a->num + BUILD_KEY_DIGITS, b->num + BUILD_KEY_DIGITS) == 0);
+}
+
+
+/** @brief Wyznacza długość wspólnego prefiksu dwóch różnych numerów przekierowań.
+ * @param[in] a - wskaźnik na pierwszy numer;
+ * @param[in] b - wskaźnik na drugi numer.
+ * @return Długość wspólnego prefiksu.
+ */
+static inline size_t entriesPrefix(BuildEntry const *a, BuildEntry const *b) {
+    uint64_t diff = a->key ^ b->key;
+
+    if (diff != 0)
+        return (size_t) __builtin_clzll(diff) / 4;
+
+    return BUILD_KEY_DIGITS + sharedPrefix(a->num + BUILD_KEY_DIGITS, b->num + BUILD_KEY_DIGITS);
+}
+
+
+/** @brief Porządkuje numery przekierowań.
+ * Sortuje stabilnie pozycyjnie według kluczy, po bajcie w przebiegu,
+ * pomijając przebiegi, w których wszystkie klucze mają ten sam bajt. Numery
+ * dłuższe niż BUILD_KEY_DIGITS o równych kluczach porządkuje funkcją qsort.
+ * @param[in,out] entries - adres wskaźnika na tablicę numerów, uporządkowanych
+ *                według pozycji; tablica może zostać zastąpiona inną;
+ * @param[in] count - liczba numerów.
+ * @return Wartość @p true, jeśli się udało.
+ *         Wartość @p false w przypadku problemów z alokacją pamięci.
+ */
+static bool radixSortEntries(BuildEntry **entries, size_t count) {
+    BuildEntry *from = (*entries);
+    BuildEntry *to = malloc((count + 1) * sizeof(BuildEntry));
+    size_t buckets[256];
+
+    // problem z alokacją pamięci.
+    if (to == NULL)
+        return false;
+
+    for (int shift = 0; count > 0 && shift < 64; shift += 8) {
+        memset(buckets, 0, sizeof(buckets));
+
+        for (size_t i = 0; i < count; i++)
+            buckets[(from[i].key >> shift) & 0xFF]++;
+
+        // przebieg niczego by nie zmienił.
+        if (buckets[(from[0].key >> shift) & 0xFF] == count)
+            continue;
+
+        size_t pos = 0;
+
+        for (int b = 0; b < 256; b++) {
+            size_t size = buckets[b];
+
+            buckets[b] = pos;
+            pos += size;
+        }
+
+        for (size_t i = 0; i < count; i++)
+            to[buckets[(from[i].key >> shift) & 0xFF]++] = from[i];
+
+        BuildEntry *temp = from;
+
+        from = to;
+        to = temp;
     }
 
-    // jeśli nie posiadał żadnych numerów na liście rev,
-    // wywołujemy się rekurencyjnie na synach, będących w secie.
-    for (size_t i = 0; i < 12; i++) {
-        if (tab[i])
-            result += countNonTrivial(pf->digits[i], tab, len, actLen + 1, n);
+    free(to);
+    (*entries) = from;
+
+    for (size_t i = 0; i < count;) {
+        size_t end = i + 1;
+
+        while (end < count && from[end].key == from[i].key)
+            end++;
+
+        // klucz nie obejmuje całych numerów.
+        if ((from[i].key & 0xF) != 0 && end - i > 1)
+            qsort(from + i, end - i, sizeof(BuildEntry), compareEntries);
+
+        i = end;
     }
 
-    return result;
+    return true;
 }
 
 
-/** @brief Przegląda otrzymany zestaw znaków set, pomijając te, które nie są cyframi.
- * Zaznacza również w tablicy tab, które cyfry wystąpiły w secie.
- * @param set - wskaźnik na rozpatrywany zestaw znaków set;
- * @param[in] tab - tablica, na której zaznaczamy, które cyfry pojawiły się w secie;
- * @param[in] d - wskaźnik na zmienną, zliczającą liczbę różnych cyfr w numerze num.
+/** @brief Funkcja pomocnicza dla funkcji phfwdBuild.
+ * Zbiera numery przekierowań, które dodałaby funkcja phfwdAdd, i porządkuje je.
+ * Równe numery leżą według pozycji przekierowań.
+ * @param[in] num1 - tablica numerów przekierowywanych;
+ * @param[in] num2 - tablica numerów docelowych;
+ * @param[in] n - liczba przekierowań;
+ * @param[out] count - liczba zebranych numerów;
+ * @param[out] maxLength - długość najdłuższego numeru.
+ * @return Wskaźnik na uporządkowaną tablicę numerów lub NULL w przypadku
+ *         problemów z alokacją pamięci.
  */
-static void selectJustDigits(char const *set, bool tab[], size_t *d) {
-    if (set == NULL)
-        return;
+static BuildEntry * sortEntries(char const * const *num1, char const * const *num2, size_t n, size_t *count,
+                                size_t *maxLength) {
+    BuildEntry *entries = malloc((2 * n + 1) * sizeof(BuildEntry));
+
+    // problem z alokacją pamięci.
+    if (entries == NULL)
+        return NULL;
 
-    size_t n = strlen(set);
-    int x;
-    char c;
+    (*count) = 0;
+    (*maxLength) = 0;
 
-    // w tablicy tab zaznaczamy wystepujące w napisie set cyfry.
     for (size_t i = 0; i < n; i++) {
-        c = set[i];
+        size_t length1;
+        size_t length2;
+
+        // takiego przekierowania phfwdAdd by nie dodała.
+        if (num1[i] == NULL || num2[i] == NULL || !scanNumber(num1[i], &length1) || !scanNumber(num2[i], &length2)
+            || length1 == 0 || length2 == 0 || strcmp(num1[i], num2[i]) == 0)
+            continue;
+
+        if (length1 > (*maxLength))
+            (*maxLength) = length1;
+
+        if (length2 > (*maxLength))
+            (*maxLength) = length2;
+
+        entries[(*count)].num = num1[i];
+        entries[(*count)].key = entryKey(num1[i]);
+        entries[(*count)++].order = 2 * i;
+        entries[(*count)].num = num2[i];
+        entries[(*count)].key = entryKey(num2[i]);
+        entries[(*count)++].order = 2 * i + 1;
+    }
 
-        if (c <= ';' && c >= '0') {
-            x = (int) c - (int) '0';
+    if (!radixSortEntries(&entries, (*count))) {
+        free(entries);
+        return NULL;
+    }
 
-            if (!tab[x]) {
-                tab[x] = true;
-                (*d) += 1;
-            }
+    return entries;
+}
+
+
+/** @brief Funkcja pomocnicza dla funkcji phfwdBuild.
+ * Wyznacza przekierowania, które pozostałyby po dodaniu wszystkich:
+ * z przekierowań o tym samym numerze przekierowywanym ostatnie.
+ * @param[in] entries - uporządkowana tablica numerów;
+ * @param[in] count - liczba numerów;
+ * @param[out] wins - tablica, w której pod pozycją przekierowania zostanie
+ *             zapisane, czy pozostaje ono w strukturze.
+ */
+static void markWinners(BuildEntry const *entries, size_t count, bool *wins) {
+    bool later = false;
+
+    // równe numery leżą według pozycji, przeglądamy je od ostatniego.
+    for (size_t i = count; i-- > 0;) {
+        if (i + 1 < count && !sameEntries(&entries[i], &entries[i + 1]))
+            later = false;
+
+        if (entries[i].order % 2 == 0) {
+            wins[entries[i].order / 2] = !later;
+            later = true;
         }
     }
 }
 
 
-size_t phfwdNonTrivialCount(struct PhoneForward *pf, char const *set, size_t len) {
-    if (pf == NULL || set == NULL)
-        return 0;
+/** @brief Funkcja pomocnicza dla funkcji phfwdBuild.
+ * Tworzy węzeł numeru większego od wszystkich dotąd wstawionych. Zdejmuje
+ * ze stosu węzły, których numery nie są prefiksami numeru, w razie potrzeby
+ * rozdziela krawędź i dokłada nowe węzły na koniec ścieżki.
+ * @param[in,out] pf - wskaźnik na tworzoną strukturę;
+ * @param[in,out] path - stos węzłów ścieżki poprzedniego numeru, na dnie leży korzeń;
+ * @param[in,out] height - liczba węzłów na stosie;
+ * @param[in] num - wskaźnik na numer;
+ * @param[in] shared - długość wspólnego prefiksu numeru i poprzedniego numeru.
+ * @return Indeks węzła numeru lub NO_NODE w przypadku problemów z alokacją pamięci.
+ */
+static uint32_t appendNumber(struct PhoneForward *pf, uint32_t *path, size_t *height, char const *num, size_t shared) {
+    uint32_t below = NO_NODE;
 
-    //  num jest pustym ciagiem, lub len wynosi 0, zwracamy 0.
-    if (set[0] == '\0' || len == 0)
-        return 0;
+    while (getNode(pf, path[(*height) - 1])->depth > shared)
+        below = path[--(*height)];
 
-    // tablica służąca uniknięciu powtórzeń w zestawie set.
-    bool tab[12] = {false};
-    size_t result = 0;
-    size_t d = 0;
+    uint32_t topIdx = path[(*height) - 1];
 
-    selectJustDigits(set, tab, &d);
+    // numery rozchodzą się w środku etykiety, rozdzielamy krawędź.
+    if (getNode(pf, topIdx)->depth < shared) {
+        uint32_t mid = createNewElement(pf);
 
-    result = countNonTrivial(pf, tab, len, 0, d);
+        // problem z alokacją pamięci.
+        if (mid == NO_NODE)
+            return NO_NODE;
 
-    return result;
+        PfNode *top = getNode(pf, topIdx);
+        PfNode *midNode = getNode(pf, mid);
+        PfNode *belowNode = getNode(pf, below);
+        int p = (int) (shared - top->depth);
+
+        setLabel(midNode, top, num + top->depth, p);
+        midNode->parent = topIdx;
+        setChild(pf, midNode, numberDigit(belowNode, (uint32_t) shared), below);
+
+        // numer rozdzielanego węzła się nie zmienia, skraca się tylko jego etykieta.
+        belowNode->labelLen = (uint8_t) (belowNode->labelLen - p);
+        belowNode->parent = mid;
+
+        // zastąpienie istniejącego syna nie wymaga alokacji pamięci.
+        setChild(pf, top, (int) num[top->depth] - (int) '0', mid);
+        path[(*height)++] = mid;
+    }
+
+    size_t i = shared;
+
+    // reszta numeru trafia do nowych węzłów z możliwie najdłuższymi etykietami.
+    while (num[i] != '\0') {
+        uint32_t parentIdx = path[(*height) - 1];
+        uint32_t newEl = createNewElement(pf);
+
+        // problem z alokacją pamięci.
+        if (newEl == NO_NODE)
+            return NO_NODE;
+
+        PfNode *parent = getNode(pf, parentIdx);
+        PfNode *newNode = getNode(pf, newEl);
+        int x = (int) num[i] - (int) '0';
+
+        int len = 0;
+
+        while (len < LABEL_MAX && num[i + len] != '\0')
+            len++;
+
+        setLabel(newNode, parent, num + i, len);
+        newNode->parent = parentIdx;
+        i += len;
+        path[(*height)++] = newEl;
+
+        // problem z alokacją pamięci.
+        if (!setChild(pf, parent, x, newEl))
+            return NO_NODE;
+    }
+
+    return path[(*height) - 1];
 }
 
 
-void phnumDelete(struct PhoneNumbers const *pnum) {
-    if (pnum != NULL) {
-        while (pnum != NULL) {
-            struct PhoneNumbers const *temp = pnum;
-            pnum = pnum->next;
+/** @brief Funkcja pomocnicza dla funkcji phfwdBuild.
+ * Tworzy węzły numerów pozostających przekierowań, w kolejności numerów.
+ * @param[in,out] pf - wskaźnik na tworzoną strukturę;
+ * @param[in] entries - uporządkowana tablica numerów;
+ * @param[in] count - liczba numerów;
+ * @param[in] wins - informacja, które przekierowania pozostają w strukturze;
+ * @param[in] path - tablica na stos węzłów, o rozmiarze większym od długości
+ *            najdłuższego numeru;
+ * @param[out] nodes - tablica, w której pod wartością pola order numeru zostanie
+ *             zapisany indeks jego węzła.
+ * @return Wartość @p true, jeśli się udało.
+ *         Wartość @p false w przypadku problemów z alokacją pamięci.
+ */
+static bool buildNodes(struct PhoneForward *pf, BuildEntry const *entries, size_t count, bool const *wins,
+                       uint32_t *path, uint32_t *nodes) {
+    BuildEntry const *previous = NULL;
+    size_t height = 1;
+    size_t i = 0;
+
+    path[0] = ROOT_NODE;
+
+    while (i < count) {
+        size_t end = i;
+        bool needed = false;
+
+        // równe numery mają wspólny węzeł, potrzebny, jeśli używa go któreś z pozostających przekierowań.
+        while (end < count && (end == i || sameEntries(&entries[end], &entries[i])))
+            needed |= wins[entries[end++].order / 2];
+
+        if (needed) {
+            size_t shared = previous != NULL ? entriesPrefix(previous, &entries[i]) : 0;
+            uint32_t idx = appendNumber(pf, path, &height, entries[i].num, shared);
+
+            // problem z alokacją pamięci.
+            if (idx == NO_NODE)
+                return false;
+
+            for (size_t j = i; j < end; j++)
+                nodes[entries[j].order] = idx;
+
+            previous = &entries[i];
+        }
+
+        i = end;
+    }
+
+    return true;
+}
+
+
+/** @brief Funkcja pomocnicza dla funkcji phfwdBuild.
+ * Ustawia przekierowania i wypełnia tablice rev. Numery przekierowywane
+ * są przeglądane w kolejności, więc tablice rev od razu są posortowane.
+ * @param[in,out] pf - wskaźnik na tworzoną strukturę;
+ * @param[in] entries - uporządkowana tablica numerów;
+ * @param[in] count - liczba numerów;
+ * @param[in] wins - informacja, które przekierowania pozostają w strukturze;
+ * @param[in] nodes - indeksy węzłów numerów.
+ * @return Wartość @p true, jeśli się udało.
+ *         Wartość @p false w przypadku problemów z alokacją pamięci.
+ */
+static bool buildForwardings(struct PhoneForward *pf, BuildEntry const *entries, size_t count, bool const *wins,
+                             uint32_t const *nodes) {
+    uint32_t *revCounts = calloc(pf->nodes.count, sizeof(uint32_t));
+
+    // problem z alokacją pamięci.
+    if (revCounts == NULL)
+        return false;
+
+    for (size_t i = 0; i < count; i++) {
+        if (entries[i].order % 2 == 0 && wins[entries[i].order / 2]) {
+            getNode(pf, nodes[entries[i].order])->target = nodes[entries[i].order + 1];
+            revCounts[nodes[entries[i].order + 1]]++;
+        }
+    }
+
+    // tablice rev od razu dostają docelowy rozmiar.
+    for (uint32_t i = ROOT_NODE; i < pf->nodes.count; i++) {
+        if (revCounts[i] == 0)
+            continue;
+
+        PfNode *node = getNode(pf, i);
+
+        node->rev = resizeRevArray(NULL, revCounts[i]);
+
+        // problem z alokacją pamięci.
+        if (node->rev == NULL) {
+            free(revCounts);
+            return false;
+        }
+
+        node->rev->count = 0;
+        node->rev->capacity = revCounts[i];
+    }
+
+    free(revCounts);
+
+    for (size_t i = 0; i < count; i++) {
+        if (entries[i].order % 2 == 0 && wins[entries[i].order / 2]) {
+            RevArray *rev = getNode(pf, nodes[entries[i].order + 1])->rev;
+
+            rev->nums[rev->count++] = nodes[entries[i].order];
+        }
+    }
+
+    // najmniejsza głębokość węzła z tablicą rev w poddrzewie trafia do przodków.
+    for (uint32_t i = ROOT_NODE; i < pf->nodes.count; i++) {
+        if (!hasReverse(getNode(pf, i)))
+            continue;
 
-            if (temp->number != NULL)
-                free(temp->number);
-            
-            free((void*)temp);
+        uint32_t depth = getNode(pf, i)->depth;
+        uint32_t idx = i;
+
+        while (idx != NO_NODE && getNode(pf, idx)->minRevDepth > depth) {
+            getNode(pf, idx)->minRevDepth = depth;
+            idx = getNode(pf, idx)->parent;
         }
     }
+
+    return true;
+}
+
+
+struct PhoneForward * phfwdBuild(char const * const *num1, char const * const *num2, size_t n) {
+    if (num1 == NULL || num2 == NULL)
+        return NULL;
+
+    struct PhoneForward *pf = phfwdNew();
+    size_t count;
+    size_t maxLength;
+    BuildEntry *entries = sortEntries(num1, num2, n, &count, &maxLength);
+    bool *wins = calloc(n + 1, sizeof(bool));
+    uint32_t *nodes = malloc((2 * n + 1) * sizeof(uint32_t));
+    uint32_t *path = entries != NULL ? malloc((maxLength + 2) * sizeof(uint32_t)) : NULL;
+
+    bool ok = pf != NULL && entries != NULL && wins != NULL && nodes != NULL && path != NULL;
+
+    if (ok) {
+        markWinners(entries, count, wins);
+        ok = buildNodes(pf, entries, count, wins, path, nodes) && buildForwardings(pf, entries, count, wins, nodes);
+    }
+
+    free(entries);
+    free(wins);
+    free(nodes);
+    free(path);
+
+    // problem z alokacją pamięci.
+    if (!ok) {
+        phfwdDelete(pf);
+        return NULL;
+    }
+
+    return pf;
+}
+
+
+void phnumDelete(struct PhoneNumbers const *pnum) {
+    // cała struktura leży w jednym bloku pamięci.
+    if (pnum != NULL)
+        free((void*)pnum);
     else return;
 }
\ No newline at end of file
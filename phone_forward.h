@@ -11,41 +11,355 @@
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdlib.h>
+#include <pthread.h>
 
 #define DIGITS  12
 
+/// Liczba bitów indeksu elementu, wyznaczająca jego pozycję w blokach (slabach).
+#define SLAB_SHIFT  12
+/// Liczba elementów w pojedynczym bloku pamięci.
+#define SLAB_SIZE   (1u << SLAB_SHIFT)
+/// Indeks oznaczający brak węzła (lub brak tablicy synów).
+#define NO_NODE     0
+/// Indeks korzenia drzewa.
+#define ROOT_NODE   1
+/// Wartość kids[1] węzła, którego synowie leżą w tablicy NODE4 o indeksie kids[0].
+#define KIDS_NODE4  UINT32_MAX
+/// Wartość kids[1] węzła, którego synowie leżą w tablicy NODE12 o indeksie kids[0].
+#define KIDS_NODE12 (UINT32_MAX - 1)
+/// Najmniejszy indeks, którego pule nie przydzielają, by nie pomylić go ze znacznikami KIDS_NODE4 i KIDS_NODE12.
+#define POOL_LIMIT  KIDS_NODE12
+/// Liczba bajtów etykiety krawędzi przechowywanej w węźle.
+#define LABEL_BYTES 19
+/// Maksymalna liczba cyfr etykiety, każda cyfra zajmuje 4 bity.
+#define LABEL_MAX   (2 * LABEL_BYTES)
+/// Maksymalna liczba cyfr etykiety przechowywanej w węźle zamrożonej struktury.
+#define FROZEN_INLINE   8
+/// Liczba początkowych cyfr numeru, według których phfwdBuild porządkuje numery bez porównywania napisów.
+#define BUILD_KEY_DIGITS    16
 
+/// Wartość pola minRevDepth węzła, w którego poddrzewie nie ma przekierowań.
+#define NO_REVERSE  UINT32_MAX
+/// Liczba wpisów pamięci podręcznej wyników funkcji phfwdNonTrivialCount.
+#define COUNT_CACHE_SIZE  64
+/// Liczba wykładników w tablicy potęg używanej przy zliczaniu numerów.
+#define POWER_LIMIT 64
+/// Rodzaj zapamiętanego wyniku: wynik funkcji phfwdGet.
+#define RESULT_GET      0
+/// Rodzaj zapamiętanego wyniku: wynik funkcji phfwdReverse.
+#define RESULT_REVERSE  1
+/// Rozmiar przydzielonego z góry miejsca na wynik i numer zapytania jednego wpisu
+/// pamięci podręcznej wyników. Większe wyniki są alokowane osobno.
+#define RESULT_SLOT     128
+
+/// Liczba liczników czytelników, między które rozkładają się wątki.
+#define READER_SLOTS    64
+/// Rozmiar linii pamięci podręcznej procesora.
+#define CACHE_LINE      64
+
+/// Rodzaj węzła, którego synowie mieszczą się w samym węźle.
+#define NODE2       0
+/// Rodzaj węzła z tablicą co najwyżej czterech synów.
+#define NODE4       1
+/// Rodzaj węzła z pełną tablicą synów indeksowaną cyfrą.
+#define NODE12      2
+
+
+
+/**
+ * Wewnętrzna tablica węzłów przekierowanych na dany numer, używana
+ * w strukturze PhoneForward, posortowana leksykograficznie według ich numerów.
+ */
+struct revArray;
+
+typedef struct revArray RevArray;
+
+struct revArray {
+    uint32_t count; // liczba numerów w tablicy.
+    uint32_t capacity; // liczba miejsc w tablicy nums.
+    uint32_t nums[]; // indeksy węzłów przekierowanych na dany numer.
+};
+
+/**
+ * Wewnętrzna struktura puli elementów jednakowego rozmiaru.
+ * Elementy leżą w blokach po SLAB_SIZE sztuk i są adresowane 32-bitowymi
+ * indeksami, indeks NO_NODE jest zarezerwowany.
+ */
+struct pfPool;
+
+typedef struct pfPool PfPool;
+
+struct pfPool {
+    char **slabs; // tablica wskaźników na bloki elementów.
+    size_t slabCount; // liczba zaalokowanych bloków.
+    size_t slabCapacity; // rozmiar tablicy slabs.
+    size_t elSize; // rozmiar pojedynczego elementu.
+    uint32_t count; // liczba wykorzystanych indeksów.
+    uint32_t freeList; // lista zwolnionych elementów połączona przez ich pierwsze bajty.
+};
+
+/**
+ * Wewnętrzna struktura pojedynczego węzła drzewa przekierowań.
+ * Węzły nie są alokowane osobno, lecz przechowywane w puli struktury
+ * PhoneForward i adresowane 32-bitowymi indeksami.
+ * Drzewo jest skompresowane: łańcuchy węzłów o jednym synu są zwijane
+ * w etykietę krawędzi prowadzącej do węzła. Węzeł przechowuje ostatnie
+ * LABEL_MAX cyfr swojego numeru (wraz z ':' i ';') jako wartości 0-11,
+ * po dwie w bajcie; cyfra z pozycji p numeru leży na pozycji p % LABEL_MAX
+ * tablicy label. Etykieta to ostatnie labelLen z tych cyfr. Numer węzła się
+ * nie zmienia, więc tablica label nie zmienia się przy rozdzielaniu i scalaniu
+ * krawędzi, gdy zmienia się jedynie długość etykiety.
+ * Co najwyżej dwóch synów mieści się w samym węźle, większe tablice synów
+ * (NODE4, NODE12) są przechowywane w osobnych pulach.
+ * Węzeł nie przechowuje całego numeru: odtwarza się go, idąc po ojcach
+ * do korzenia. Przekierowania i tablice rev odwołują się do indeksów węzłów,
+ * które nie zmieniają się przy rozdzielaniu i scalaniu krawędzi.
+ */
+struct pfNode;
+
+typedef struct pfNode PfNode;
+
+struct pfNode {
+    union {
+        uint32_t kids[2]; // synowie węzła NODE2 lub indeks tablicy synów i znacznik KIDS_NODE4 albo KIDS_NODE12.
+        uint64_t kidsWord; // oba pola kids, udostępniane czytelnikom jednym zapisem.
+    };
+    uint32_t parent; // indeks ojca węzła, NO_NODE w korzeniu.
+    uint32_t target; // indeks węzła, na który węzeł jest przekierowany, NO_NODE gdy brak.
+    uint32_t depth; // długość numeru reprezentowanego przez węzeł.
+    uint32_t minRevDepth; // najmniejsza głębokość węzła z niepustą tablicą rev w poddrzewie lub NO_REVERSE.
+    uint8_t kind; // rodzaj węzła: NODE2, NODE4 lub NODE12.
+    uint8_t childCount; // liczba synów.
+    uint8_t keys[2]; // posortowane cyfry synów węzła NODE2.
+    uint8_t labelLen; // długość etykiety, 0 tylko w korzeniu.
+    uint8_t label[LABEL_BYTES]; // ostatnie cyfry numeru węzła, po dwie w bajcie.
+    RevArray *rev; // tablica numerów do funkcji reverse, NULL dopóki jest pusta.
+};
+
+/**
+ * Wewnętrzna struktura tablicy co najwyżej czterech synów.
+ * Syn zajmuje dowolne wolne miejsce, puste miejsca mają indeks NO_NODE,
+ * więc dodanie i usunięcie syna zmienia tylko jedno pole kids.
+ */
+struct pfNode4;
+
+typedef struct pfNode4 PfNode4;
+
+struct pfNode4 {
+    uint8_t keys[4]; // cyfry synów.
+    uint32_t kids[4]; // indeksy synów, NO_NODE na wolnych miejscach.
+};
+
+/**
+ * Wewnętrzna struktura pełnej tablicy synów.
+ */
+struct pfNode12;
+
+typedef struct pfNode12 PfNode12;
+
+struct pfNode12 {
+    uint32_t kids[DIGITS]; // indeksy synów według cyfry, NO_NODE gdy syna brak.
+};
+
+/**
+ * Wewnętrzna struktura liczników czytelników jednej grupy wątków.
+ * Każda grupa ma osobną linię pamięci podręcznej, by wątki czytające
+ * nie rywalizowały o ten sam licznik.
+ */
+struct readerSlot;
+
+typedef struct readerSlot ReaderSlot;
+
+struct readerSlot {
+    _Alignas(CACHE_LINE) size_t readers[2]; // liczba czytelników w każdej z dwóch epok (lub replik).
+};
+
+/**
+ * Wewnętrzna struktura odłączonej od drzewa pamięci, czekającej na zwolnienie:
+ * bloku zaalokowanego funkcją malloc albo elementu puli.
+ */
+struct retiredMemory;
+
+typedef struct retiredMemory RetiredMemory;
+
+struct retiredMemory {
+    void *ptr; // zwalniany blok pamięci, NULL dla elementu puli.
+    PfPool *pool; // pula zwalnianego elementu.
+    uint32_t idx; // indeks zwalnianego elementu.
+};
+
+/**
+ * Wewnętrzna struktura synchronizacji odczytów z modyfikacjami tej samej
+ * struktury PhoneForward. Modyfikujący udostępnia każdą zmianę czytelnikom
+ * jednym atomowym zapisem (syna, przekierowania lub tablicy rev), a czytelnik
+ * niczego nie blokuje i nie powtarza. Pamięć i indeksy elementów pul, które
+ * czytelnik mógł jeszcze odczytywać, są zwalniane dopiero, gdy opuszczą je
+ * wszyscy czytelnicy epoki, w której je odłączono.
+ */
+struct pfSync;
+
+typedef struct pfSync PfSync;
+
+struct pfSync {
+    size_t epoch; // bieżąca epoka odzyskiwania pamięci.
+    pthread_mutex_t writeLock; // blokada szeregująca modyfikacje.
+    RetiredMemory *limbo[2]; // pamięć odłączona w epokach o danej parzystości.
+    size_t limboCount[2]; // liczba wpisów w tablicach limbo.
+    size_t limboCapacity[2]; // rozmiary tablic limbo.
+    ReaderSlot slots[READER_SLOTS]; // liczniki czytelników.
+};
 
 /**
- * Wewnętrzna struktura listy, używana w strukturze PhoneForward.
+ * Wewnętrzna struktura wpisu pamięci podręcznej wyników phfwdNonTrivialCount.
+ * Wpis jest aktualny, gdy jego generacja jest równa generacji struktury.
  */
-struct list;
+struct countCacheEntry;
 
-typedef struct list List;
+typedef struct countCacheEntry CountCacheEntry;
 
-struct list {
-    char *revNum;
-    List *next;
-    List *prev;
+struct countCacheEntry {
+    uint64_t generation; // generacja struktury, dla której policzono wynik, 0 gdy wpis pusty.
+    size_t len; // długość numerów.
+    size_t result; // liczba nietrywialnych numerów.
+    uint16_t mask; // maska cyfr zestawu set.
+};
+
+/**
+ * Wewnętrzna struktura wpisu pamięci podręcznej wyników phfwdGet i phfwdReverse.
+ * Wpisy są adresowane indeksami od 1, indeks 0 oznacza brak wpisu.
+ * Wpis jest aktualny, gdy jego generacja jest równa generacji struktury.
+ */
+struct resultEntry;
+
+typedef struct resultEntry ResultEntry;
+
+struct resultEntry {
+    uint64_t generation; // generacja struktury, dla której zapamiętano wynik.
+    uint64_t hash; // skrót numeru zapytania i rodzaju wyniku.
+    struct PhoneNumbers *result; // zapamiętany wynik, za nim leży numer zapytania.
+    size_t resultSize; // rozmiar bloku wyniku, bez numeru zapytania.
+    bool inSlot; // czy wynik leży w przydzielonym z góry miejscu wpisu.
+    uint32_t chain; // następny wpis w tym samym kubełku.
+    uint32_t newer; // wpis użyty później, 0 dla ostatnio użytego.
+    uint32_t older; // wpis użyty wcześniej, 0 dla najdawniej użytego.
+    uint8_t kind; // rodzaj wyniku: RESULT_GET lub RESULT_REVERSE.
+};
+
+/**
+ * Wewnętrzna struktura pamięci podręcznej wyników phfwdGet i phfwdReverse.
+ * Wpisy leżą w tablicy haszującej z listami w kubełkach i na liście
+ * od ostatnio do najdawniej użytego. Gdy brakuje miejsca, zastępowany jest
+ * wpis najdawniej użyty. Modyfikacja struktury unieważnia wszystkie wpisy
+ * naraz, bo zmienia jej generację. Małe wyniki są zapamiętywane w miejscu
+ * przydzielonym wpisowi z góry, więc ich zapamiętanie nie alokuje pamięci.
+ */
+struct resultCache;
+
+typedef struct resultCache ResultCache;
+
+struct resultCache {
+    ResultEntry *entries; // wpisy, od indeksu 1.
+    char *slots; // miejsca po RESULT_SLOT bajtów na wyniki kolejnych wpisów.
+    uint32_t capacity; // największa liczba wpisów.
+    uint32_t count; // liczba zajętych wpisów.
+    uint32_t *buckets; // pierwsze wpisy kubełków, 0 gdy kubełek pusty.
+    uint64_t bucketMask; // liczba kubełków pomniejszona o 1, liczba kubełków jest potęgą dwójki.
+    uint32_t newest; // ostatnio użyty wpis.
+    uint32_t oldest; // najdawniej użyty wpis.
+    size_t hits; // liczba zapytań, na które odpowiedziano z pamięci podręcznej.
+    size_t misses; // liczba zapytań, których wynik trzeba było wyznaczyć.
+    size_t evictions; // liczba wpisów zastąpionych z braku miejsca.
+};
+
+/**
+ * Statystyki pamięci podręcznej wyników funkcji phfwdGet i phfwdReverse.
+ */
+struct PhfwdCacheStats {
+    size_t hits; // liczba zapytań, na które odpowiedziano z pamięci podręcznej.
+    size_t misses; // liczba zapytań, których wynik trzeba było wyznaczyć.
+    size_t evictions; // liczba wyników usuniętych, by zrobić miejsce na nowe.
+    size_t entries; // liczba zapamiętanych wyników, także nieaktualnych.
 };
 
 /**
  * Struktura przechowująca przekierowania numerów telefonów.
  */
 struct PhoneForward {
-    struct PhoneForward *digits[DIGITS];
-    char *number;
-    List *rev; // lista numerów do funkcji reverse z atrapą.
-    List *this; // wskażnik na miejsce danego przekierowania w liście reverse.
+    PfPool nodes; // pula węzłów drzewa.
+    PfPool blocks4; // pula tablic synów węzłów NODE4.
+    PfPool blocks12; // pula tablic synów węzłów NODE12.
+    uint32_t *pending; // węzły, które mogły przestać być potrzebne.
+    size_t pendingCount; // liczba węzłów w tablicy pending.
+    size_t pendingCapacity; // rozmiar tablicy pending.
+    uint64_t generation; // licznik modyfikacji, zwiększany przez phfwdAdd i phfwdRemove.
+    CountCacheEntry countCache[COUNT_CACHE_SIZE]; // wyniki phfwdNonTrivialCount.
+    unsigned countThreads; // liczba wątków używanych przez phfwdNonTrivialCount.
+    PfSync *sync; // synchronizacja współbieżnych odczytów, NULL gdy wyłączona.
+    ResultCache *results; // pamięć podręczna wyników phfwdGet i phfwdReverse, NULL gdy wyłączona.
+};
+
+/**
+ * Wewnętrzna struktura węzła zamrożonego drzewa przekierowań.
+ * Węzły leżą w jednej tablicy w kolejności przeszukiwania wszerz, więc
+ * synowie węzła zajmują kolejne pozycje, w porządku cyfr. Syn o danej cyfrze
+ * leży na pozycji firstChild powiększonej o liczbę mniejszych cyfr w childMask.
+ * Cyfry etykiety są zapisane po dwie w bajcie, krótkie etykiety w samym węźle.
+ */
+struct frozenNode;
+
+typedef struct frozenNode FrozenNode;
+
+struct frozenNode {
+    uint32_t firstChild; // indeks pierwszego syna.
+    uint32_t parent; // indeks ojca, NO_NODE w korzeniu.
+    uint32_t target; // indeks węzła, na który węzeł jest przekierowany, NO_NODE gdy brak.
+    uint32_t revStart; // pozycja tablicy rev węzła w tablicy revs, kończy się ona na revStart następnego węzła.
+    union {
+        uint32_t labelStart; // pozycja etykiety dłuższej niż FROZEN_INLINE w tablicy labels.
+        uint8_t label[FROZEN_INLINE / 2]; // etykieta nie dłuższa niż FROZEN_INLINE.
+    };
+    uint32_t depth; // długość numeru reprezentowanego przez węzeł.
+    uint32_t minRevDepth; // najmniejsza głębokość węzła z niepustą tablicą rev w poddrzewie lub NO_REVERSE.
+    uint16_t childMask; // bit i jest ustawiony, gdy węzeł ma syna o etykiecie zaczynającej się cyfrą i.
+    uint8_t labelLen; // długość etykiety, 0 tylko w korzeniu.
+    uint8_t unused; // wyrównanie do 32 bajtów.
+};
+
+/**
+ * Zamrożona, niemodyfikowalna postać struktury przekierowań.
+ * Wszystkie tablice leżą w jednym bloku pamięci i odwołują się do siebie
+ * indeksami, więc blok można zapisać do pliku i odwzorować z powrotem
+ * w pamięć pod dowolnym adresem. Strukturę mogą bez synchronizacji odczytywać
+ * równocześnie dowolne wątki.
+ */
+struct PhfwdFrozen {
+    FrozenNode const *nodes; // węzły od indeksu ROOT_NODE, za ostatnim leży strażnik z polem revStart.
+    uint32_t const *revs; // tablice rev kolejnych węzłów, zawierające indeksy węzłów.
+    uint8_t const *labels; // długie etykiety krawędzi, po dwie cyfry w bajcie.
+    uint32_t nodeCount; // liczba elementów tablicy nodes wraz z NO_NODE i strażnikiem.
+    uint32_t revCount; // liczba elementów tablicy revs.
+    size_t labelBytes; // liczba bajtów tablicy labels.
+    void *block; // blok pamięci zawierający tablice, NULL gdy odwzorowano je z pliku.
+    void *mapping; // odwzorowany fragment pliku zawierający tablice, NULL gdy brak.
+    size_t mappingSize; // rozmiar odwzorowanego fragmentu.
 };
 
+/** @brief Udostępnia numer licznika czytelników bieżącego wątku.
+ * Przy pierwszym wywołaniu w danym wątku przydziela mu kolejny licznik.
+ * @return Numer licznika, mniejszy niż READER_SLOTS.
+ */
+unsigned threadReaderSlot(void);
+
 /**
  * Struktura przechowująca ciąg numerów telefonów.
+ * Cała struktura zajmuje jeden blok pamięci: za tablicą przesunięć
+ * leżą kolejne napisy numerów zakończone znakiem '\0'.
  */
 struct PhoneNumbers {
-    char *number;
-    struct PhoneNumbers *next;
+    size_t count; // liczba numerów w ciągu.
+    size_t offsets[]; // przesunięcia kolejnych numerów względem początku obszaru napisów.
 };
 
 /** @brief Tworzy nową strukturę.
@@ -55,6 +369,73 @@ struct PhoneNumbers {
  */
 struct PhoneForward * phfwdNew(void);
 
+/** @brief Tworzy kopię struktury.
+ * Kopia zawiera te same przekierowania co struktura @p pf i jest od niej
+ * niezależna. Kopiowane są całe bloki węzłów, więc czas działania jest
+ * liniowy względem rozmiaru struktury. Kopia nie ma pamięci podręcznej wyników.
+ * @param[in] pf – wskaźnik na kopiowaną strukturę.
+ * @return Wskaźnik na kopię lub NULL, gdy @p pf ma wartość NULL lub nie udało
+ *         się alokować pamięci.
+ */
+struct PhoneForward * phfwdClone(struct PhoneForward const *pf);
+
+/** @brief Tworzy strukturę z wielu przekierowań naraz.
+ * Wynik działa tak samo jak struktura, do której kolejno dodano funkcją
+ * @ref phfwdAdd przekierowania z @p num1[i] na @p num2[i]: pary, których
+ * phfwdAdd by nie dodała, są pomijane, a z par o tym samym numerze @p num1[i]
+ * liczy się ostatnia. Przekierowania nie muszą być uporządkowane. Funkcja
+ * porządkuje numery i buduje drzewo oraz tablice rev w jednym przebiegu,
+ * bez wyszukiwania numerów od korzenia.
+ * @param[in] num1 – tablica wskaźników na napisy reprezentujące prefiksy
+ *                   numerów przekierowywanych;
+ * @param[in] num2 – tablica wskaźników na napisy reprezentujące prefiksy
+ *                   numerów, na które są wykonywane przekierowania;
+ * @param[in] n    – liczba przekierowań.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy któraś z tablic
+ *         ma wartość NULL lub nie udało się alokować pamięci.
+ */
+struct PhoneForward * phfwdBuild(char const * const *num1, char const * const *num2, size_t n);
+
+/** @brief Włącza współbieżne odczyty struktury.
+ * Po włączeniu funkcje @ref phfwdGet, @ref phfwdGetInto i @ref phfwdReverse
+ * mogą być wywoływane z wielu wątków równocześnie z funkcjami @ref phfwdAdd
+ * i @ref phfwdRemove, które modyfikują strukturę w miejscu.
+ * Odczyty nie zakładają blokad i nigdy nie czekają na modyfikacje ani ich
+ * nie powtarzają. Każde przekierowanie jest dodawane i usuwane atomowo,
+ * ale odczyt równoczesny z funkcją @ref phfwdRemove może zobaczyć tylko część
+ * usuwanych przez nią przekierowań. Pozostałe funkcje nadal wymagają
+ * wyłącznego dostępu do struktury.
+ * Funkcję należy wywołać, zanim strukturę zaczną odczytywać inne wątki.
+ * @param[in,out] pf – wskaźnik na strukturę przechowującą przekierowania numerów.
+ * @return Wartość @p true, jeśli współbieżne odczyty są włączone.
+ *         Wartość @p false, jeśli @p pf ma wartość NULL lub nie udało się
+ *         alokować pamięci.
+ */
+bool phfwdEnableConcurrentReads(struct PhoneForward *pf);
+
+/** @brief Włącza pamięć podręczną wyników zapytań.
+ * Funkcje @ref phfwdGet, @ref phfwdGetInto i @ref phfwdReverse zapamiętują
+ * wyniki dla co najwyżej @p capacity ostatnio używanych numerów i odpowiadają
+ * z pamięci podręcznej na powtórzone zapytania. Każde wywołanie @ref phfwdAdd
+ * lub @ref phfwdRemove unieważnia zapamiętane wyniki. Przy włączonych
+ * współbieżnych odczytach pamięć podręczna nie jest używana.
+ * Ponowne wywołanie zastępuje pamięć podręczną pustą, a wartość 0 ją wyłącza.
+ * @param[in,out] pf – wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] capacity – największa liczba zapamiętanych wyników.
+ * @return Wartość @p true, jeśli się udało.
+ *         Wartość @p false, jeśli @p pf ma wartość NULL, @p capacity jest
+ *         zbyt duże lub nie udało się alokować pamięci.
+ */
+bool phfwdEnableResultCache(struct PhoneForward *pf, size_t capacity);
+
+/** @brief Udostępnia statystyki pamięci podręcznej wyników zapytań.
+ * @param[in] pf – wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[out] stats – wskaźnik na strukturę, do której zostaną zapisane statystyki.
+ * @return Wartość @p true, jeśli pamięć podręczna jest włączona.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool phfwdResultCacheStats(struct PhoneForward const *pf, struct PhfwdCacheStats *stats);
+
 /** @brief Usuwa strukturę.
  * Usuwa strukturę wskazywaną przez @p pf. Nic nie robi, jeśli wskaźnik ten ma
  * wartość NULL.
@@ -102,6 +483,50 @@ void phfwdRemove(struct PhoneForward *pf, char const *num);
  */
 struct PhoneNumbers const * phfwdGet(struct PhoneForward *pf, char const *num);
 
+/** @brief Wyznacza przekierowanie numeru do bufora użytkownika.
+ * Działa jak funkcja @ref phfwdGet, ale nie alokuje pamięci: wynikowy numer
+ * jest zapisywany w buforze @p buf, jeśli zmieści się w nim razem z kończącym
+ * go znakiem '\0'. W przeciwnym przypadku zawartość bufora jest nieokreślona.
+ * Jeśli podany napis nie reprezentuje numeru, wynikiem jest pusty napis.
+ * @param[in] pf     – wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] num    – wskaźnik na napis reprezentujący numer;
+ * @param[out] buf   – wskaźnik na bufor na wynikowy numer;
+ * @param[in] buflen – rozmiar bufora w bajtach.
+ * @return Długość wynikowego numeru bez znaku '\0'. Wartość niemniejsza niż
+ *         @p buflen oznacza, że wynik nie zmieścił się w buforze.
+ */
+size_t phfwdGetInto(struct PhoneForward *pf, char const *num, char *buf, size_t buflen);
+
+/** @brief Wyznacza przekierowania wielu numerów.
+ * Działa jak wywołanie funkcji @ref phfwdGet dla kolejnych numerów, ale
+ * prowadzi kilkanaście wyszukiwań naprzemiennie, tak by oczekiwanie na pamięć
+ * jednego z nich nakładało się na pozostałe. Każdy wynik musi być zwolniony
+ * za pomocą funkcji @ref phnumDelete.
+ * @param[in] pf    – wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] nums  – tablica wskaźników na napisy reprezentujące numery;
+ * @param[in] n     – liczba numerów;
+ * @param[out] out  – tablica na @p n wyników, w kolejności numerów.
+ * @return Wartość @p true, jeśli wyznaczono wszystkie wyniki.
+ *         Wartość @p false, jeśli któryś z wyników wynosi NULL (jak dla funkcji
+ *         @ref phfwdGet).
+ */
+bool phfwdGetBatch(struct PhoneForward *pf, char const * const *nums, size_t n, struct PhoneNumbers const **out);
+
+/** @brief Wyznacza przekierowania wielu numerów jednym przejściem drzewa.
+ * Działa jak wywołanie funkcji @ref phfwdGet dla kolejnych numerów, ale
+ * przetwarza numery w porządku leksykograficznym (sortując je, jeśli nie są
+ * uporządkowane), dzięki czemu sąsiednie zapytania współdzielą ścieżkę
+ * w drzewie i najdłuższe znalezione na niej przekierowanie. Każdy wynik musi
+ * być zwolniony za pomocą funkcji @ref phnumDelete.
+ * @param[in] pf    – wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] nums  – tablica wskaźników na napisy reprezentujące numery;
+ * @param[in] n     – liczba numerów;
+ * @param[out] out  – tablica na @p n wyników, w kolejności numerów w @p nums.
+ * @return Wartość @p true, jeśli wyznaczono wszystkie wyniki.
+ *         Wartość @p false, jeśli któryś z wyników wynosi NULL.
+ */
+bool phfwdGetSorted(struct PhoneForward *pf, char const * const *nums, size_t n, struct PhoneNumbers const **out);
+
 /** @brief Wyznacza przekierowania na dany numer.
  * Wyznacza wszystkie przekierowania na podany numer. Wynikowy ciąg zawiera też
  * dany numer. Wynikowe numery są posortowane leksykograficznie i nie mogą się
@@ -115,6 +540,20 @@ struct PhoneNumbers const * phfwdGet(struct PhoneForward *pf, char const *num);
  */
 struct PhoneNumbers const * phfwdReverse(struct PhoneForward *pf, char const *num);
 
+/** @brief Wyznacza przekierowania na wiele numerów jednym przejściem drzewa.
+ * Działa jak wywołanie funkcji @ref phfwdReverse dla kolejnych numerów, ale
+ * przetwarza numery w porządku leksykograficznym (sortując je, jeśli nie są
+ * uporządkowane), dzięki czemu sąsiednie zapytania współdzielą ścieżkę
+ * w drzewie. Każdy wynik musi być zwolniony za pomocą funkcji @ref phnumDelete.
+ * @param[in] pf    – wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] nums  – tablica wskaźników na napisy reprezentujące numery;
+ * @param[in] n     – liczba numerów;
+ * @param[out] out  – tablica na @p n wyników, w kolejności numerów w @p nums.
+ * @return Wartość @p true, jeśli wyznaczono wszystkie wyniki.
+ *         Wartość @p false, jeśli któryś z wyników wynosi NULL.
+ */
+bool phfwdReverseSorted(struct PhoneForward *pf, char const * const *nums, size_t n, struct PhoneNumbers const **out);
+
 /** @brief Usuwa strukturę.
  * Usuwa strukturę wskazywaną przez @p pnum. Nic nie robi, jeśli wskaźnik ten ma
  * wartość NULL.
@@ -122,6 +561,13 @@ struct PhoneNumbers const * phfwdReverse(struct PhoneForward *pf, char const *nu
  */
 void phnumDelete(struct PhoneNumbers const *pnum);
 
+/** @brief Podaje liczbę numerów.
+ * @param[in] pnum – wskaźnik na strukturę przechowującą ciąg napisów.
+ * @return Liczbę numerów w ciągu. Wartość 0, jeśli wskaźnik @p pnum ma wartość
+ *         NULL.
+ */
+size_t phnumCount(struct PhoneNumbers const *pnum);
+
 /** @brief Udostępnia numer.
  * Udostępnia wskaźnik na napis reprezentujący numer. Napisy są indeksowane
  * kolejno od zera.
@@ -142,4 +588,76 @@ char const * phnumGet(struct PhoneNumbers const *pnum, size_t idx);
  */
 size_t phfwdNonTrivialCount(struct PhoneForward *pf, char const *set, size_t len);
 
+/** @brief Oblicza liczbę nietrywialnych numerów bez pamięci podręcznej wyników.
+ * Działa jak funkcja @ref phfwdNonTrivialCount, ale nie odczytuje ani nie
+ * zapisuje zapamiętanych wyników, więc nie modyfikuje struktury i może być
+ * wywoływana równocześnie z innymi odczytami tej samej struktury.
+ * @param[in] pf  – wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] set – wskaźnik na napis set;
+ * @param[in] len – długość numerów.
+ * @return Liczbę nietrywialnych numerów.
+ */
+size_t phfwdNonTrivialCountUncached(struct PhoneForward *pf, char const *set, size_t len);
+
+/** @brief Ustawia liczbę wątków zliczających nietrywialne numery.
+ * Przy więcej niż jednym wątku funkcja phfwdNonTrivialCount dzieli duże drzewa
+ * na poddrzewa, które wątki pobierają kolejno, aż wszystkie zostaną policzone.
+ * Wartość 0 jest traktowana jak 1. Nic nie robi, jeśli wskaźnik @p pf ma wartość NULL.
+ * @param[in,out] pf    – wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] threads   – liczba wątków, łącznie z wątkiem wywołującym.
+ */
+void phfwdSetCountThreads(struct PhoneForward *pf, unsigned threads);
+
+/** @brief Tworzy zamrożoną postać struktury przekierowań.
+ * Zamrożona struktura zawiera te same przekierowania co @p pf, zajmuje
+ * mniej pamięci i szybciej odpowiada na zapytania, ale nie można jej
+ * modyfikować. Struktura @p pf pozostaje niezmieniona.
+ * @param[in] pf – wskaźnik na strukturę przechowującą przekierowania numerów.
+ * @return Wskaźnik na zamrożoną strukturę lub NULL, gdy @p pf ma wartość NULL
+ *         lub nie udało się alokować pamięci.
+ */
+struct PhfwdFrozen * phfwdFreeze(struct PhoneForward const *pf);
+
+/** @brief Tworzy modyfikowalną strukturę przekierowań z zamrożonej.
+ * @param[in] frozen – wskaźnik na zamrożoną strukturę.
+ * @return Wskaźnik na strukturę zawierającą te same przekierowania co
+ *         @p frozen lub NULL, gdy @p frozen ma wartość NULL lub nie udało
+ *         się alokować pamięci.
+ */
+struct PhoneForward * phfwdThaw(struct PhfwdFrozen const *frozen);
+
+/** @brief Usuwa zamrożoną strukturę.
+ * Zwalnia jej pamięć lub usuwa odwzorowanie pliku, z którego ją otwarto.
+ * Nic nie robi, jeśli wskaźnik @p frozen ma wartość NULL.
+ * @param[in] frozen – wskaźnik na usuwaną strukturę.
+ */
+void phfwdFrozenDelete(struct PhfwdFrozen *frozen);
+
+/** @brief Wyznacza przekierowanie numeru w zamrożonej strukturze.
+ * Działa jak funkcja @ref phfwdGet.
+ * @param[in] frozen – wskaźnik na zamrożoną strukturę;
+ * @param[in] num    – wskaźnik na napis reprezentujący numer.
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci.
+ */
+struct PhoneNumbers const * phfwdFrozenGet(struct PhfwdFrozen const *frozen, char const *num);
+
+/** @brief Wyznacza przekierowania na dany numer w zamrożonej strukturze.
+ * Działa jak funkcja @ref phfwdReverse.
+ * @param[in] frozen – wskaźnik na zamrożoną strukturę;
+ * @param[in] num    – wskaźnik na napis reprezentujący numer.
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci.
+ */
+struct PhoneNumbers const * phfwdFrozenReverse(struct PhfwdFrozen const *frozen, char const *num);
+
+/** @brief Oblicza liczbę nietrywialnych numerów w zamrożonej strukturze.
+ * Działa jak funkcja @ref phfwdNonTrivialCount.
+ * @param[in] frozen – wskaźnik na zamrożoną strukturę;
+ * @param[in] set    – wskaźnik na napis set;
+ * @param[in] len    – długość numerów.
+ * @return Liczbę nietrywialnych numerów.
+ */
+size_t phfwdFrozenNonTrivialCount(struct PhfwdFrozen const *frozen, char const *set, size_t len);
+
 #endif /* __PHONE_FORWARD_H__ */
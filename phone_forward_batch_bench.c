@@ -0,0 +1,106 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include "phone_forward.h"
+#include "phone_forward_testing.h"
+
+/// Największa długość numerów.
+#define NUM_LEN 16
+/// Liczba numerów przekazywanych naraz do phfwdGetBatch.
+#define CHUNK   4096
+
+/** @brief Sumuje pierwszy znak i długość wyniku, żeby porównać obie metody.
+ * @param[in] pnum – wynik zapytania.
+ * @return Sumę pierwszego znaku i długości numeru.
+ */
+static size_t digest(struct PhoneNumbers const *pnum) {
+    char const *num = phnumGet(pnum, 0);
+
+    assert(num != NULL);
+
+    return (size_t) num[0] + strlen(num);
+}
+
+/** @brief Porównuje phfwdGetBatch z pętlą wywołań phfwdGet.
+ * Zapytania dotyczą losowych numerów w drzewie znacznie większym niż
+ * pamięć podręczna procesora.
+ * Argumenty: liczba przekierowań i liczba zapytań.
+ * @return Zero.
+ */
+int main(int argc, char **argv) {
+    size_t forwards = argc > 1 ? (size_t) atol(argv[1]) : 4000000;
+    size_t queries = argc > 2 ? (size_t) atol(argv[2]) : 2000000;
+    unsigned long long seed = TEST_SEED;
+    char num1[NUM_LEN + 1], num2[NUM_LEN + 1];
+    bool result;
+
+    struct PhoneForward *pf = phfwdNew();
+    char *numbers = malloc(queries * (NUM_LEN + 1));
+    char const **nums = malloc(queries * sizeof(char const *));
+    struct PhoneNumbers const **out = malloc(CHUNK * sizeof(struct PhoneNumbers const *));
+
+    assert(pf != NULL && numbers != NULL && nums != NULL && out != NULL);
+
+    // 11-cyfrowe prefiksy dają drzewo z kilkoma węzłami na przekierowanie.
+    for (size_t i = 0; i < forwards; i++) {
+        testRandomNumber(&seed, num1, 11, 11, 10);
+        testRandomNumber(&seed, num2, 1, 6, 10);
+        result = phfwdAdd(pf, num1, num2);
+        assert(result);
+    }
+
+    for (size_t i = 0; i < queries; i++) {
+        nums[i] = numbers + i * (NUM_LEN + 1);
+        testRandomNumber(&seed, numbers + i * (NUM_LEN + 1), 13, 13, 10);
+    }
+
+    struct rusage usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+    printf("%zu forwards, %zu queries, peak memory %ld MiB\n", forwards, queries, usage.ru_maxrss / 1024);
+
+    size_t loopDigest = 0, batchDigest = 0;
+    double start = testNow();
+
+    for (size_t i = 0; i < queries; i++) {
+        struct PhoneNumbers const *pnum = phfwdGet(pf, nums[i]);
+
+        loopDigest += digest(pnum);
+        phnumDelete(pnum);
+    }
+
+    double loopTime = testNow() - start;
+
+    start = testNow();
+
+    for (size_t i = 0; i < queries; i += CHUNK) {
+        size_t n = queries - i < CHUNK ? queries - i : CHUNK;
+
+        result = phfwdGetBatch(pf, nums + i, n, out);
+        assert(result);
+
+        for (size_t j = 0; j < n; j++) {
+            batchDigest += digest(out[j]);
+            phnumDelete(out[j]);
+        }
+    }
+
+    double batchTime = testNow() - start;
+
+    assert(loopDigest == batchDigest);
+    printf("phfwdGet loop: %.0f ms (%.0f ns/query)\n", loopTime, loopTime * 1e6 / (double) queries);
+    printf("phfwdGetBatch: %.0f ms (%.0f ns/query), speedup %.2fx\n", batchTime,
+           batchTime * 1e6 / (double) queries, loopTime / batchTime);
+
+    phfwdDelete(pf);
+    free(out);
+    free(nums);
+    free(numbers);
+    (void) result;
+
+    return 0;
+}
@@ -0,0 +1,161 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "phone_forward.h"
+#include "phone_forward_testing.h"
+
+/// Liczba losowych przekierowań.
+#define FORWARDS 20000
+/// Liczba losowych zapytań jednego porównania.
+#define QUERIES  4000
+/// Największa długość numerów.
+#define MAX_LEN  12
+
+static unsigned long long seed = TEST_SEED; ///< stan generatora liczb pseudolosowych.
+static char numbers1[FORWARDS][MAX_LEN + 1]; ///< numery przekierowywane.
+static char numbers2[FORWARDS][MAX_LEN + 1]; ///< numery docelowe.
+static char const *nums1[FORWARDS]; ///< wskaźniki na numery przekierowywane.
+static char const *nums2[FORWARDS]; ///< wskaźniki na numery docelowe.
+
+/** @brief Losuje napis, który zwykle jest numerem.
+ * Co setny napis zawiera niepoprawny znak, żeby budowanie musiało go pominąć.
+ * @param[out] num  – bufor na co najmniej MAX_LEN + 1 znaków;
+ * @param[in] alpha – liczba używanych cyfr.
+ */
+static void randomEntry(char *num, size_t alpha) {
+    testRandomNumber(&seed, num, 1, MAX_LEN, alpha);
+
+    if (testRandom(&seed) % 100 == 0)
+        num[testRandom(&seed) % strlen(num)] = "a#*"[testRandom(&seed) % 3];
+}
+
+/** @brief Porównuje zbudowaną strukturę z utworzoną przez phfwdAdd na losowych zapytaniach.
+ * @param[in] pf    – wskaźnik na strukturę utworzoną przez phfwdAdd;
+ * @param[in] built – wskaźnik na strukturę zbudowaną przez phfwdBuild;
+ * @param[in] alpha – liczba używanych cyfr.
+ */
+static void compareBuilt(struct PhoneForward *pf, struct PhoneForward *built, size_t alpha) {
+    char num[MAX_LEN + 1];
+
+    for (size_t i = 0; i < QUERIES; i++) {
+        randomEntry(num, alpha);
+        testAssertSame(phfwdGet(pf, num), phfwdGet(built, num));
+        testAssertSame(phfwdReverse(pf, num), phfwdReverse(built, num));
+    }
+
+    for (size_t len = 0; len <= 12; len += 3)
+        assert(phfwdNonTrivialCount(built, TEST_DIGITS, len) == phfwdNonTrivialCount(pf, TEST_DIGITS, len));
+}
+
+/** @brief Buduje strukturę z par numerów i porównuje ją z dodawaniem ich po kolei.
+ * @param[in] num1  – tablica numerów przekierowywanych;
+ * @param[in] num2  – tablica numerów docelowych;
+ * @param[in] n     – liczba par;
+ * @param[in] alpha – liczba cyfr używanych w zapytaniach.
+ */
+static void checkPairs(char const * const *num1, char const * const *num2, size_t n, size_t alpha) {
+    struct PhoneForward *pf = phfwdNew();
+    struct PhoneForward *built = phfwdBuild(num1, num2, n);
+
+    assert(pf != NULL && built != NULL);
+
+    for (size_t i = 0; i < n; i++)
+        phfwdAdd(pf, num1[i], num2[i]);
+
+    compareBuilt(pf, built, alpha);
+    phfwdDelete(built);
+    phfwdDelete(pf);
+}
+
+/** @brief Porównuje phfwdBuild z dodawaniem przekierowań przez phfwdAdd.
+ * @return Zero.
+ */
+int main() {
+    char num1[MAX_LEN + 1], num2[MAX_LEN + 1];
+    struct PhoneForward *pf, *built;
+    struct PhoneNumbers const *pnum;
+    bool result, expected;
+
+    // Brak tablic.
+    built = phfwdBuild(NULL, nums2, 0);
+    assert(built == NULL);
+    built = phfwdBuild(nums1, NULL, 0);
+    assert(built == NULL);
+
+    // Pusta baza.
+    built = phfwdBuild(nums1, nums2, 0);
+    assert(built != NULL);
+    pnum = phfwdGet(built, "123");
+    assert(phnumCount(pnum) == 1 && strcmp(phnumGet(pnum, 0), "123") == 0);
+    phnumDelete(pnum);
+    assert(phfwdNonTrivialCount(built, "0123456789", 5) == 0);
+    phfwdDelete(built);
+
+    // Pary pomijane przez phfwdAdd, powtórzone i nadpisywane przekierowania.
+    char const *first[] = {"123", "123", "12a", "5", "", "77", "123", "1234", "5", "9"};
+    char const *second[] = {"9", "8", "1", "5", "1", "", "7", "9", "6", "b"};
+
+    built = phfwdBuild(first, second, 10);
+    assert(built != NULL);
+
+    // ostatnie przekierowanie z 123 wygrywa.
+    pnum = phfwdGet(built, "1239");
+    assert(strcmp(phnumGet(pnum, 0), "79") == 0);
+    phnumDelete(pnum);
+
+    pnum = phfwdReverse(built, "9");
+    assert(phnumCount(pnum) == 2);
+    assert(strcmp(phnumGet(pnum, 0), "1234") == 0 && strcmp(phnumGet(pnum, 1), "9") == 0);
+    phnumDelete(pnum);
+
+    pnum = phfwdGet(built, "55");
+    assert(strcmp(phnumGet(pnum, 0), "65") == 0);
+    phnumDelete(pnum);
+
+    phfwdDelete(built);
+    checkPairs(first, second, 10, 10);
+
+    // Pełny alfabet daje szerokie drzewo, dwie cyfry - głębokie i dużo
+    // powtórzonych numerów.
+    for (size_t alpha = 12; alpha >= 2; alpha /= 2) {
+        for (size_t i = 0; i < FORWARDS; i++) {
+            randomEntry(numbers1[i], alpha);
+            randomEntry(numbers2[i], alpha);
+            nums1[i] = numbers1[i];
+            nums2[i] = numbers2[i];
+        }
+
+        checkPairs(nums1, nums2, FORWARDS, alpha);
+
+        // Zbudowaną strukturę można dalej zmieniać.
+        pf = phfwdNew();
+        built = phfwdBuild(nums1, nums2, FORWARDS);
+        assert(pf != NULL && built != NULL);
+
+        for (size_t i = 0; i < FORWARDS; i++)
+            phfwdAdd(pf, nums1[i], nums2[i]);
+
+        for (size_t i = 0; i < FORWARDS / 10; i++) {
+            randomEntry(num1, alpha);
+            randomEntry(num2, alpha);
+            expected = phfwdAdd(pf, num1, num2);
+            result = phfwdAdd(built, num1, num2);
+            assert(result == expected);
+
+            if (i % 5 == 0) {
+                randomEntry(num1, alpha);
+                phfwdRemove(pf, num1);
+                phfwdRemove(built, num1);
+            }
+        }
+
+        compareBuilt(pf, built, alpha);
+        phfwdDelete(built);
+        phfwdDelete(pf);
+    }
+
+    (void) result;
+    (void) expected;
+
+    return 0;
+}
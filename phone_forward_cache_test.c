@@ -0,0 +1,201 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "phone_forward.h"
+#include "phone_forward_testing.h"
+
+/// Liczba losowych przekierowań.
+#define FORWARDS 5000
+/// Liczba numerów, o które pytają zapytania.
+#define POOL     200
+/// Liczba zapytań jednego sprawdzenia.
+#define STEPS    20000
+/// Największa długość numerów.
+#define MAX_LEN  12
+
+static unsigned long long seed = TEST_SEED; ///< stan generatora liczb pseudolosowych.
+
+/** @brief Porównuje wyniki wszystkich zapytań o numer w obu strukturach.
+ * @param[in] pf     – wskaźnik na strukturę bez pamięci podręcznej;
+ * @param[in] cached – wskaźnik na strukturę z pamięcią podręczną;
+ * @param[in] num    – wskaźnik na napis reprezentujący numer.
+ */
+static void compareQuery(struct PhoneForward *pf, struct PhoneForward *cached, char const *num) {
+    char expected[2 * MAX_LEN + 1], buf[2 * MAX_LEN + 1];
+
+    testAssertSame(phfwdGet(pf, num), phfwdGet(cached, num));
+    testAssertSame(phfwdReverse(pf, num), phfwdReverse(cached, num));
+
+    size_t len = phfwdGetInto(pf, num, expected, sizeof(expected));
+    size_t result = phfwdGetInto(cached, num, buf, sizeof(buf));
+
+    assert(result == len && (len >= sizeof(buf) || strcmp(buf, expected) == 0));
+
+    // za mały bufor nie może zostać zapamiętany jako wynik.
+    result = phfwdGetInto(cached, num, buf, 1);
+    assert(result == len);
+    result = phfwdGetInto(cached, num, buf, sizeof(buf));
+    assert(result == len && (len >= sizeof(buf) || strcmp(buf, expected) == 0));
+    (void) result;
+    (void) len;
+}
+
+/** @brief Zadaje zapytania z puli numerów, przeplatając je zmianami przekierowań.
+ * Zmiany dotyczą numerów z puli, więc muszą unieważniać zapamiętane wyniki.
+ * @param[in] capacity – pojemność pamięci podręcznej;
+ * @param[in] alpha    – liczba używanych cyfr.
+ */
+static void checkCache(size_t capacity, size_t alpha) {
+    static char pool[POOL][MAX_LEN + 1];
+    char num1[MAX_LEN + 1], num2[MAX_LEN + 1];
+    struct PhoneForward *pf = phfwdNew();
+    struct PhoneForward *cached = phfwdNew();
+    struct PhfwdCacheStats stats;
+    bool result;
+
+    assert(pf != NULL && cached != NULL);
+    result = phfwdEnableResultCache(cached, capacity);
+    assert(result);
+
+    for (size_t i = 0; i < FORWARDS; i++) {
+        testRandomNumber(&seed, num1, 1, MAX_LEN, alpha);
+        testRandomNumber(&seed, num2, 1, MAX_LEN, alpha);
+        phfwdAdd(pf, num1, num2);
+        phfwdAdd(cached, num1, num2);
+    }
+
+    for (size_t i = 0; i < POOL; i++)
+        testRandomNumber(&seed, pool[i], 1, MAX_LEN, alpha);
+
+    for (size_t i = 0; i < STEPS; i++) {
+        char const *num = pool[testRandom(&seed) % POOL];
+
+        compareQuery(pf, cached, num);
+
+        if (i % 50 == 0) {
+            strcpy(num1, pool[testRandom(&seed) % POOL]);
+            num1[1 + testRandom(&seed) % strlen(num1)] = '\0';
+            testRandomNumber(&seed, num2, 1, MAX_LEN, alpha);
+            phfwdAdd(pf, num1, num2);
+            phfwdAdd(cached, num1, num2);
+            compareQuery(pf, cached, num);
+        }
+        else if (i % 50 == 25) {
+            strcpy(num1, pool[testRandom(&seed) % POOL]);
+            num1[testRandom(&seed) % strlen(num1)] = '\0';
+            phfwdRemove(pf, num1);
+            phfwdRemove(cached, num1);
+            compareQuery(pf, cached, num);
+        }
+    }
+
+    result = phfwdResultCacheStats(cached, &stats);
+    assert(result);
+    assert(stats.hits > 0 && stats.misses > 0);
+    assert(stats.entries <= capacity);
+    assert(capacity >= 2 * POOL || stats.evictions > 0);
+
+    // Ponowne włączenie zaczyna od pustej pamięci podręcznej.
+    result = phfwdEnableResultCache(cached, capacity);
+    assert(result);
+    result = phfwdResultCacheStats(cached, &stats);
+    assert(result && stats.hits == 0 && stats.entries == 0);
+
+    // Wartość 0 wyłącza pamięć podręczną.
+    result = phfwdEnableResultCache(cached, 0);
+    assert(result);
+    result = phfwdResultCacheStats(cached, &stats);
+    assert(!result);
+    compareQuery(pf, cached, pool[0]);
+
+    phfwdDelete(cached);
+    phfwdDelete(pf);
+    (void) result;
+}
+
+/** @brief Porównuje strukturę z pamięcią podręczną wyników ze strukturą bez niej.
+ * @return Zero.
+ */
+int main() {
+    struct PhoneForward *pf = phfwdNew();
+    struct PhoneNumbers const *pnum;
+    struct PhfwdCacheStats stats;
+    bool result;
+
+    // Bez włączenia nie ma statystyk.
+    result = phfwdResultCacheStats(pf, &stats);
+    assert(!result);
+
+    // Pusta baza i unieważnienie po dodaniu oraz usunięciu przekierowania.
+    result = phfwdEnableResultCache(pf, 16);
+    assert(result);
+
+    pnum = phfwdGet(pf, "1234");
+    assert(strcmp(phnumGet(pnum, 0), "1234") == 0);
+    phnumDelete(pnum);
+
+    result = phfwdAdd(pf, "12", "9");
+    assert(result);
+
+    pnum = phfwdGet(pf, "1234");
+    assert(strcmp(phnumGet(pnum, 0), "934") == 0);
+    phnumDelete(pnum);
+
+    pnum = phfwdReverse(pf, "934");
+    assert(phnumCount(pnum) == 2);
+    phnumDelete(pnum);
+
+    phfwdRemove(pf, "1");
+
+    pnum = phfwdGet(pf, "1234");
+    assert(strcmp(phnumGet(pnum, 0), "1234") == 0);
+    phnumDelete(pnum);
+
+    pnum = phfwdReverse(pf, "934");
+    assert(phnumCount(pnum) == 1);
+    phnumDelete(pnum);
+
+    // Niepoprawne numery.
+    pnum = phfwdGet(pf, "12a");
+    assert(pnum != NULL && phnumGet(pnum, 0) == NULL);
+    phnumDelete(pnum);
+
+    result = phfwdResultCacheStats(pf, &stats);
+    assert(result && stats.misses >= 4);
+
+    // Wynik niemieszczący się w miejscu wpisu phfwdGetInto pomija, bo wymagałby alokacji.
+    char longNum[RESULT_SLOT + 1], buf[RESULT_SLOT + 1];
+    size_t entries = stats.entries;
+
+    memset(longNum, '5', RESULT_SLOT);
+    longNum[RESULT_SLOT] = '\0';
+
+    size_t len = phfwdGetInto(pf, longNum, buf, sizeof(buf));
+
+    assert(len == RESULT_SLOT && strcmp(buf, longNum) == 0);
+    result = phfwdResultCacheStats(pf, &stats);
+    assert(result && stats.entries == entries);
+
+    // phfwdGet zapamiętuje go w osobno alokowanym bloku, z którego korzysta też phfwdGetInto.
+    pnum = phfwdGet(pf, longNum);
+    assert(strcmp(phnumGet(pnum, 0), longNum) == 0);
+    phnumDelete(pnum);
+
+    size_t hits = stats.hits;
+
+    len = phfwdGetInto(pf, longNum, buf, sizeof(buf));
+    assert(len == RESULT_SLOT && strcmp(buf, longNum) == 0);
+    result = phfwdResultCacheStats(pf, &stats);
+    assert(result && stats.entries == entries + 1 && stats.hits == hits + 1);
+    phfwdDelete(pf);
+    (void) len;
+
+    // Mała pamięć podręczna ciągle usuwa wyniki, duża mieści całą pulę.
+    checkCache(7, 12);
+    checkCache(64, 4);
+    checkCache(4 * POOL, 3);
+
+    (void) result;
+
+    return 0;
+}
@@ -0,0 +1,244 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "phone_forward.h"
+#include "phone_forward_testing.h"
+
+/// Największa liczba wątków czytających.
+#define MAX_READERS      16
+/// Liczba zapamiętywanych czasów odczytu jednego wątku.
+#define MAX_SAMPLES      200000
+/// Liczba przekierowań dodawanych przed pomiarem.
+#define INITIAL_FORWARDS 50000
+/// Największa długość numerów.
+#define MAX_LEN          16
+/// Liczba cyfr losowanych numerów: mało cyfr daje częste wspólne prefiksy.
+#define ALPHA            4
+
+struct ReaderState;
+/** To jest typ stanu jednego wątku czytającego. */
+typedef struct ReaderState ReaderState;
+
+/**
+ * To jest struktura przechowująca stan jednego wątku czytającego.
+ */
+struct ReaderState {
+    struct PhoneForward *pf; ///< wskaźnik na czytaną strukturę;
+    unsigned long long seed; ///< stan generatora liczb pseudolosowych;
+    size_t reads;            ///< liczba wykonanych odczytów;
+    size_t samples;          ///< liczba zapamiętanych czasów odczytu;
+    double latency[MAX_SAMPLES]; ///< czasy odczytu w milisekundach.
+};
+
+static int stopReaders = 0; ///< niezerowe, gdy wątki czytające mają się zakończyć.
+
+/** @brief Na zmianę wyznacza przekierowania i przekierowania odwrotne losowych numerów.
+ * @param[in,out] arg – wskaźnik na stan wątku.
+ * @return NULL.
+ */
+static void * reader(void *arg) {
+    ReaderState *state = arg;
+    char num[MAX_LEN + 1];
+    char buf[64];
+    int lastK = -1;
+
+    while (!__atomic_load_n(&stopReaders, __ATOMIC_RELAXED)) {
+        double start = testNow();
+
+        // przekierowanie 55556 zmienia się tylko na kolejne 9k6.
+        size_t n = phfwdGetInto(state->pf, "55556", buf, sizeof(buf));
+
+        assert(n < sizeof(buf));
+
+        if (strcmp(buf, "55556") != 0) {
+            int k = atoi(buf + 1) / 10;
+
+            assert(buf[0] == '9' && buf[n - 1] == '6' && k >= lastK);
+            lastK = k;
+        }
+
+        testRandomNumber(&state->seed, num, 1, MAX_LEN, ALPHA);
+
+        struct PhoneNumbers const *pnum = phfwdReverse(state->pf, num);
+
+        assert(pnum != NULL);
+
+        for (size_t i = 1; phnumGet(pnum, i) != NULL; i++)
+            assert(strcmp(phnumGet(pnum, i - 1), phnumGet(pnum, i)) < 0);
+
+        phnumDelete(pnum);
+
+        pnum = phfwdGet(state->pf, num);
+        assert(pnum != NULL && phnumGet(pnum, 0) != NULL);
+        phnumDelete(pnum);
+
+        if (state->samples < MAX_SAMPLES)
+            state->latency[state->samples++] = testNow() - start;
+
+        state->reads++;
+        (void) n;
+    }
+
+    return NULL;
+}
+
+/** @brief Porównuje liczby dla funkcji qsort.
+ * @param[in] a – wskaźnik na pierwszą liczbę;
+ * @param[in] b – wskaźnik na drugą liczbę.
+ * @return Liczbę ujemną, zero lub dodatnią, gdy pierwsza liczba jest
+ *         odpowiednio mniejsza, równa lub większa od drugiej.
+ */
+static int compareDoubles(void const *a, void const *b) {
+    double x = *(double const *) a, y = *(double const *) b;
+
+    return x < y ? -1 : x > y;
+}
+
+/** @brief Wypisuje przepustowość i percentyle czasów odczytu.
+ * @param[in] name    – nazwa pomiaru;
+ * @param[in] states  – stany wątków czytających;
+ * @param[in] readers – liczba wątków czytających;
+ * @param[in] elapsed – czas pomiaru w milisekundach.
+ */
+static void report(char const *name, ReaderState *states, int readers, double elapsed) {
+    size_t total = 0, count = 0;
+
+    for (int i = 0; i < readers; i++) {
+        total += states[i].reads;
+        count += states[i].samples;
+    }
+
+    double *all = malloc(count * sizeof(double));
+
+    assert(all != NULL);
+    count = 0;
+
+    for (int i = 0; i < readers; i++) {
+        memcpy(all + count, states[i].latency, states[i].samples * sizeof(double));
+        count += states[i].samples;
+    }
+
+    qsort(all, count, sizeof(double), compareDoubles);
+
+    if (count > 0)
+        printf("%s: %zu reads in %.0f ms, latency p50 %.1f us, p99 %.1f us, p99.9 %.1f us, max %.1f us\n",
+               name, total, elapsed, all[count / 2] * 1e3, all[count * 99 / 100] * 1e3,
+               all[count * 999 / 1000] * 1e3, all[count - 1] * 1e3);
+
+    free(all);
+}
+
+/** @brief Uruchamia wątki czytające na czas wykonania modyfikacji.
+ * Gdy @p writes jest zerem, wątki czytające działają przez @p duration
+ * milisekund.
+ * @param[in] name        – nazwa pomiaru;
+ * @param[in,out] pf      – wskaźnik na strukturę przekierowań;
+ * @param[in,out] states  – stany wątków czytających;
+ * @param[in] readers     – liczba wątków czytających;
+ * @param[in] writes      – liczba modyfikacji;
+ * @param[in] duration    – czas pomiaru bez modyfikacji;
+ * @param[in,out] seed    – wskaźnik na stan generatora.
+ */
+static void run(char const *name, struct PhoneForward *pf, ReaderState *states, int readers, int writes,
+                double duration, unsigned long long *seed) {
+    pthread_t threads[MAX_READERS];
+    char num1[MAX_LEN + 1], num2[MAX_LEN + 1];
+    bool result;
+
+    __atomic_store_n(&stopReaders, 0, __ATOMIC_RELAXED);
+
+    for (int i = 0; i < readers; i++) {
+        states[i].pf = pf;
+        states[i].seed = 7919 * (unsigned long long) (i + 1);
+        states[i].reads = 0;
+        states[i].samples = 0;
+        pthread_create(&threads[i], NULL, reader, &states[i]);
+    }
+
+    double start = testNow();
+
+    for (int k = 0; k < writes; k++) {
+        sprintf(num2, "9%d", k);
+        result = phfwdAdd(pf, "5555", num2);
+        assert(result);
+
+        testRandomNumber(seed, num1, 1, MAX_LEN, ALPHA);
+        testRandomNumber(seed, num2, 1, MAX_LEN, ALPHA);
+
+        // co trzecia modyfikacja usuwa całe poddrzewo krótkiego prefiksu.
+        if (k % 3 == 0) {
+            num1[1 + testRandom(seed) % 3] = '\0';
+            phfwdRemove(pf, num1);
+        }
+        else {
+            phfwdAdd(pf, num1, num2);
+        }
+    }
+
+    while (writes == 0 && testNow() - start < duration) {
+        struct timespec pause = {0, 1000000};
+
+        nanosleep(&pause, NULL);
+    }
+
+    double elapsed = testNow() - start;
+
+    __atomic_store_n(&stopReaders, 1, __ATOMIC_RELAXED);
+
+    for (int i = 0; i < readers; i++)
+        pthread_join(threads[i], NULL);
+
+    if (writes > 0)
+        printf("%s: %d writes in %.0f ms\n", name, 2 * writes, elapsed);
+
+    report(name, states, readers, elapsed);
+    (void) result;
+}
+
+/** @brief Porównuje czasy odczytów współbieżnych bez modyfikacji i w trakcie modyfikacji.
+ * Argumenty: liczba wątków czytających i liczba modyfikacji.
+ * @return Zero, gdy argumenty są poprawne, a w przeciwnym przypadku jeden.
+ */
+int main(int argc, char **argv) {
+    int readers = argc > 1 ? atoi(argv[1]) : 3;
+    int writes = argc > 2 ? atoi(argv[2]) : 20000;
+    unsigned long long seed = TEST_SEED;
+    char num1[MAX_LEN + 1], num2[MAX_LEN + 1];
+    bool result;
+
+    if (readers < 1 || readers > MAX_READERS || writes < 1) {
+        fprintf(stderr, "usage: %s [readers 1-%d] [writes]\n", argv[0], MAX_READERS);
+        return 1;
+    }
+
+    ReaderState *states = malloc((size_t) readers * sizeof(ReaderState));
+    struct PhoneForward *pf = phfwdNew();
+
+    assert(states != NULL && pf != NULL);
+
+    for (int i = 0; i < INITIAL_FORWARDS; i++) {
+        testRandomNumber(&seed, num1, 1, MAX_LEN, ALPHA);
+        testRandomNumber(&seed, num2, 1, MAX_LEN, ALPHA);
+        phfwdAdd(pf, num1, num2);
+    }
+
+    result = phfwdEnableConcurrentReads(pf);
+    assert(result);
+
+    // czas odczytów bez modyfikacji taki jak z modyfikacjami.
+    double start = testNow();
+
+    run("under writes", pf, states, readers, writes, 0, &seed);
+    run("no writes", pf, states, readers, 0, testNow() - start, &seed);
+
+    phfwdDelete(pf);
+    free(states);
+    (void) result;
+
+    return 0;
+}
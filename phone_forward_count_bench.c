@@ -0,0 +1,67 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "phone_forward.h"
+#include "phone_forward_testing.h"
+
+/// Największa długość numerów.
+#define MAX_LEN 22
+/// Liczba pomiarów, z których wybierany jest najlepszy.
+#define REPEATS 5
+/// Najmniejsza długość zliczanych numerów.
+#define COUNT_LEN 30
+
+/** @brief Mierzy czas phfwdNonTrivialCount przy rosnącej liczbie wątków.
+ * Każdy pomiar dotyczy innej długości numerów, więc wynik nie pochodzi
+ * z pamięci podręcznej wyników. Długość nie wpływa na liczbę odwiedzanych
+ * węzłów, bo jest większa niż długość wszystkich numerów w drzewie.
+ * Argumenty: liczba przekierowań i największa liczba wątków.
+ * @return Zero.
+ */
+int main(int argc, char **argv) {
+    size_t forwards = argc > 1 ? (size_t) atol(argv[1]) : 1000000;
+    unsigned maxThreads = argc > 2 ? (unsigned) atoi(argv[2]) : 16;
+    unsigned long long seed = TEST_SEED;
+    char num1[MAX_LEN + 1], num2[MAX_LEN + 1];
+    struct PhoneForward *pf = phfwdNew();
+    size_t len = COUNT_LEN;
+
+    assert(pf != NULL);
+
+    for (size_t i = 0; i < forwards; i++) {
+        // długie numery docelowe: zliczanie nie kończy się na płytkich węzłach
+        // z przekierowaniami, tylko przegląda prawie całe drzewo.
+        testRandomNumber(&seed, num1, 3, MAX_LEN, 12);
+        testRandomNumber(&seed, num2, 12, MAX_LEN, 12);
+        phfwdAdd(pf, num1, num2);
+    }
+
+    double base = 0;
+
+    for (unsigned threads = 1; threads <= maxThreads; threads *= 2) {
+        phfwdSetCountThreads(pf, threads);
+
+        // najlepszy z kilku pomiarów, żeby ograniczyć wpływ innych procesów.
+        double best = 0;
+
+        for (int r = 0; r < REPEATS; r++) {
+            double start = testNow();
+
+            phfwdNonTrivialCount(pf, TEST_DIGITS, len++);
+
+            double time = testNow() - start;
+
+            if (r == 0 || time < best)
+                best = time;
+        }
+
+        if (threads == 1)
+            base = best;
+
+        printf("%2u threads: %8.2f ms, speedup %.2fx\n", threads, best, base / best);
+    }
+
+    phfwdDelete(pf);
+
+    return 0;
+}
@@ -0,0 +1,81 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "phone_forward.h"
+#include "phone_forward_testing.h"
+
+/// Liczba przekierowań. Daje drzewo większe niż domyślny próg PARALLEL_MIN_NODES,
+/// więc przy kilku wątkach zliczanie jest dzielone.
+#define FORWARDS 80000
+/// Największa długość numerów.
+#define MAX_LEN  22
+/// Liczba struktur: zliczających w 1, 2, 4 i 8 wątkach.
+#define VARIANTS 4
+
+static unsigned long long seed = TEST_SEED; ///< stan generatora liczb pseudolosowych.
+
+/** @brief Sprawdza, że zliczanie w kilku wątkach daje ten sam wynik co w jednym.
+ * Struktury zawierają te same przekierowania, więc wyniki nie pochodzą
+ * z pamięci podręcznej wyników, choć z niej korzystają.
+ * @param[in] pfs – struktury zliczające w 1, 2, 4 i 8 wątkach.
+ */
+static void compareCounts(struct PhoneForward **pfs) {
+    static char const * const sets[] = {"01", "0123", ":;01x", TEST_DIGITS, "9", "a1b0", "012345678"};
+
+    for (size_t q = 0; q < 28; q++) {
+        char const *set = sets[q % 7];
+        size_t len = 1 + testRandom(&seed) % 30;
+        size_t expected = phfwdNonTrivialCount(pfs[0], set, len);
+
+        for (size_t i = 1; i < VARIANTS; i++)
+            assert(phfwdNonTrivialCount(pfs[i], set, len) == expected);
+
+        // ponowne zapytanie jest obsługiwane z pamięci podręcznej.
+        assert(phfwdNonTrivialCount(pfs[VARIANTS - 1], set, len) == expected);
+        (void) expected;
+    }
+}
+
+/** @brief Porównuje zliczanie nietrywialnych numerów w jednym i w kilku wątkach.
+ * Mniejsze progi podziału można sprawdzić, kompilując phone_forward.c
+ * z -DPARALLEL_MIN_NODES=1.
+ * @return Zero.
+ */
+int main() {
+    char num1[MAX_LEN + 1], num2[MAX_LEN + 1];
+    struct PhoneForward *pfs[VARIANTS];
+
+    // Pełny alfabet daje szerokie drzewo, trzy cyfry - głębokie.
+    for (size_t alpha = 12; alpha >= 3; alpha /= 2) {
+        for (size_t i = 0; i < VARIANTS; i++) {
+            pfs[i] = phfwdNew();
+            assert(pfs[i] != NULL);
+            phfwdSetCountThreads(pfs[i], 1u << i);
+        }
+
+        for (size_t i = 0; i < FORWARDS; i++) {
+            testRandomNumber(&seed, num1, 3, MAX_LEN, alpha);
+            testRandomNumber(&seed, num2, 3, MAX_LEN, alpha);
+
+            for (size_t j = 0; j < VARIANTS; j++)
+                phfwdAdd(pfs[j], num1, num2);
+        }
+
+        compareCounts(pfs);
+
+        // Po usunięciu części przekierowań wyniki nadal się zgadzają.
+        for (size_t i = 0; i < FORWARDS / 100; i++) {
+            testRandomNumber(&seed, num1, 3, 5, alpha);
+
+            for (size_t j = 0; j < VARIANTS; j++)
+                phfwdRemove(pfs[j], num1);
+        }
+
+        compareCounts(pfs);
+
+        for (size_t i = 0; i < VARIANTS; i++)
+            phfwdDelete(pfs[i]);
+    }
+
+    return 0;
+}
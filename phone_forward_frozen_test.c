@@ -0,0 +1,162 @@
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include "phone_forward.h"
+#include "phone_forward_testing.h"
+
+/// Liczba losowych przekierowań.
+#define FORWARDS 20000
+/// Liczba losowych zapytań jednego porównania.
+#define QUERIES  4000
+/// Największa długość numerów.
+#define MAX_LEN  20
+
+static unsigned long long seed = TEST_SEED; ///< stan generatora liczb pseudolosowych.
+
+/** @brief Porównuje zamrożoną strukturę z modyfikowalną na losowych zapytaniach.
+ * @param[in] pf     – wskaźnik na strukturę modyfikowalną;
+ * @param[in] frozen – wskaźnik na strukturę zamrożoną;
+ * @param[in] alpha  – liczba używanych cyfr.
+ */
+static void compareFrozen(struct PhoneForward *pf, struct PhfwdFrozen const *frozen, size_t alpha) {
+    char num[MAX_LEN + 1];
+
+    for (size_t i = 0; i < QUERIES; i++) {
+        testRandomNumber(&seed, num, 1, MAX_LEN, alpha);
+        testAssertSame(phfwdGet(pf, num), phfwdFrozenGet(frozen, num));
+        testAssertSame(phfwdReverse(pf, num), phfwdFrozenReverse(frozen, num));
+    }
+
+    for (size_t len = 0; len <= 12; len += 3)
+        assert(phfwdFrozenNonTrivialCount(frozen, TEST_DIGITS, len) == phfwdNonTrivialCount(pf, TEST_DIGITS, len));
+}
+
+/** @brief Porównuje dwie struktury modyfikowalne na losowych zapytaniach.
+ * @param[in] pf     – wskaźnik na strukturę wzorcową;
+ * @param[in] thawed – wskaźnik na strukturę odmrożoną;
+ * @param[in] alpha  – liczba używanych cyfr.
+ */
+static void compareThawed(struct PhoneForward *pf, struct PhoneForward *thawed, size_t alpha) {
+    char num[MAX_LEN + 1];
+
+    for (size_t i = 0; i < QUERIES; i++) {
+        testRandomNumber(&seed, num, 1, MAX_LEN, alpha);
+        testAssertSame(phfwdGet(pf, num), phfwdGet(thawed, num));
+        testAssertSame(phfwdReverse(pf, num), phfwdReverse(thawed, num));
+    }
+
+    assert(phfwdNonTrivialCount(thawed, TEST_DIGITS, 9) == phfwdNonTrivialCount(pf, TEST_DIGITS, 9));
+}
+
+/** @brief Porównuje zamrożoną i odmrożoną strukturę z modyfikowalną.
+ * @return Zero.
+ */
+int main() {
+    char num1[MAX_LEN + 1], num2[MAX_LEN + 1];
+    struct PhoneForward *pf, *thawed;
+    struct PhfwdFrozen *frozen;
+    struct PhoneNumbers const *pnum;
+    bool result, expected;
+
+    // Pusta baza.
+    pf = phfwdNew();
+    frozen = phfwdFreeze(pf);
+    assert(frozen != NULL);
+
+    pnum = phfwdFrozenGet(frozen, "123");
+    assert(phnumCount(pnum) == 1 && strcmp(phnumGet(pnum, 0), "123") == 0);
+    phnumDelete(pnum);
+
+    pnum = phfwdFrozenReverse(frozen, "123");
+    assert(phnumCount(pnum) == 1 && strcmp(phnumGet(pnum, 0), "123") == 0);
+    phnumDelete(pnum);
+
+    assert(phfwdFrozenNonTrivialCount(frozen, "0123456789", 5) == 0);
+
+    thawed = phfwdThaw(frozen);
+    assert(thawed != NULL);
+    compareThawed(pf, thawed, 12);
+    phfwdDelete(thawed);
+    phfwdFrozenDelete(frozen);
+
+    // Przykład z phone_forward_example.c.
+    phfwdAdd(pf, "123", "9");
+    phfwdAdd(pf, "123456", "777777");
+    phfwdAdd(pf, "567", "0");
+    phfwdAdd(pf, "5678", "08");
+    frozen = phfwdFreeze(pf);
+    assert(frozen != NULL);
+
+    pnum = phfwdFrozenGet(frozen, "12345");
+    assert(strcmp(phnumGet(pnum, 0), "945") == 0);
+    phnumDelete(pnum);
+
+    pnum = phfwdFrozenReverse(frozen, "08");
+    assert(phnumCount(pnum) == 2);
+    assert(strcmp(phnumGet(pnum, 0), "08") == 0 && strcmp(phnumGet(pnum, 1), "5678") == 0);
+    phnumDelete(pnum);
+
+    // Niepoprawne numery dają pusty ciąg.
+    pnum = phfwdFrozenGet(frozen, "12a");
+    assert(pnum != NULL && phnumGet(pnum, 0) == NULL);
+    phnumDelete(pnum);
+
+    pnum = phfwdFrozenReverse(frozen, "");
+    assert(pnum != NULL && phnumGet(pnum, 0) == NULL);
+    phnumDelete(pnum);
+
+    phfwdFrozenDelete(frozen);
+    phfwdDelete(pf);
+
+    // Pełny alfabet daje szerokie drzewo, dwie cyfry - głębokie.
+    for (size_t alpha = 12; alpha >= 2; alpha /= 2) {
+        pf = phfwdNew();
+        assert(pf != NULL);
+
+        for (size_t i = 0; i < FORWARDS; i++) {
+            testRandomNumber(&seed, num1, 1, MAX_LEN, alpha);
+            testRandomNumber(&seed, num2, 1, MAX_LEN, alpha);
+            phfwdAdd(pf, num1, num2);
+        }
+
+        // Usunięcia zostawiają w drzewie węzły bez przekierowań.
+        for (size_t i = 0; i < FORWARDS / 50; i++) {
+            testRandomNumber(&seed, num1, 1, MAX_LEN, alpha);
+            phfwdRemove(pf, num1);
+        }
+
+        frozen = phfwdFreeze(pf);
+        assert(frozen != NULL);
+        compareFrozen(pf, frozen, alpha);
+
+        // Odmrożona struktura ma te same przekierowania i można ją dalej zmieniać.
+        thawed = phfwdThaw(frozen);
+        assert(thawed != NULL);
+        compareThawed(pf, thawed, alpha);
+
+        for (size_t i = 0; i < FORWARDS / 10; i++) {
+            testRandomNumber(&seed, num1, 1, MAX_LEN, alpha);
+            testRandomNumber(&seed, num2, 1, MAX_LEN, alpha);
+            expected = phfwdAdd(pf, num1, num2);
+            result = phfwdAdd(thawed, num1, num2);
+            assert(result == expected);
+
+            if (i % 5 == 0) {
+                testRandomNumber(&seed, num1, 1, MAX_LEN, alpha);
+                phfwdRemove(pf, num1);
+                phfwdRemove(thawed, num1);
+            }
+        }
+
+        compareThawed(pf, thawed, alpha);
+
+        phfwdDelete(thawed);
+        phfwdFrozenDelete(frozen);
+        phfwdDelete(pf);
+    }
+
+    (void) result;
+    (void) expected;
+
+    return 0;
+}
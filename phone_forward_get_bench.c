@@ -0,0 +1,88 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "phone_forward.h"
+#include "phone_forward_testing.h"
+
+/// Najmniejsza długość numerów w zapytaniach.
+#define MIN_LEN 10
+/// Największa długość numerów w zapytaniach.
+#define MAX_LEN 50
+/// Liczba pomiarów, z których wybierany jest najlepszy.
+#define REPEATS 3
+
+/** @brief Mierzy czas phfwdGet i phfwdGetInto na numerach o długości od 10 do 50 cyfr.
+ * Numery składają się z cyfr 0-3, więc zapytania schodzą głęboko w drzewo.
+ * Argumenty: liczba przekierowań i liczba zapytań.
+ * @return Zero.
+ */
+int main(int argc, char **argv) {
+    size_t forwards = argc > 1 ? (size_t) atol(argv[1]) : 200000;
+    size_t queries = argc > 2 ? (size_t) atol(argv[2]) : 2000000;
+    unsigned long long seed = TEST_SEED;
+    char num1[MAX_LEN + 1], num2[MAX_LEN + 1];
+    char buf[2 * MAX_LEN + 1];
+    struct PhoneForward *pf = phfwdNew();
+    char *numbers = malloc(queries * (MAX_LEN + 1));
+
+    assert(pf != NULL && numbers != NULL);
+
+    for (size_t i = 0; i < forwards; i++) {
+        testRandomNumber(&seed, num1, 1, 30, 4);
+        testRandomNumber(&seed, num2, 1, 30, 4);
+        phfwdAdd(pf, num1, num2);
+    }
+
+    for (size_t i = 0; i < queries; i++)
+        testRandomNumber(&seed, numbers + i * (MAX_LEN + 1), MIN_LEN, MAX_LEN, 4);
+
+    double getTime = 0, intoTime = 0;
+    size_t getDigest = 0, intoDigest = 0;
+
+    // najlepszy z kilku pomiarów, żeby ograniczyć wpływ innych procesów.
+    for (int r = 0; r < REPEATS; r++) {
+        double start = testNow();
+
+        getDigest = 0;
+        for (size_t i = 0; i < queries; i++) {
+            struct PhoneNumbers const *pnum = phfwdGet(pf, numbers + i * (MAX_LEN + 1));
+            char const *num = phnumGet(pnum, 0);
+
+            assert(num != NULL);
+            getDigest += (size_t) num[0] + strlen(num);
+            phnumDelete(pnum);
+        }
+
+        double time = testNow() - start;
+
+        if (r == 0 || time < getTime)
+            getTime = time;
+
+        start = testNow();
+
+        intoDigest = 0;
+        for (size_t i = 0; i < queries; i++) {
+            size_t len = phfwdGetInto(pf, numbers + i * (MAX_LEN + 1), buf, sizeof(buf));
+
+            assert(len > 0 && len < sizeof(buf));
+            intoDigest += (size_t) buf[0] + len;
+        }
+
+        time = testNow() - start;
+
+        if (r == 0 || time < intoTime)
+            intoTime = time;
+    }
+
+    assert(getDigest == intoDigest);
+    printf("%zu forwards, %zu queries of %d-%d digits (digest %zu)\n", forwards, queries, MIN_LEN, MAX_LEN,
+           getDigest);
+    printf("phfwdGet:     %.0f ns/query\n", getTime * 1e6 / (double) queries);
+    printf("phfwdGetInto: %.0f ns/query\n", intoTime * 1e6 / (double) queries);
+
+    phfwdDelete(pf);
+    free(numbers);
+
+    return 0;
+}
@@ -1,21 +1,76 @@
 #include <stdio.h>
 #include <stdbool.h>
+#include <string.h>
 #include "wczytywanie.h"
+#include "parser.h"
 #include "baza.h"
+#include "dziennik.h"
 
 
 
 
-int main() {
+/**
+ * Wywołanie: phone_forward [PLIK_BAZ [PLIK_ZAPISU [PLIK_DZIENNIKA]]]. Jeśli
+ * istnieje plik PLIK_BAZ, bazy przekierowań są otwierane z zapisu w tym pliku.
+ * Jeśli podano niepusty PLIK_ZAPISU, po przetworzeniu wejścia bez błędów
+ * wszystkie bazy są zapisywane do tego pliku, którym może być również PLIK_BAZ.
+ * Jeśli podano PLIK_DZIENNIKA, operacje z niego są powtarzane na otwartych
+ * bazach, a kolejne operacje zmieniające bazy są do niego dopisywane. Po
+ * zapisaniu baz z powrotem do PLIK_BAZ dziennik jest opróżniany.
+ */
+int main(int argc, char *argv[]) {
     bool errorAppeared = false;
     bool memoryProblems = false;
+    PfList *base;
 
-    // tworzenie głównej bazy z atrapą.
-    PfList *base = createMainBaseElement(NULL, &memoryProblems);
+    FILE *saved = argc > 1 ? fopen(argv[1], "rb") : NULL;
+
+    // tworzenie głównej bazy z atrapą lub otwarcie zapisanych baz.
+    if (saved != NULL) {
+        fclose(saved);
+        base = openBases(argv[1], &memoryProblems);
+
+        if (base == NULL) {
+            fprintf(stderr, "ERROR %s\n", argv[1]);
+            return 1;
+        }
+    }
+    else base = createMainBaseElement(NULL, &memoryProblems);
+
+    Journal *journal = NULL;
+
+    // odtworzenie operacji wykonanych po ostatnim zapisie baz.
+    if (argc > 3 && base != NULL) {
+        if (!journalReplay(argv[3], base, &memoryProblems) || (journal = journalOpen(argv[3])) == NULL) {
+            fprintf(stderr, "ERROR %s\n", argv[3]);
+            deleteWholeBase(base);
+            return 1;
+        }
+
+        setParserJournal(journal);
+    }
 
     readInput(base, &errorAppeared, &memoryProblems);
 
+    if (argc > 2 && argv[2][0] != '\0' && !errorAppeared && !memoryProblems) {
+        if (!saveBases(base, argv[2])) {
+            fprintf(stderr, "ERROR %s\n", argv[2]);
+            errorAppeared = true;
+        }
+        // zapisane bazy zawierają już skutki operacji z dziennika.
+        else if (journal != NULL && strcmp(argv[1], argv[2]) == 0 && !journalReset(journal)) {
+            fprintf(stderr, "ERROR %s\n", argv[3]);
+            errorAppeared = true;
+        }
+    }
+
+    if (!journalClose(journal)) {
+        fprintf(stderr, "ERROR %s\n", argv[3]);
+        errorAppeared = true;
+    }
+
     deleteWholeBase(base);
+    cleanParserBuffers();
 
     if (errorAppeared || memoryProblems)
         return 1;
@@ -0,0 +1,175 @@
+#define _DEFAULT_SOURCE
+
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "phone_forward.h"
+#include "phone_forward_testing.h"
+
+/// Największa długość sprawdzanych numerów.
+#define MAX_LEN 70
+
+static char *page; ///< strona pamięci, przed którą i za którą leżą strony niedostępne.
+static size_t pageSize; ///< rozmiar strony pamięci.
+
+/** @brief Kopiuje napis na koniec strony.
+ * Kończący napis znak '\0' zajmuje ostatni bajt strony, za którą leży
+ * strona niedostępna.
+ * @param[in] num – kopiowany napis.
+ * @return Wskaźnik na kopię napisu.
+ */
+static char const * atPageEnd(char const *num) {
+    size_t len = strlen(num);
+    char *copy = page + pageSize - len - 1;
+
+    memcpy(copy, num, len + 1);
+
+    return copy;
+}
+
+/** @brief Kopiuje napis na początek strony, przed którą leży strona niedostępna.
+ * @param[in] num – kopiowany napis.
+ * @return Wskaźnik na kopię napisu.
+ */
+static char const * atPageStart(char const *num) {
+    strcpy(page, num);
+
+    return page;
+}
+
+/** @brief Sprawdza przekierowanie numeru funkcjami phfwdGet i phfwdGetInto.
+ * @param[in] pf     – wskaźnik na strukturę przekierowań;
+ * @param[in] num    – wskaźnik na napis reprezentujący numer;
+ * @param[in] target – oczekiwany wynik lub NULL, gdy napis nie jest numerem.
+ */
+static void assertGet(struct PhoneForward *pf, char const *num, char const *target) {
+    struct PhoneNumbers const *pnum = phfwdGet(pf, num);
+    char buf[2 * MAX_LEN + 2];
+
+    assert(pnum != NULL);
+    assert(target == NULL ? phnumGet(pnum, 0) == NULL : strcmp(phnumGet(pnum, 0), target) == 0);
+    phnumDelete(pnum);
+
+    size_t len = phfwdGetInto(pf, num, buf, sizeof(buf));
+
+    assert(target == NULL ? len == 0 : len == strlen(target) && strcmp(buf, target) == 0);
+    (void) len;
+    (void) target;
+}
+
+/** @brief Sprawdza funkcje przyjmujące numer przy granicy strony.
+ * @param[in] len – długość numeru.
+ */
+static void checkLength(size_t len) {
+    struct PhoneForward *pf = phfwdNew();
+    struct PhoneNumbers const *pnum;
+    char num[MAX_LEN + 2];
+    bool result;
+
+    assert(pf != NULL);
+
+    for (size_t i = 0; i < len; i++)
+        num[i] = TEST_DIGITS[(i * 7 + len) % 12];
+
+    num[len] = '\0';
+
+    // przekierowanie z numeru przy końcu strony na numer przy jej początku.
+    result = phfwdAdd(pf, atPageEnd(num), atPageStart("9"));
+    assert(result);
+
+    assertGet(pf, atPageEnd(num), "9");
+    assertGet(pf, atPageStart(num), "9");
+
+    // przedłużenie numeru jest przekierowywane razem z nim.
+    strcpy(num + len, "1");
+    assertGet(pf, atPageEnd(num), "91");
+    num[len] = '\0';
+
+    // znaki ':' i ';' są w porządku numerów po cyfrze 9.
+    pnum = phfwdReverse(pf, atPageEnd("9"));
+    assert(phnumCount(pnum) == 2 && strcmp(phnumGet(pnum, strcmp(num, "9") > 0), num) == 0);
+    phnumDelete(pnum);
+
+    // niepoprawny znak na każdej pozycji, także tuż przed końcem strony.
+    for (size_t i = 0; i < len; i++) {
+        char saved = num[i];
+
+        num[i] = i % 2 ? '/' : '<';
+        assertGet(pf, atPageEnd(num), NULL);
+        assertGet(pf, atPageStart(num), NULL);
+
+        result = phfwdAdd(pf, atPageEnd(num), "1");
+        assert(!result);
+        result = phfwdAdd(pf, "1", atPageEnd(num));
+        assert(!result);
+
+        pnum = phfwdReverse(pf, atPageEnd(num));
+        assert(pnum != NULL && phnumGet(pnum, 0) == NULL);
+        phnumDelete(pnum);
+
+        num[i] = saved;
+    }
+
+    phfwdRemove(pf, atPageEnd(num));
+    assertGet(pf, atPageStart(num), num);
+
+    phfwdDelete(pf);
+    (void) result;
+}
+
+/** @brief Sprawdza budowanie struktury z napisów przy granicach strony.
+ */
+static void checkBuild(void) {
+    char const *num1[] = {atPageEnd("12345"), "777"};
+    char const *num2[] = {atPageStart("8"), atPageEnd("12345")};
+    struct PhoneForward *pf = phfwdBuild(num1, num2, 2);
+
+    assert(pf != NULL);
+    assertGet(pf, "123456", "86");
+    assertGet(pf, "7770", "123450");
+    phfwdDelete(pf);
+}
+
+/** @brief Sprawdza, że sprawdzanie numerów nie czyta pamięci za napisem ani przed nim.
+ * Napisy leżą przy granicach strony otoczonej stronami niedostępnymi, więc
+ * odczyt spoza napisu przerywa program.
+ * @return Zero.
+ */
+int main() {
+    struct PhoneForward *pf;
+    bool result;
+
+    pageSize = (size_t) sysconf(_SC_PAGESIZE);
+
+    char *mapping = mmap(NULL, 3 * pageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    assert(mapping != MAP_FAILED);
+    page = mapping + pageSize;
+
+    int status = mprotect(mapping, pageSize, PROT_NONE) | mprotect(page + pageSize, pageSize, PROT_NONE);
+
+    assert(status == 0);
+    (void) status;
+
+    // Pusty napis nie jest numerem.
+    pf = phfwdNew();
+    assert(pf != NULL);
+    result = phfwdAdd(pf, atPageEnd(""), "1");
+    assert(!result);
+    assertGet(pf, atPageEnd(""), NULL);
+    phfwdDelete(pf);
+
+    // Numery wszystkich długości, więc koniec napisu wypada w każdym miejscu
+    // bloku czytanego naraz.
+    for (size_t len = 1; len <= MAX_LEN; len++)
+        checkLength(len);
+
+    checkBuild();
+
+    munmap(mapping, 3 * pageSize);
+    (void) result;
+
+    return 0;
+}
@@ -0,0 +1,240 @@
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include "phone_forward_shared.h"
+
+
+
+/** @brief Udostępnia licznik czytelników bieżącego wątku.
+ * @param[in] shared - wskaźnik na współdzieloną strukturę.
+ * @return Wskaźnik na licznik czytelników.
+ */
+static ReaderSlot * readerSlot(struct PhfwdShared *shared) {
+    return &shared->slots[threadReaderSlot()];
+}
+
+
+/** @brief Rozpoczyna odczyt współdzielonej struktury.
+ * Rejestruje czytelnika w liczniku aktywnej repliki. Jeśli w międzyczasie
+ * opublikowano drugą replikę, wycofuje się i próbuje ponownie, dzięki czemu
+ * modyfikujący, który nie widzi czytelnika w liczniku, może bezpiecznie
+ * zmieniać nieaktywną replikę.
+ * @param[in] shared - wskaźnik na współdzieloną strukturę;
+ * @param[in] slot - licznik czytelników bieżącego wątku;
+ * @param[out] which - indeks odczytywanej repliki.
+ * @return Wskaźnik na odczytywaną replikę.
+ */
+static struct PhoneForward * readBegin(struct PhfwdShared *shared, ReaderSlot *slot, unsigned *which) {
+    for (;;) {
+        unsigned active = __atomic_load_n(&shared->active, __ATOMIC_SEQ_CST);
+
+        __atomic_fetch_add(&slot->readers[active], 1, __ATOMIC_SEQ_CST);
+
+        if (__atomic_load_n(&shared->active, __ATOMIC_SEQ_CST) == active) {
+            *which = active;
+            return shared->replicas[active];
+        }
+
+        __atomic_fetch_sub(&slot->readers[active], 1, __ATOMIC_RELEASE);
+    }
+}
+
+
+/** @brief Kończy odczyt współdzielonej struktury.
+ * @param[in] slot - licznik czytelników bieżącego wątku;
+ * @param[in] which - indeks odczytywanej repliki.
+ */
+static void readEnd(ReaderSlot *slot, unsigned which) {
+    __atomic_fetch_sub(&slot->readers[which], 1, __ATOMIC_RELEASE);
+}
+
+
+/** @brief Czeka, aż żaden czytelnik nie będzie odczytywał danej repliki.
+ * Wywoływana po opublikowaniu drugiej repliki, więc nowi czytelnicy
+ * już się na niej nie rejestrują.
+ * @param[in] shared - wskaźnik na współdzieloną strukturę;
+ * @param[in] which - indeks opuszczanej repliki.
+ */
+static void waitForReaders(struct PhfwdShared *shared, unsigned which) {
+    for (size_t i = 0; i < READER_SLOTS; i++) {
+        while (__atomic_load_n(&shared->slots[i].readers[which], __ATOMIC_SEQ_CST) != 0)
+            sched_yield();
+    }
+}
+
+
+/** @brief Wykonuje modyfikację na jednej replice.
+ * @param[in,out] pf - wskaźnik na replikę;
+ * @param[in] num1 - numer, którego dotyczy modyfikacja;
+ * @param[in] num2 - numer, na który przekierowujemy, lub NULL, gdy usuwamy przekierowania.
+ * @return Wartość @p true, jeśli modyfikacja się udała.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool applyUpdate(struct PhoneForward *pf, char const *num1, char const *num2) {
+    if (num2 != NULL)
+        return phfwdAdd(pf, num1, num2);
+
+    phfwdRemove(pf, num1);
+
+    return true;
+}
+
+
+/** @brief Zastępuje nieaktywną replikę kopią aktywnej.
+ * Wywoływana, gdy powtórzenie modyfikacji na nieaktywnej replice się nie udało.
+ * @param[in,out] shared - wskaźnik na współdzieloną strukturę;
+ * @param[in] which - indeks nieaktywnej repliki.
+ * @return Wartość @p true, jeśli się udało.
+ *         Wartość @p false w przypadku problemów z alokacją pamięci.
+ */
+static bool resyncReplica(struct PhfwdShared *shared, unsigned which) {
+    struct PhoneForward *copy = phfwdClone(shared->replicas[1 - which]);
+
+    // problem z alokacją pamięci.
+    if (copy == NULL)
+        return false;
+
+    phfwdDelete(shared->replicas[which]);
+    shared->replicas[which] = copy;
+
+    return true;
+}
+
+
+/** @brief Wykonuje modyfikację współdzielonej struktury.
+ * Modyfikuje replikę nieaktywną, publikuje ją, czeka na opuszczenie
+ * poprzedniej repliki przez czytelników i powtarza na niej modyfikację.
+ * @param[in,out] shared - wskaźnik na współdzieloną strukturę;
+ * @param[in] num1 - numer, którego dotyczy modyfikacja;
+ * @param[in] num2 - numer, na który przekierowujemy, lub NULL, gdy usuwamy przekierowania.
+ * @return Wartość @p true, jeśli modyfikacja się udała.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool sharedUpdate(struct PhfwdShared *shared, char const *num1, char const *num2) {
+    pthread_mutex_lock(&shared->writeLock);
+
+    unsigned idle = 1 - shared->active;
+
+    // poprzednia modyfikacja nie została powtórzona na nieaktywnej replice.
+    if (shared->lagging) {
+        if (!resyncReplica(shared, idle)) {
+            pthread_mutex_unlock(&shared->writeLock);
+            return false;
+        }
+
+        shared->lagging = false;
+    }
+
+    bool result = applyUpdate(shared->replicas[idle], num1, num2);
+
+    if (result) {
+        __atomic_store_n(&shared->active, idle, __ATOMIC_SEQ_CST);
+        waitForReaders(shared, 1 - idle);
+
+        // repliki się rozeszły, uzgodnimy je przy następnej modyfikacji, jeśli teraz się nie uda.
+        if (!applyUpdate(shared->replicas[1 - idle], num1, num2))
+            shared->lagging = !resyncReplica(shared, 1 - idle);
+    }
+    else {
+        // nieudana modyfikacja mogła zmienić część repliki, uzgodnimy ją przy następnej.
+        shared->lagging = true;
+    }
+
+    pthread_mutex_unlock(&shared->writeLock);
+
+    return result;
+}
+
+
+struct PhfwdShared * phfwdSharedNew(void) {
+    // liczniki czytelników są wyrównane do linii pamięci podręcznej.
+    struct PhfwdShared *shared = aligned_alloc(CACHE_LINE, sizeof(struct PhfwdShared));
+
+    if (shared == NULL)
+        return NULL;
+
+    memset(shared, 0, sizeof(struct PhfwdShared));
+    shared->replicas[0] = phfwdNew();
+    shared->replicas[1] = phfwdNew();
+
+    // problem z alokacją pamięci.
+    if (shared->replicas[0] == NULL || shared->replicas[1] == NULL
+        || pthread_mutex_init(&shared->writeLock, NULL) != 0) {
+        phfwdDelete(shared->replicas[0]);
+        phfwdDelete(shared->replicas[1]);
+        free(shared);
+        return NULL;
+    }
+
+    return shared;
+}
+
+
+void phfwdSharedDelete(struct PhfwdShared *shared) {
+    if (shared == NULL)
+        return;
+
+    pthread_mutex_destroy(&shared->writeLock);
+    phfwdDelete(shared->replicas[0]);
+    phfwdDelete(shared->replicas[1]);
+    free(shared);
+}
+
+
+bool phfwdSharedAdd(struct PhfwdShared *shared, char const *num1, char const *num2) {
+    if (shared == NULL || num1 == NULL || num2 == NULL)
+        return false;
+
+    return sharedUpdate(shared, num1, num2);
+}
+
+
+bool phfwdSharedRemove(struct PhfwdShared *shared, char const *num) {
+    if (shared == NULL || num == NULL)
+        return false;
+
+    return sharedUpdate(shared, num, NULL);
+}
+
+
+struct PhoneNumbers const * phfwdSharedGet(struct PhfwdShared *shared, char const *num) {
+    if (shared == NULL)
+        return NULL;
+
+    ReaderSlot *slot = readerSlot(shared);
+    unsigned which;
+    struct PhoneNumbers const *result = phfwdGet(readBegin(shared, slot, &which), num);
+
+    readEnd(slot, which);
+
+    return result;
+}
+
+
+struct PhoneNumbers const * phfwdSharedReverse(struct PhfwdShared *shared, char const *num) {
+    if (shared == NULL)
+        return NULL;
+
+    ReaderSlot *slot = readerSlot(shared);
+    unsigned which;
+    struct PhoneNumbers const *result = phfwdReverse(readBegin(shared, slot, &which), num);
+
+    readEnd(slot, which);
+
+    return result;
+}
+
+
+size_t phfwdSharedNonTrivialCount(struct PhfwdShared *shared, char const *set, size_t len) {
+    if (shared == NULL)
+        return 0;
+
+    ReaderSlot *slot = readerSlot(shared);
+    unsigned which;
+    // pamięć podręczna wyników repliki nie jest współdzielona przez czytelników.
+    size_t result = phfwdNonTrivialCountUncached(readBegin(shared, slot, &which), set, len);
+
+    readEnd(slot, which);
+
+    return result;
+}
@@ -0,0 +1,106 @@
+/** @file
+ * Interfejs struktury przekierowań współdzielonej przez wiele wątków
+ *
+ * Odczyty nie blokują się nawzajem ani na modyfikacjach: struktura
+ * przechowuje dwie repliki przekierowań. Modyfikacja jest wykonywana
+ * na replice, której nikt nie czyta, po czym replika ta zostaje
+ * opublikowana dla czytelników. Gdy ostatni czytelnik opuści poprzednią
+ * replikę, ta sama modyfikacja jest powtarzana na niej.
+ * Modyfikacje są wykonywane pojedynczo, pod blokadą.
+ *
+ * Obie repliki są pełnymi strukturami przekierowań, więc struktura zajmuje
+ * dwa razy więcej pamięci niż struktura @ref PhoneForward z tymi samymi
+ * przekierowaniami. Zajmowana pamięć nie jest ograniczana ani raportowana.
+ * Gdy modyfikacja się nie uda, także z powodu niepoprawnych argumentów,
+ * następna modyfikacja najpierw zastępuje nieaktywną replikę kopią aktywnej,
+ * więc przez jej czas w pamięci są trzy repliki.
+ */
+
+#ifndef _PHONE_FORWARD_SHARED_H
+#define _PHONE_FORWARD_SHARED_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <pthread.h>
+#include "phone_forward.h"
+
+/**
+ * Struktura przekierowań współdzielona przez wątki.
+ */
+struct PhfwdShared {
+    struct PhoneForward *replicas[2]; // dwie repliki tych samych przekierowań.
+    unsigned active; // indeks repliki udostępnionej czytelnikom.
+    bool lagging; // czy replika nieaktywna nie nadąża za aktywną.
+    pthread_mutex_t writeLock; // blokada szeregująca modyfikacje.
+    ReaderSlot slots[READER_SLOTS]; // liczniki czytelników.
+};
+
+/** @brief Tworzy nową współdzieloną strukturę.
+ * Tworzy nową współdzieloną strukturę niezawierającą żadnych przekierowań.
+ * @return Wskaźnik na utworzoną strukturę lub NULL, gdy nie udało się
+ *         alokować pamięci.
+ */
+struct PhfwdShared * phfwdSharedNew(void);
+
+/** @brief Usuwa współdzieloną strukturę.
+ * Nic nie robi, jeśli wskaźnik @p shared ma wartość NULL. Żaden wątek
+ * nie może w tym czasie korzystać ze struktury.
+ * @param[in] shared – wskaźnik na usuwaną strukturę.
+ */
+void phfwdSharedDelete(struct PhfwdShared *shared);
+
+/** @brief Dodaje przekierowanie.
+ * Działa jak funkcja @ref phfwdAdd. Czytelnicy widzą zmianę w całości
+ * albo wcale. Może być wywoływana równocześnie z odczytami i innymi
+ * modyfikacjami.
+ * @param[in,out] shared – wskaźnik na współdzieloną strukturę;
+ * @param[in] num1       – wskaźnik na napis reprezentujący prefiks numerów
+ *                         przekierowywanych;
+ * @param[in] num2       – wskaźnik na napis reprezentujący prefiks numerów,
+ *                         na które jest wykonywane przekierowanie.
+ * @return Wartość @p true, jeśli przekierowanie zostało dodane.
+ *         Wartość @p false, jeśli wystąpił błąd, np. podany napis nie
+ *         reprezentuje numeru, oba podane numery są identyczne lub nie udało
+ *         się alokować pamięci.
+ */
+bool phfwdSharedAdd(struct PhfwdShared *shared, char const *num1, char const *num2);
+
+/** @brief Usuwa przekierowania.
+ * Działa jak funkcja @ref phfwdRemove. Może być wywoływana równocześnie
+ * z odczytami i innymi modyfikacjami.
+ * @param[in,out] shared – wskaźnik na współdzieloną strukturę;
+ * @param[in] num        – wskaźnik na napis reprezentujący prefiks numerów.
+ * @return Wartość @p true, jeśli przekierowania zostały usunięte.
+ *         Wartość @p false, jeśli wskaźnik @p shared lub @p num ma wartość
+ *         NULL albo nie udało się alokować pamięci.
+ */
+bool phfwdSharedRemove(struct PhfwdShared *shared, char const *num);
+
+/** @brief Wyznacza przekierowanie numeru.
+ * Działa jak funkcja @ref phfwdGet. Nie blokuje się na modyfikacjach.
+ * @param[in] shared – wskaźnik na współdzieloną strukturę;
+ * @param[in] num    – wskaźnik na napis reprezentujący numer.
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci.
+ */
+struct PhoneNumbers const * phfwdSharedGet(struct PhfwdShared *shared, char const *num);
+
+/** @brief Wyznacza przekierowania na dany numer.
+ * Działa jak funkcja @ref phfwdReverse. Nie blokuje się na modyfikacjach.
+ * @param[in] shared – wskaźnik na współdzieloną strukturę;
+ * @param[in] num    – wskaźnik na napis reprezentujący numer.
+ * @return Wskaźnik na strukturę przechowującą ciąg numerów lub NULL, gdy nie
+ *         udało się alokować pamięci.
+ */
+struct PhoneNumbers const * phfwdSharedReverse(struct PhfwdShared *shared, char const *num);
+
+/** @brief Oblicza liczbę nietrywialnych numerów.
+ * Działa jak funkcja @ref phfwdNonTrivialCount. Nie blokuje się na modyfikacjach.
+ * @param[in] shared – wskaźnik na współdzieloną strukturę;
+ * @param[in] set    – wskaźnik na napis set;
+ * @param[in] len    – długość numerów.
+ * @return Liczbę nietrywialnych numerów.
+ */
+size_t phfwdSharedNonTrivialCount(struct PhfwdShared *shared, char const *set, size_t len);
+
+#endif /* _PHONE_FORWARD_SHARED_H */
@@ -0,0 +1,178 @@
+#include <assert.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include "phone_forward.h"
+#include "phone_forward_shared.h"
+#include "phone_forward_testing.h"
+
+/// Liczba losowych przekierowań.
+#define FORWARDS 5000
+/// Liczba losowych zapytań jednego porównania.
+#define QUERIES  2000
+/// Największa długość numerów.
+#define MAX_LEN  16
+/// Liczba wątków czytających.
+#define READERS  3
+/// Liczba zmian wykonywanych w trakcie odczytów.
+#define WRITES   3000
+
+static unsigned long long seed = TEST_SEED; ///< stan generatora liczb pseudolosowych.
+static struct PhfwdShared *readShared; ///< struktura czytana przez wątki.
+static atomic_bool stop; ///< czy wątki czytające mają skończyć.
+
+/** @brief Porównuje współdzieloną strukturę z modyfikowalną na losowych zapytaniach.
+ * @param[in] pf     – wskaźnik na strukturę wzorcową;
+ * @param[in] shared – wskaźnik na strukturę współdzieloną;
+ * @param[in] alpha  – liczba używanych cyfr.
+ */
+static void compareShared(struct PhoneForward *pf, struct PhfwdShared *shared, size_t alpha) {
+    char num[MAX_LEN + 1];
+
+    for (size_t i = 0; i < QUERIES; i++) {
+        testRandomNumber(&seed, num, 1, MAX_LEN, alpha);
+        testAssertSame(phfwdGet(pf, num), phfwdSharedGet(shared, num));
+        testAssertSame(phfwdReverse(pf, num), phfwdSharedReverse(shared, num));
+    }
+
+    for (size_t len = 0; len <= 12; len += 3)
+        assert(phfwdSharedNonTrivialCount(shared, TEST_DIGITS, len) == phfwdNonTrivialCount(pf, TEST_DIGITS, len));
+}
+
+/** @brief Czyta przekierowania zmieniane przez wątek główny.
+ * Wątek główny zmienia przekierowanie numeru 1 na coraz większe numery,
+ * więc kolejne odczyty nie mogą dać mniejszego wyniku. Przekierowanie
+ * z numeru 2 na 9 nigdy nie jest usuwane, więc nie może zniknąć.
+ * @param[in] arg – nieużywany.
+ * @return NULL.
+ */
+static void * reader(void *arg) {
+    char last[MAX_LEN + 1] = "1000000";
+
+    (void) arg;
+
+    while (!atomic_load(&stop)) {
+        struct PhoneNumbers const *pnum = phfwdSharedGet(readShared, "1");
+        char const *num = phnumGet(pnum, 0);
+
+        assert(num != NULL && strlen(num) == strlen(last) && strcmp(num, last) >= 0);
+        strcpy(last, num);
+        phnumDelete(pnum);
+
+        pnum = phfwdSharedReverse(readShared, "9");
+        assert(phnumCount(pnum) >= 2 && phnumCount(pnum) <= 3 && strcmp(phnumGet(pnum, 0), "2") == 0);
+        phnumDelete(pnum);
+    }
+
+    return NULL;
+}
+
+/** @brief Porównuje strukturę współdzieloną z modyfikowalną i czyta ją
+ * równocześnie z modyfikacjami.
+ * @return Zero.
+ */
+int main() {
+    char num1[MAX_LEN + 1], num2[MAX_LEN + 1];
+    struct PhfwdShared *shared;
+    struct PhoneForward *pf;
+    bool expected, result;
+
+    // Pusta baza.
+    shared = phfwdSharedNew();
+    assert(shared != NULL);
+
+    struct PhoneNumbers const *pnum = phfwdSharedGet(shared, "123");
+
+    assert(phnumCount(pnum) == 1 && strcmp(phnumGet(pnum, 0), "123") == 0);
+    phnumDelete(pnum);
+
+    result = phfwdSharedAdd(shared, "12", "12");
+    assert(!result);
+    result = phfwdSharedAdd(shared, "12a", "1");
+    assert(!result);
+    result = phfwdSharedRemove(shared, "");
+    assert(result);
+    result = phfwdSharedRemove(shared, NULL);
+    assert(!result);
+    phfwdSharedDelete(shared);
+
+    // Obie repliki przechodzą te same zmiany co struktura wzorcowa.
+    for (size_t alpha = 12; alpha >= 3; alpha /= 2) {
+        shared = phfwdSharedNew();
+        pf = phfwdNew();
+        assert(shared != NULL && pf != NULL);
+
+        for (size_t i = 0; i < FORWARDS; i++) {
+            testRandomNumber(&seed, num1, 1, MAX_LEN, alpha);
+            testRandomNumber(&seed, num2, 1, MAX_LEN, alpha);
+            expected = phfwdAdd(pf, num1, num2);
+            result = phfwdSharedAdd(shared, num1, num2);
+            assert(result == expected);
+
+            if (i % 10 == 0) {
+                testRandomNumber(&seed, num1, 1, MAX_LEN, alpha);
+                num1[1 + testRandom(&seed) % 3] = '\0';
+                phfwdRemove(pf, num1);
+                result = phfwdSharedRemove(shared, num1);
+                assert(result);
+            }
+
+            // nieudana modyfikacja wymusza uzgodnienie replik przy następnej.
+            if (i % 100 == 50) {
+                result = phfwdSharedAdd(shared, num2, num2);
+                assert(!result);
+            }
+
+            // zapytania między zmianami czytają na przemian obie repliki.
+            if (i % 1000 == 999)
+                compareShared(pf, shared, alpha);
+        }
+
+        phfwdSharedDelete(shared);
+        phfwdDelete(pf);
+    }
+
+    // Odczyty równoczesne z modyfikacjami widzą każdą zmianę w całości.
+    readShared = phfwdSharedNew();
+    assert(readShared != NULL);
+    result = phfwdSharedAdd(readShared, "1", "1000000") && phfwdSharedAdd(readShared, "2", "9");
+    assert(result);
+
+    pthread_t threads[READERS];
+
+    for (size_t i = 0; i < READERS; i++) {
+        int status = pthread_create(&threads[i], NULL, reader, NULL);
+
+        assert(status == 0);
+        (void) status;
+    }
+
+    for (int i = 1; i <= WRITES; i++) {
+        sprintf(num2, "%d", 1000000 + i);
+        result = phfwdSharedAdd(readShared, "1", num2);
+        assert(result);
+
+        // przekierowanie z innego numeru na 9 pojawia się i znika.
+        sprintf(num1, "3%d", i);
+        result = phfwdSharedAdd(readShared, num1, "9");
+        assert(result);
+        result = phfwdSharedRemove(readShared, num1);
+        assert(result);
+    }
+
+    atomic_store(&stop, true);
+
+    for (size_t i = 0; i < READERS; i++)
+        pthread_join(threads[i], NULL);
+
+    pnum = phfwdSharedGet(readShared, "1");
+    assert(strcmp(phnumGet(pnum, 0), num2) == 0);
+    phnumDelete(pnum);
+
+    phfwdSharedDelete(readShared);
+    (void) expected;
+    (void) result;
+
+    return 0;
+}
@@ -0,0 +1,446 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "phone_forward_snapshot.h"
+
+
+
+/** @brief Wyznacza rozmiar tablic zamrożonej struktury opisanej nagłówkiem.
+ * @param[in] header - wskaźnik na nagłówek zapisu.
+ * @return Łączny rozmiar tablic nodes, revs i labels.
+ */
+static uint64_t arraysSize(SnapshotHeader const *header) {
+    return (uint64_t) header->nodeCount * sizeof(FrozenNode) + (uint64_t) header->revCount * sizeof(uint32_t)
+           + header->labelBytes;
+}
+
+
+/** @brief Uwzględnia kolejne dane w sumie kontrolnej tablic.
+ * Suma jest liczona na 32-bitowych słowach jak suma Fletchera, ale modulo
+ * 2^64, więc sprawdzenie przebiega z szybkością odczytu pamięci. Niepełne
+ * ostatnie słowo jest dopełniane zerami, dlatego niepełne słowo mogą mieć
+ * tylko ostatnie dane.
+ * @param[in,out] sums - suma słów i suma sum częściowych, zerowe na początku;
+ * @param[in] data - wskaźnik na dane;
+ * @param[in] length - długość danych w bajtach.
+ */
+static void updateChecksum(uint64_t sums[2], void const *data, size_t length) {
+    uint8_t const *bytes = data;
+    uint64_t low = sums[0];
+    uint64_t high = sums[1];
+    uint32_t word;
+
+    for (size_t i = 0; i + sizeof(uint32_t) <= length; i += sizeof(uint32_t)) {
+        memcpy(&word, bytes + i, sizeof(uint32_t));
+        low += word;
+        high += low;
+    }
+
+    if (length % sizeof(uint32_t) != 0) {
+        word = 0;
+        memcpy(&word, bytes + length / sizeof(uint32_t) * sizeof(uint32_t), length % sizeof(uint32_t));
+        low += word;
+        high += low;
+    }
+
+    sums[0] = low;
+    sums[1] = high;
+}
+
+
+/** @brief Wyznacza sumę kontrolną tablic zamrożonej struktury.
+ * @param[in] frozen - wskaźnik na zamrożoną strukturę.
+ * @return Suma kontrolna tablic nodes, revs i labels.
+ */
+static uint64_t arraysChecksum(struct PhfwdFrozen const *frozen) {
+    uint64_t sums[2] = {0, 0};
+
+    updateChecksum(sums, frozen->nodes, (size_t) frozen->nodeCount * sizeof(FrozenNode));
+    updateChecksum(sums, frozen->revs, (size_t) frozen->revCount * sizeof(uint32_t));
+    updateChecksum(sums, frozen->labels, frozen->labelBytes);
+
+    return sums[0] ^ (sums[1] << 32 | sums[1] >> 32);
+}
+
+
+/** @brief Zaokrągla rozmiar w górę do wielokrotności SNAPSHOT_ALIGN.
+ * @param[in] size - rozmiar.
+ * @return Zaokrąglony rozmiar.
+ */
+static inline uint64_t alignSize(uint64_t size) {
+    return (size + SNAPSHOT_ALIGN - 1) / SNAPSHOT_ALIGN * SNAPSHOT_ALIGN;
+}
+
+
+bool snapshotPad(FILE *file, uint64_t written) {
+    static char const zeros[SNAPSHOT_ALIGN] = {0};
+    size_t padding = (size_t) (alignSize(written) - written);
+
+    return fwrite(zeros, 1, padding, file) == padding;
+}
+
+
+FILE * snapshotCreate(char const *path, char **tempPath) {
+    size_t pathLength = strlen(path);
+
+    (*tempPath) = malloc(pathLength + sizeof(".tmp"));
+
+    // problem z alokacją pamięci.
+    if ((*tempPath) == NULL)
+        return NULL;
+
+    memcpy((*tempPath), path, pathLength);
+    memcpy((*tempPath) + pathLength, ".tmp", sizeof(".tmp"));
+
+    FILE *file = fopen((*tempPath), "wb");
+
+    if (file == NULL) {
+        free(*tempPath);
+        (*tempPath) = NULL;
+    }
+
+    return file;
+}
+
+
+bool snapshotCommit(FILE *file, char *tempPath, char const *path, bool written) {
+    // dane muszą trafić na dysk, zanim plik zastąpi poprzedni.
+    bool result = written && fflush(file) == 0 && fsync(fileno(file)) == 0;
+
+    if (fclose(file) != 0)
+        result = false;
+
+    if (result)
+        result = rename(tempPath, path) == 0;
+    else remove(tempPath);
+
+    free(tempPath);
+
+    return result;
+}
+
+
+uint64_t phfwdSnapshotSize(struct PhfwdFrozen const *frozen) {
+    SnapshotHeader header;
+
+    header.nodeCount = frozen->nodeCount;
+    header.revCount = frozen->revCount;
+    header.labelBytes = frozen->labelBytes;
+
+    return alignSize(sizeof(SnapshotHeader) + arraysSize(&header));
+}
+
+
+bool phfwdSnapshotWrite(struct PhfwdFrozen const *frozen, FILE *file) {
+    if (frozen == NULL || file == NULL)
+        return false;
+
+    SnapshotHeader header;
+
+    memset(&header, 0, sizeof(SnapshotHeader));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byteOrder = SNAPSHOT_BYTE_ORDER;
+    header.nodeSize = sizeof(FrozenNode);
+    header.nodeCount = frozen->nodeCount;
+    header.revCount = frozen->revCount;
+    header.labelBytes = frozen->labelBytes;
+    header.checksum = arraysChecksum(frozen);
+
+    // tablice są zapisywane w takiej postaci, w jakiej leżą w pamięci.
+    return fwrite(&header, sizeof(SnapshotHeader), 1, file) == 1
+           && fwrite(frozen->nodes, sizeof(FrozenNode), frozen->nodeCount, file) == frozen->nodeCount
+           && fwrite(frozen->revs, sizeof(uint32_t), frozen->revCount, file) == frozen->revCount
+           && fwrite(frozen->labels, 1, frozen->labelBytes, file) == frozen->labelBytes
+           && snapshotPad(file, sizeof(SnapshotHeader) + arraysSize(&header));
+}
+
+
+/** @brief Sprawdza, czy nagłówek opisuje zgodny zapis mieszczący się w pliku.
+ * @param[in] header - wskaźnik na nagłówek zapisu;
+ * @param[in] offset - położenie zapisu w pliku;
+ * @param[in] fileSize - rozmiar pliku.
+ * @return Wartość @p true, jeśli zapis można odwzorować.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool checkHeader(SnapshotHeader const *header, uint64_t offset, uint64_t fileSize) {
+    if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0 || header->version != SNAPSHOT_VERSION
+        || header->byteOrder != SNAPSHOT_BYTE_ORDER || header->nodeSize != sizeof(FrozenNode))
+        return false;
+
+    // co najmniej NO_NODE, korzeń i strażnik.
+    if (header->nodeCount < ROOT_NODE + 2)
+        return false;
+
+    return offset + sizeof(SnapshotHeader) + arraysSize(header) <= fileSize;
+}
+
+
+/** @brief Sprawdza etykietę węzła odwzorowanej struktury.
+ * @param[in] frozen - wskaźnik na zamrożoną strukturę;
+ * @param[in] node - wskaźnik na węzeł;
+ * @param[in] first - cyfra, od której powinna zaczynać się etykieta.
+ * @return Wartość @p true, jeśli etykieta mieści się w tablicy labels
+ *         i składa się z cyfr, a pierwsza z nich jest równa @p first.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool checkLabel(struct PhfwdFrozen const *frozen, FrozenNode const *node, int first) {
+    size_t bytes = (size_t) (node->labelLen + 1) / 2;
+    uint8_t const *label = node->label;
+
+    if (node->labelLen == 0 || node->labelLen > LABEL_MAX)
+        return false;
+
+    if (node->labelLen > FROZEN_INLINE) {
+        if (node->labelStart > frozen->labelBytes || bytes > frozen->labelBytes - node->labelStart)
+            return false;
+
+        label = frozen->labels + node->labelStart;
+    }
+
+    if ((label[0] & 0xF) != first)
+        return false;
+
+    for (int p = 1; p < node->labelLen; p++) {
+        if (((label[p >> 1] >> ((p & 1) << 2)) & 0xF) >= DIGITS)
+            return false;
+    }
+
+    return true;
+}
+
+
+/** @brief Sprawdza, czy węzły odwzorowanej struktury tworzą drzewo.
+ * Każdy indeks musi wskazywać węzeł struktury, synowie muszą leżeć
+ * w kolejności przejścia wszerz, tablice rev muszą być kolejnymi
+ * przedziałami tablicy revs, a etykiety muszą mieścić się w tablicy labels.
+ * @param[in] frozen - wskaźnik na zamrożoną strukturę;
+ * @param[out] targets - liczba węzłów, które mają przekierowanie.
+ * @return Wartość @p true, jeśli węzły tworzą drzewo.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool checkTree(struct PhfwdFrozen const *frozen, uint32_t *targets) {
+    FrozenNode const *nodes = frozen->nodes;
+    uint32_t sentinel = frozen->nodeCount - 1;
+    FrozenNode const *root = &nodes[ROOT_NODE];
+    // kolejni synowie w kolejności przejścia dostają kolejne indeksy.
+    uint32_t nextChild = ROOT_NODE + 1;
+
+    (*targets) = 0;
+
+    if (root->parent != NO_NODE || root->labelLen != 0 || root->depth != 0 || root->revStart != 0
+        || nodes[sentinel].revStart != frozen->revCount)
+        return false;
+
+    for (uint32_t i = ROOT_NODE; i < sentinel; i++) {
+        FrozenNode const *node = &nodes[i];
+        uint32_t child = node->firstChild;
+
+        if (child != nextChild || node->childMask >> DIGITS != 0 || node->revStart > nodes[i + 1].revStart
+            || (node->target != NO_NODE && (node->target <= ROOT_NODE || node->target >= sentinel)))
+            return false;
+
+        if (node->target != NO_NODE)
+            (*targets)++;
+
+        nextChild += (uint32_t) __builtin_popcount(node->childMask);
+
+        // syn nie może być strażnikiem, więc indeksy nie przekroczą tablicy.
+        if (nextChild > sentinel)
+            return false;
+
+        for (int x = 0; x < DIGITS; x++) {
+            if (!(node->childMask & (1u << x)))
+                continue;
+
+            FrozenNode const *next = &nodes[child++];
+
+            // głębokość nie może się przekręcić, bo ogranicza rozmiar buforów.
+            if (next->parent != i || !checkLabel(frozen, next, x) || next->depth < next->labelLen
+                || next->depth != node->depth + next->labelLen)
+                return false;
+        }
+    }
+
+    // każdy węzeł poza korzeniem i strażnikiem jest czyimś synem.
+    return nextChild == sentinel;
+}
+
+
+/** @brief Sprawdza tablice rev i pola minRevDepth odwzorowanej struktury.
+ * Tablica rev węzła musi zawierać dokładnie węzły przekierowane na niego,
+ * posortowane według reprezentowanych numerów, tak jak w strukturze
+ * modyfikowalnej. Numery porównywane są przez pozycje węzłów w kolejności
+ * przejścia w głąb, wyznaczane z rozmiarów poddrzew.
+ * @param[in] frozen - wskaźnik na zamrożoną strukturę tworzącą drzewo;
+ * @param[in] targets - liczba węzłów, które mają przekierowanie;
+ * @param[in] rank - tablica na nodeCount liczb.
+ * @return Wartość @p true, jeśli tablice są spójne.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+static bool checkReverse(struct PhfwdFrozen const *frozen, uint32_t targets, uint32_t *rank) {
+    FrozenNode const *nodes = frozen->nodes;
+    uint32_t sentinel = frozen->nodeCount - 1;
+
+    if (targets != frozen->revCount)
+        return false;
+
+    // synowie mają większe indeksy niż ojciec, więc są sprawdzani wcześniej.
+    for (uint32_t i = sentinel - 1; i >= ROOT_NODE; i--) {
+        FrozenNode const *node = &nodes[i];
+        uint32_t minRevDepth = nodes[i + 1].revStart > node->revStart ? node->depth : NO_REVERSE;
+        uint32_t child = node->firstChild;
+
+        rank[i] = 1;
+
+        for (int x = 0; x < __builtin_popcount(node->childMask); x++, child++) {
+            rank[i] += rank[child];
+
+            if (nodes[child].minRevDepth < minRevDepth)
+                minRevDepth = nodes[child].minRevDepth;
+        }
+
+        if (node->minRevDepth != minRevDepth)
+            return false;
+    }
+
+    // rozmiary poddrzew zamieniane są na pozycje w kolejności przejścia w głąb.
+    rank[ROOT_NODE] = 0;
+
+    for (uint32_t i = ROOT_NODE; i < sentinel; i++) {
+        FrozenNode const *node = &nodes[i];
+        uint32_t position = rank[i] + 1;
+        uint32_t child = node->firstChild;
+
+        for (int x = 0; x < __builtin_popcount(node->childMask); x++, child++) {
+            uint32_t size = rank[child];
+
+            rank[child] = position;
+            position += size;
+        }
+    }
+
+    for (uint32_t i = ROOT_NODE; i < sentinel; i++) {
+        FrozenNode const *node = &nodes[i];
+
+        // numery w tablicy rev rosną, więc węzły się nie powtarzają.
+        for (uint32_t j = node->revStart; j < nodes[i + 1].revStart; j++) {
+            uint32_t source = frozen->revs[j];
+
+            if (source <= ROOT_NODE || source >= sentinel || nodes[source].target != i
+                || (j > node->revStart && rank[frozen->revs[j - 1]] >= rank[source]))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+
+bool phfwdSnapshotValidate(struct PhfwdFrozen const *frozen) {
+    uint32_t targets;
+
+    if (frozen == NULL || frozen->nodeCount < ROOT_NODE + 2 || !checkTree(frozen, &targets))
+        return false;
+
+    uint32_t *rank = malloc(frozen->nodeCount * sizeof(uint32_t));
+    bool result = rank != NULL && checkReverse(frozen, targets, rank);
+
+    free(rank);
+
+    return result;
+}
+
+
+struct PhfwdFrozen * phfwdSnapshotMap(int fd, uint64_t offset, uint64_t *size) {
+    SnapshotHeader header;
+    struct stat info;
+
+    if (offset % SNAPSHOT_ALIGN != 0 || fstat(fd, &info) != 0
+        || pread(fd, &header, sizeof(SnapshotHeader), (off_t) offset) != (ssize_t) sizeof(SnapshotHeader)
+        || !checkHeader(&header, offset, (uint64_t) info.st_size))
+        return NULL;
+
+    struct PhfwdFrozen *frozen = malloc(sizeof(struct PhfwdFrozen));
+
+    // problem z alokacją pamięci.
+    if (frozen == NULL)
+        return NULL;
+
+    // odwzorowanie musi zaczynać się na granicy strony.
+    uint64_t page = (uint64_t) sysconf(_SC_PAGESIZE);
+    uint64_t start = offset - offset % page;
+    uint64_t dataStart = offset + sizeof(SnapshotHeader);
+
+    frozen->mappingSize = (size_t) (dataStart + arraysSize(&header) - start);
+    frozen->mapping = mmap(NULL, frozen->mappingSize, PROT_READ, MAP_PRIVATE, fd, (off_t) start);
+
+    if (frozen->mapping == MAP_FAILED) {
+        free(frozen);
+        return NULL;
+    }
+
+    char const *data = (char const*) frozen->mapping + (dataStart - start);
+
+    frozen->nodes = (FrozenNode const*) data;
+    frozen->revs = (uint32_t const*) (data + (size_t) header.nodeCount * sizeof(FrozenNode));
+    frozen->labels = (uint8_t const*) frozen->revs + (size_t) header.revCount * sizeof(uint32_t);
+    frozen->nodeCount = header.nodeCount;
+    frozen->revCount = header.revCount;
+    frozen->labelBytes = (size_t) header.labelBytes;
+    frozen->block = NULL;
+
+    // przypadkowe uszkodzenie pliku zmienia sumę kontrolną.
+    if (arraysChecksum(frozen) != header.checksum) {
+        phfwdFrozenDelete(frozen);
+        return NULL;
+    }
+
+    (*size) = alignSize(sizeof(SnapshotHeader) + arraysSize(&header));
+
+    return frozen;
+}
+
+
+bool phfwdSnapshotSave(struct PhoneForward const *pf, char const *path) {
+    if (pf == NULL || path == NULL)
+        return false;
+
+    struct PhfwdFrozen *frozen = phfwdFreeze(pf);
+
+    // problem z alokacją pamięci.
+    if (frozen == NULL)
+        return false;
+
+    char *tempPath;
+    FILE *file = snapshotCreate(path, &tempPath);
+    bool result = file != NULL && snapshotCommit(file, tempPath, path, phfwdSnapshotWrite(frozen, file));
+
+    phfwdFrozenDelete(frozen);
+
+    return result;
+}
+
+
+struct PhfwdFrozen * phfwdSnapshotOpen(char const *path) {
+    if (path == NULL)
+        return NULL;
+
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0)
+        return NULL;
+
+    uint64_t size;
+    struct PhfwdFrozen *frozen = phfwdSnapshotMap(fd, 0, &size);
+
+    // odwzorowanie pozostaje ważne po zamknięciu pliku.
+    close(fd);
+
+    return frozen;
+}
@@ -0,0 +1,143 @@
+/** @file
+ * Interfejs binarnego zapisu zamrożonej struktury przekierowań
+ *
+ * Plik zawiera nagłówek i tablice zamrożonej struktury w postaci, w jakiej
+ * leżą w pamięci, więc otwarcie pliku polega na odwzorowaniu go w pamięć,
+ * bez wczytywania i alokowania węzłów. Zapytania działają bezpośrednio
+ * na odwzorowanym pliku.
+ * Pliki są przenośne tylko między komputerami o tej samej kolejności bajtów,
+ * niezgodny plik jest odrzucany przy otwieraniu. Przy otwieraniu sprawdzana
+ * jest suma kontrolna tablic, która wykrywa przypadkowe uszkodzenie pliku.
+ * Pełne sprawdzenie spójności tablic, po którym także celowo spreparowany
+ * plik nie spowoduje odczytu spoza nich, wykonuje na żądanie funkcja
+ * @ref phfwdSnapshotValidate.
+ */
+
+#ifndef _PHONE_FORWARD_SNAPSHOT_H
+#define _PHONE_FORWARD_SNAPSHOT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "phone_forward.h"
+
+/// Znacznik początku zapisu struktury przekierowań.
+#define SNAPSHOT_MAGIC      "PFWDSNAP"
+/// Wersja formatu zapisu.
+#define SNAPSHOT_VERSION    2
+/// Wartość zapisywana w celu wykrycia niezgodnej kolejności bajtów.
+#define SNAPSHOT_BYTE_ORDER 0x01020304u
+/// Wyrównanie kolejnych części pliku.
+#define SNAPSHOT_ALIGN      8
+
+/**
+ * Nagłówek zapisu zamrożonej struktury przekierowań. Zaraz po nim leżą
+ * tablice nodes, revs i labels, a całość jest dopełniona zerami
+ * do wielokrotności SNAPSHOT_ALIGN.
+ */
+struct snapshotHeader;
+
+typedef struct snapshotHeader SnapshotHeader;
+
+struct snapshotHeader {
+    char magic[8]; // znacznik SNAPSHOT_MAGIC.
+    uint32_t version; // wersja formatu.
+    uint32_t byteOrder; // wartość SNAPSHOT_BYTE_ORDER.
+    uint32_t nodeSize; // rozmiar węzła zamrożonej struktury.
+    uint32_t nodeCount; // liczba elementów tablicy nodes.
+    uint32_t revCount; // liczba elementów tablicy revs.
+    uint32_t unused; // wyrównanie do 8 bajtów.
+    uint64_t labelBytes; // liczba bajtów tablicy labels.
+    uint64_t checksum; // suma kontrolna tablic nodes, revs i labels.
+};
+
+/** @brief Wyznacza rozmiar zapisu zamrożonej struktury.
+ * @param[in] frozen – wskaźnik na zamrożoną strukturę.
+ * @return Liczbę bajtów zapisywanych przez funkcję @ref phfwdSnapshotWrite.
+ */
+uint64_t phfwdSnapshotSize(struct PhfwdFrozen const *frozen);
+
+/** @brief Zapisuje zamrożoną strukturę do pliku.
+ * Zapis zaczyna się w bieżącym miejscu pliku, które powinno być wyrównane
+ * do SNAPSHOT_ALIGN względem początku pliku.
+ * @param[in] frozen – wskaźnik na zamrożoną strukturę;
+ * @param[in,out] file – plik otwarty do zapisu binarnego.
+ * @return Wartość @p true, jeśli zapis się udał.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool phfwdSnapshotWrite(struct PhfwdFrozen const *frozen, FILE *file);
+
+/** @brief Odwzorowuje w pamięć zapis zamrożonej struktury.
+ * Sprawdza nagłówek i sumę kontrolną tablic, ale nie ich spójność
+ * (zob. @ref phfwdSnapshotValidate).
+ * @param[in] fd – deskryptor pliku otwartego do odczytu, można go zamknąć
+ *                 po zakończeniu funkcji;
+ * @param[in] offset – położenie zapisu w pliku, wyrównane do SNAPSHOT_ALIGN;
+ * @param[out] size – rozmiar zapisu w pliku.
+ * @return Wskaźnik na zamrożoną strukturę lub NULL, gdy zapis jest niezgodny
+ *         lub uszkodzony albo nie udało się odwzorować pliku.
+ */
+struct PhfwdFrozen * phfwdSnapshotMap(int fd, uint64_t offset, uint64_t *size);
+
+/** @brief Sprawdza spójność tablic zamrożonej struktury.
+ * Sprawdzenie przechodzi całe drzewo i alokuje pamięć proporcjonalną
+ * do liczby węzłów, więc jest wykonywane tylko na żądanie, np. dla plików
+ * z niezaufanego źródła. Po nim zapytania nie wyjdą poza tablice, zaś
+ * rozmrożona struktura spełni niezmienniki struktury modyfikowalnej.
+ * @param[in] frozen – wskaźnik na zamrożoną strukturę.
+ * @return Wartość @p true, jeśli tablice są spójne.
+ *         Wartość @p false w przeciwnym przypadku, gdy @p frozen jest NULL
+ *         lub w przypadku problemów z alokacją pamięci.
+ */
+bool phfwdSnapshotValidate(struct PhfwdFrozen const *frozen);
+
+/** @brief Zapisuje strukturę przekierowań do nowego pliku.
+ * Zapis trafia najpierw do pliku tymczasowego, który po utrwaleniu na dysku
+ * zastępuje plik @p path, więc przerwany zapis nie niszczy poprzedniego.
+ * @param[in] pf – wskaźnik na strukturę przechowującą przekierowania numerów;
+ * @param[in] path – ścieżka pliku.
+ * @return Wartość @p true, jeśli zapis się udał.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool phfwdSnapshotSave(struct PhoneForward const *pf, char const *path);
+
+/** @brief Otwiera plik zapisany funkcją @ref phfwdSnapshotSave.
+ * Strukturę usuwa się funkcją @ref phfwdFrozenDelete.
+ * @param[in] path – ścieżka pliku.
+ * @return Wskaźnik na zamrożoną strukturę odwzorowaną z pliku lub NULL,
+ *         gdy nie udało się otworzyć pliku lub jest on niezgodny lub uszkodzony.
+ */
+struct PhfwdFrozen * phfwdSnapshotOpen(char const *path);
+
+/** @brief Otwiera plik tymczasowy, który zastąpi plik o podanej ścieżce.
+ * @param[in] path – ścieżka pliku docelowego;
+ * @param[out] tempPath – ścieżka pliku tymczasowego, do zwolnienia przez
+ *                        funkcję @ref snapshotCommit.
+ * @return Plik otwarty do zapisu binarnego lub NULL, gdy nie udało się go
+ *         utworzyć.
+ */
+FILE * snapshotCreate(char const *path, char **tempPath);
+
+/** @brief Kończy zapis pliku otwartego funkcją @ref snapshotCreate.
+ * Jeśli zapis się udał, utrwala plik tymczasowy na dysku i zastępuje nim
+ * plik docelowy, więc przerwany zapis nie niszczy poprzedniego pliku.
+ * W przeciwnym przypadku usuwa plik tymczasowy.
+ * @param[in] file – plik tymczasowy;
+ * @param[in] tempPath – ścieżka pliku tymczasowego, zwalniana przez funkcję;
+ * @param[in] path – ścieżka pliku docelowego;
+ * @param[in] written – czy cała zawartość została zapisana.
+ * @return Wartość @p true, jeśli plik docelowy został zastąpiony.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool snapshotCommit(FILE *file, char *tempPath, char const *path, bool written);
+
+/** @brief Zapisuje zera dopełniające zapis do wielokrotności SNAPSHOT_ALIGN.
+ * @param[in,out] file – plik otwarty do zapisu;
+ * @param[in] written – liczba bajtów zapisu przed dopełnieniem.
+ * @return Wartość @p true, jeśli się udało.
+ *         Wartość @p false w przeciwnym przypadku.
+ */
+bool snapshotPad(FILE *file, uint64_t written);
+
+#endif /* _PHONE_FORWARD_SNAPSHOT_H */
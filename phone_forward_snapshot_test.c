@@ -0,0 +1,279 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "phone_forward.h"
+#include "phone_forward_snapshot.h"
+#include "phone_forward_testing.h"
+
+/// Ścieżka pliku z zapisanymi strukturami.
+#define SNAPSHOT_PATH "phone_forward_snapshot_test.bin"
+/// Liczba losowych przekierowań.
+#define FORWARDS      20000
+/// Liczba losowych zapytań jednego porównania.
+#define QUERIES       4000
+/// Największa długość numerów.
+#define MAX_LEN       20
+
+static unsigned long long seed = TEST_SEED; ///< stan generatora liczb pseudolosowych.
+
+/** @brief Porównuje strukturę odczytaną z pliku z modyfikowalną na losowych zapytaniach.
+ * @param[in] pf     – wskaźnik na strukturę modyfikowalną;
+ * @param[in] frozen – wskaźnik na strukturę odczytaną z pliku;
+ * @param[in] alpha  – liczba używanych cyfr.
+ */
+static void compareSnapshot(struct PhoneForward *pf, struct PhfwdFrozen const *frozen, size_t alpha) {
+    char num[MAX_LEN + 1];
+
+    for (size_t i = 0; i < QUERIES; i++) {
+        testRandomNumber(&seed, num, 1, MAX_LEN, alpha);
+        testAssertSame(phfwdGet(pf, num), phfwdFrozenGet(frozen, num));
+        testAssertSame(phfwdReverse(pf, num), phfwdFrozenReverse(frozen, num));
+    }
+
+    for (size_t len = 0; len <= 12; len += 3)
+        assert(phfwdFrozenNonTrivialCount(frozen, TEST_DIGITS, len) == phfwdNonTrivialCount(pf, TEST_DIGITS, len));
+}
+
+/** @brief Tworzy strukturę z losowych przekierowań, z których część jest usunięta.
+ * @param[in] alpha – liczba używanych cyfr.
+ * @return Wskaźnik na utworzoną strukturę.
+ */
+static struct PhoneForward * randomBase(size_t alpha) {
+    char num1[MAX_LEN + 1], num2[MAX_LEN + 1];
+    struct PhoneForward *pf = phfwdNew();
+
+    assert(pf != NULL);
+
+    for (size_t i = 0; i < FORWARDS; i++) {
+        testRandomNumber(&seed, num1, 1, MAX_LEN, alpha);
+        testRandomNumber(&seed, num2, 1, MAX_LEN, alpha);
+        phfwdAdd(pf, num1, num2);
+    }
+
+    for (size_t i = 0; i < FORWARDS / 50; i++) {
+        testRandomNumber(&seed, num1, 1, MAX_LEN, alpha);
+        phfwdRemove(pf, num1);
+    }
+
+    return pf;
+}
+
+/** @brief Nadpisuje fragment pliku.
+ * @param[in] data   – wskaźnik na zapisywane bajty;
+ * @param[in] count  – liczba zapisywanych bajtów;
+ * @param[in] offset – położenie fragmentu w pliku.
+ */
+static void writeAt(void const *data, size_t count, long offset) {
+    FILE *file = fopen(SNAPSHOT_PATH, "r+b");
+
+    assert(file != NULL);
+
+    int status = fseek(file, offset, SEEK_SET);
+
+    assert(status == 0);
+
+    size_t written = fwrite(data, 1, count, file);
+
+    assert(written == count);
+    status = fclose(file);
+    assert(status == 0);
+    (void) status;
+    (void) written;
+}
+
+/** @brief Porównuje struktury odczytane z pliku z zapisanymi i sprawdza
+ * odrzucanie uszkodzonych plików.
+ * @return Zero.
+ */
+int main() {
+    struct PhoneForward *pf, *other;
+    struct PhfwdFrozen *frozen;
+    struct PhoneNumbers const *pnum;
+    bool result;
+
+    // Pusta baza.
+    pf = phfwdNew();
+    result = phfwdSnapshotSave(pf, SNAPSHOT_PATH);
+    assert(result);
+    frozen = phfwdSnapshotOpen(SNAPSHOT_PATH);
+    assert(frozen != NULL);
+
+    pnum = phfwdFrozenGet(frozen, "123");
+    assert(phnumCount(pnum) == 1 && strcmp(phnumGet(pnum, 0), "123") == 0);
+    phnumDelete(pnum);
+    assert(phfwdFrozenNonTrivialCount(frozen, "0123456789", 5) == 0);
+
+    phfwdFrozenDelete(frozen);
+    phfwdDelete(pf);
+
+    // Pełny alfabet daje szerokie drzewo, dwie cyfry - głębokie.
+    for (size_t alpha = 12; alpha >= 2; alpha /= 2) {
+        pf = randomBase(alpha);
+        result = phfwdSnapshotSave(pf, SNAPSHOT_PATH);
+        assert(result);
+
+        // Odwzorowanie pozostaje ważne, gdy plik zostanie nadpisany.
+        frozen = phfwdSnapshotOpen(SNAPSHOT_PATH);
+        assert(frozen != NULL);
+        other = phfwdNew();
+        result = phfwdSnapshotSave(other, SNAPSHOT_PATH);
+        assert(result);
+        compareSnapshot(pf, frozen, alpha);
+
+        result = phfwdSnapshotValidate(frozen);
+        assert(result);
+
+        phfwdFrozenDelete(frozen);
+        phfwdDelete(other);
+        phfwdDelete(pf);
+    }
+
+    // Dwa zapisy w jednym pliku, drugi od wyrównanego położenia.
+    pf = randomBase(10);
+    other = randomBase(4);
+
+    struct PhfwdFrozen *first = phfwdFreeze(pf);
+    struct PhfwdFrozen *second = phfwdFreeze(other);
+    FILE *file = fopen(SNAPSHOT_PATH, "wb");
+
+    assert(first != NULL && second != NULL && file != NULL);
+
+    result = phfwdSnapshotWrite(first, file) && phfwdSnapshotWrite(second, file);
+    assert(result);
+
+    int status = fclose(file);
+
+    assert(status == 0);
+
+    uint64_t offset = phfwdSnapshotSize(first);
+    uint64_t size;
+
+    assert(offset % SNAPSHOT_ALIGN == 0);
+
+    int fd = open(SNAPSHOT_PATH, O_RDONLY);
+
+    assert(fd >= 0);
+
+    frozen = phfwdSnapshotMap(fd, 0, &size);
+    assert(frozen != NULL && size == offset);
+    compareSnapshot(pf, frozen, 10);
+    phfwdFrozenDelete(frozen);
+
+    frozen = phfwdSnapshotMap(fd, offset, &size);
+    assert(frozen != NULL && size == phfwdSnapshotSize(second));
+    compareSnapshot(other, frozen, 4);
+    phfwdFrozenDelete(frozen);
+
+    // Niewyrównane położenie i położenie za końcem pliku są odrzucane.
+    frozen = phfwdSnapshotMap(fd, offset + 1, &size);
+    assert(frozen == NULL);
+    frozen = phfwdSnapshotMap(fd, offset + size, &size);
+    assert(frozen == NULL);
+    close(fd);
+
+    phfwdFrozenDelete(first);
+    phfwdFrozenDelete(second);
+    phfwdDelete(other);
+
+    // Uszkodzone pliki są odrzucane.
+    result = phfwdSnapshotSave(pf, SNAPSHOT_PATH);
+    assert(result);
+
+    // zły znacznik.
+    writeAt("PFWDSNAQ", 8, 0);
+    frozen = phfwdSnapshotOpen(SNAPSHOT_PATH);
+    assert(frozen == NULL);
+
+    // niezgodna kolejność bajtów.
+    writeAt(SNAPSHOT_MAGIC, 8, 0);
+
+    uint32_t byteOrder = 0x04030201u;
+
+    writeAt(&byteOrder, sizeof(byteOrder), (long) offsetof(SnapshotHeader, byteOrder));
+    frozen = phfwdSnapshotOpen(SNAPSHOT_PATH);
+    assert(frozen == NULL);
+
+    // po przywróceniu nagłówka plik znów jest poprawny.
+    byteOrder = SNAPSHOT_BYTE_ORDER;
+    writeAt(&byteOrder, sizeof(byteOrder), (long) offsetof(SnapshotHeader, byteOrder));
+    frozen = phfwdSnapshotOpen(SNAPSHOT_PATH);
+    assert(frozen != NULL);
+    phfwdFrozenDelete(frozen);
+
+    // węzeł wskazujący poza tablice zmienia sumę kontrolną.
+    FrozenNode node;
+
+    memset(&node, 0xFF, sizeof(node));
+    writeAt(&node, sizeof(node), (long) (sizeof(SnapshotHeader) + 5 * sizeof(FrozenNode)));
+    frozen = phfwdSnapshotOpen(SNAPSHOT_PATH);
+    assert(frozen == NULL);
+
+    // tak samo jak pojedynczy bit ostatniego bajtu tablic.
+    result = phfwdSnapshotSave(pf, SNAPSHOT_PATH);
+    assert(result);
+    frozen = phfwdSnapshotOpen(SNAPSHOT_PATH);
+    assert(frozen != NULL && frozen->labelBytes > 0);
+
+    long last = (long) (sizeof(SnapshotHeader) + (size_t) frozen->nodeCount * sizeof(FrozenNode)
+                        + (size_t) frozen->revCount * sizeof(uint32_t) + frozen->labelBytes - 1);
+    uint8_t byte = frozen->labels[frozen->labelBytes - 1];
+
+    phfwdFrozenDelete(frozen);
+    byte ^= 0x10;
+    writeAt(&byte, 1, last);
+    frozen = phfwdSnapshotOpen(SNAPSHOT_PATH);
+    assert(frozen == NULL);
+
+    // liczba węzłów większa niż plik.
+    uint32_t nodeCount = UINT32_MAX / 2;
+
+    writeAt(&nodeCount, sizeof(nodeCount), (long) offsetof(SnapshotHeader, nodeCount));
+    frozen = phfwdSnapshotOpen(SNAPSHOT_PATH);
+    assert(frozen == NULL);
+
+    // ucięty plik.
+    result = phfwdSnapshotSave(pf, SNAPSHOT_PATH);
+    assert(result);
+    status = truncate(SNAPSHOT_PATH, (off_t) (offset - SNAPSHOT_ALIGN));
+    assert(status == 0);
+    frozen = phfwdSnapshotOpen(SNAPSHOT_PATH);
+    assert(frozen == NULL);
+
+    // Pełne sprawdzenie odrzuca węzeł wskazujący poza tablice, nawet gdy suma
+    // kontrolna się zgadza.
+    first = phfwdFreeze(pf);
+    assert(first != NULL);
+    result = phfwdSnapshotValidate(first);
+    assert(result);
+
+    FrozenNode *nodes = malloc((size_t) first->nodeCount * sizeof(FrozenNode));
+    struct PhfwdFrozen damaged = *first;
+
+    assert(nodes != NULL);
+    memcpy(nodes, first->nodes, (size_t) first->nodeCount * sizeof(FrozenNode));
+    nodes[5] = node;
+    damaged.nodes = nodes;
+    result = phfwdSnapshotValidate(&damaged);
+    assert(!result);
+    result = phfwdSnapshotValidate(NULL);
+    assert(!result);
+
+    free(nodes);
+    phfwdFrozenDelete(first);
+
+    // Brak pliku.
+    remove(SNAPSHOT_PATH);
+    frozen = phfwdSnapshotOpen(SNAPSHOT_PATH);
+    assert(frozen == NULL);
+
+    phfwdDelete(pf);
+    (void) result;
+    (void) status;
+
+    return 0;
+}
@@ -0,0 +1,150 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "phone_forward.h"
+#include "phone_forward_testing.h"
+
+/// Liczba losowych przekierowań.
+#define FORWARDS 20000
+/// Liczba numerów w jednym zapytaniu zbiorczym.
+#define BATCH    3000
+/// Największa długość numerów.
+#define MAX_LEN  16
+
+static unsigned long long seed = TEST_SEED; ///< stan generatora liczb pseudolosowych.
+static char numbers[BATCH][MAX_LEN + 1]; ///< numery zapytania zbiorczego.
+static char const *nums[BATCH]; ///< wskaźniki na numery zapytania zbiorczego.
+
+/** @brief Porównuje napisy dla funkcji qsort.
+ * @param[in] a – wskaźnik na wskaźnik na pierwszy napis;
+ * @param[in] b – wskaźnik na wskaźnik na drugi napis.
+ * @return Wynik funkcji strcmp dla obu napisów.
+ */
+static int compareStrings(void const *a, void const *b) {
+    return strcmp(*(char const * const *) a, *(char const * const *) b);
+}
+
+/** @brief Porównuje wyniki obu funkcji zbiorczych z pojedynczymi zapytaniami.
+ * @param[in] pf   – wskaźnik na strukturę przekierowań;
+ * @param[in] nums – tablica numerów;
+ * @param[in] n    – liczba numerów.
+ */
+static void compareBatch(struct PhoneForward *pf, char const * const *nums, size_t n) {
+    static struct PhoneNumbers const *out[BATCH];
+    bool result;
+
+    result = phfwdGetSorted(pf, nums, n, out);
+    assert(result);
+
+    for (size_t i = 0; i < n; i++)
+        testAssertSame(phfwdGet(pf, nums[i]), out[i]);
+
+    result = phfwdReverseSorted(pf, nums, n, out);
+    assert(result);
+
+    for (size_t i = 0; i < n; i++)
+        testAssertSame(phfwdReverse(pf, nums[i]), out[i]);
+
+    (void) result;
+}
+
+/** @brief Losuje zapytanie zbiorcze.
+ * Część numerów to przedłużenia lub powtórzenia wcześniejszych, a część
+ * nie jest numerami.
+ * @param[in] alpha – liczba używanych cyfr.
+ */
+static void randomBatch(size_t alpha) {
+    for (size_t i = 0; i < BATCH; i++) {
+        unsigned kind = (unsigned) (testRandom(&seed) % 10);
+
+        if (i > 0 && kind < 3) {
+            strcpy(numbers[i], numbers[testRandom(&seed) % i]);
+            size_t len = strlen(numbers[i]);
+
+            if (len < MAX_LEN) {
+                numbers[i][len] = TEST_DIGITS[testRandom(&seed) % alpha];
+                numbers[i][len + 1] = '\0';
+            }
+        }
+        else if (i > 0 && kind < 5) {
+            strcpy(numbers[i], numbers[testRandom(&seed) % i]);
+        }
+        else if (kind == 5) {
+            testRandomNumber(&seed, numbers[i], 1, MAX_LEN, alpha);
+            numbers[i][testRandom(&seed) % strlen(numbers[i])] = testRandom(&seed) % 2 ? 'x' : '\0';
+        }
+        else {
+            testRandomNumber(&seed, numbers[i], 1, MAX_LEN, alpha);
+        }
+
+        nums[i] = numbers[i];
+    }
+}
+
+/** @brief Porównuje phfwdGetSorted i phfwdReverseSorted z phfwdGet i phfwdReverse.
+ * @return Zero.
+ */
+int main() {
+    char num1[MAX_LEN + 1], num2[MAX_LEN + 1];
+    struct PhoneForward *pf = phfwdNew();
+    struct PhoneNumbers const *out[4];
+    bool result;
+
+    // Pusta baza i pusta tablica zapytań.
+    assert(pf != NULL);
+    result = phfwdGetSorted(pf, nums, 0, out) && phfwdReverseSorted(pf, nums, 0, out);
+    assert(result);
+
+    char const *invalid[] = {"12345", "", "1a", "12345"};
+
+    compareBatch(pf, invalid, 4);
+
+    // Przykład z phone_forward_example.c.
+    phfwdAdd(pf, "123", "9");
+    phfwdAdd(pf, "123456", "777777");
+    phfwdAdd(pf, "567", "0");
+    phfwdAdd(pf, "5678", "08");
+
+    char const *queries[] = {"123456", "12345", "08", "1", "5678", "997", "12"};
+
+    compareBatch(pf, queries, 7);
+    compareBatch(pf, invalid, 4);
+
+    phfwdRemove(pf, "12");
+    compareBatch(pf, queries, 7);
+    phfwdDelete(pf);
+
+    // Pełny alfabet daje szerokie drzewo, trzy cyfry - głębokie.
+    for (size_t alpha = 12; alpha >= 3; alpha /= 2) {
+        pf = phfwdNew();
+        assert(pf != NULL);
+
+        for (size_t i = 0; i < FORWARDS; i++) {
+            testRandomNumber(&seed, num1, 1, MAX_LEN, alpha);
+            testRandomNumber(&seed, num2, 1, MAX_LEN, alpha);
+            phfwdAdd(pf, num1, num2);
+        }
+
+        randomBatch(alpha);
+        compareBatch(pf, nums, BATCH);
+
+        // zapytania już uporządkowane.
+        qsort(nums, BATCH, sizeof(char const *), compareStrings);
+        compareBatch(pf, nums, BATCH);
+
+        // Po usunięciu części przekierowań wyniki nadal się zgadzają.
+        for (size_t i = 0; i < FORWARDS / 50; i++) {
+            testRandomNumber(&seed, num1, 1, 4, alpha);
+            phfwdRemove(pf, num1);
+        }
+
+        randomBatch(alpha);
+        compareBatch(pf, nums, BATCH);
+        phfwdDelete(pf);
+    }
+
+    (void) result;
+
+    return 0;
+}
@@ -0,0 +1,47 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <string.h>
+#include <time.h>
+#include "phone_forward_testing.h"
+
+
+
+unsigned long long testRandom(unsigned long long *seed) {
+    (*seed) ^= (*seed) << 13;
+    (*seed) ^= (*seed) >> 7;
+    (*seed) ^= (*seed) << 17;
+
+    return *seed;
+}
+
+
+void testRandomNumber(unsigned long long *seed, char *num, size_t minLen, size_t maxLen, size_t alpha) {
+    size_t len = minLen + (size_t) (testRandom(seed) % (maxLen - minLen + 1));
+
+    for (size_t i = 0; i < len; i++)
+        num[i] = TEST_DIGITS[testRandom(seed) % alpha];
+
+    num[len] = '\0';
+}
+
+
+void testAssertSame(struct PhoneNumbers const *expected, struct PhoneNumbers const *pnum) {
+    assert(expected != NULL && pnum != NULL);
+    assert(phnumCount(expected) == phnumCount(pnum));
+
+    for (size_t i = 0; i < phnumCount(expected); i++)
+        assert(strcmp(phnumGet(expected, i), phnumGet(pnum, i)) == 0);
+
+    phnumDelete(expected);
+    phnumDelete(pnum);
+}
+
+
+double testNow(void) {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+
+    return (double) t.tv_sec * 1e3 + (double) t.tv_nsec / 1e6;
+}
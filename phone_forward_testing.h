@@ -0,0 +1,48 @@
+/** @file
+ * Interfejs funkcji pomocniczych programów testujących i mierzących
+ * struktury przekierowań
+ *
+ * Programy testujące porównują wyniki różnych struktur na tych samych
+ * losowych numerach, a programy mierzące czas losują nimi dane.
+ */
+
+#ifndef _PHONE_FORWARD_TESTING_H
+#define _PHONE_FORWARD_TESTING_H
+
+#include <stddef.h>
+#include "phone_forward.h"
+
+/// Początkowy stan generatora liczb pseudolosowych.
+#define TEST_SEED   88172645463325252ull
+/// Znaki numerów uporządkowane tak jak cyfry od 0 do 11.
+#define TEST_DIGITS "0123456789:;"
+
+/** @brief Losuje kolejną liczbę generatorem xorshift.
+ * @param[in,out] seed – wskaźnik na stan generatora, różny od zera.
+ * @return Wylosowaną liczbę.
+ */
+unsigned long long testRandom(unsigned long long *seed);
+
+/** @brief Losuje numer.
+ * Numer ma długość od @p minLen do @p maxLen i składa się z pierwszych
+ * @p alpha znaków TEST_DIGITS.
+ * @param[in,out] seed – wskaźnik na stan generatora;
+ * @param[out] num     – bufor na co najmniej @p maxLen + 1 znaków;
+ * @param[in] minLen   – najmniejsza długość numeru;
+ * @param[in] maxLen   – największa długość numeru;
+ * @param[in] alpha    – liczba używanych cyfr, od 1 do 12.
+ */
+void testRandomNumber(unsigned long long *seed, char *num, size_t minLen, size_t maxLen, size_t alpha);
+
+/** @brief Sprawdza, że dwa ciągi numerów są takie same, i zwalnia je.
+ * @param[in] expected – ciąg oczekiwany;
+ * @param[in] pnum     – ciąg sprawdzany.
+ */
+void testAssertSame(struct PhoneNumbers const *expected, struct PhoneNumbers const *pnum);
+
+/** @brief Podaje czas zegara monotonicznego.
+ * @return Czas w milisekundach.
+ */
+double testNow(void);
+
+#endif /* _PHONE_FORWARD_TESTING_H */
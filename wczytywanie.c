@@ -1,3 +1,5 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdbool.h>
 #include <string.h>
@@ -24,7 +26,9 @@
  * @return Wczytany z wejścia znak.
  */
 static char getNextChar(bool *errorAppeared, bool error, int whereIsError, bool suddenError) {
-    int cInt = getchar();
+    // wejście czyta tylko główny wątek, więc znaki pobieramy bez blokowania
+    // strumienia, które po uruchomieniu wątku dziennika kosztuje przy każdym znaku.
+    int cInt = getchar_unlocked();
 
     // sprawdzamy, czy pobrany znak nie jest eofem.
     if (cInt == EOF) {
@@ -158,8 +162,9 @@ static Instruction * readIdentifier(char c, int *charCounter, bool *errorAppeare
         if (isComment || (*errorAppeared))
             break;
 
+        // podwajamy bufor, by długie leksemy nie wymagały wielu realokacji.
         if (i == n) {
-            instruct = realloc(instruct, (n + SIZE) * sizeof(char));
+            instruct = realloc(instruct, (2 * n) * sizeof(char));
 
             // gdyby wystąpiły problemy z alokacją pamięci.
             if (instruct == NULL) {
@@ -167,7 +172,7 @@ static Instruction * readIdentifier(char c, int *charCounter, bool *errorAppeare
                 return NULL;
             }
 
-            n += SIZE;
+            n *= 2;
         }
 
         if (c != '$') {
@@ -250,8 +255,9 @@ static Instruction * readNumber(char c, int *charCounter, bool *errorAppeared, b
         if (isComment || (*errorAppeared))
             break;
 
+        // podwajamy bufor, by długie leksemy nie wymagały wielu realokacji.
         if (i == n) {
-            instruct = realloc(instruct, (n + SIZE) * sizeof(char));
+            instruct = realloc(instruct, (2 * n) * sizeof(char));
 
             // gdyby wystąpiły problemy z alokacją pamięci.
             if (instruct == NULL) {
@@ -259,7 +265,7 @@ static Instruction * readNumber(char c, int *charCounter, bool *errorAppeared, b
                 return NULL;
             }
 
-            n += SIZE;
+            n *= 2;
         }
 
         if (c != '$') {